@@ -9,16 +9,20 @@
 
 // 算法模块：缩点
 #include "Condense.h"
+#include "Trace.h"
+#include <algorithm>
 #include <unordered_set>
 
 static long long key(int a,int b){ return ( (long long)a<<32 ) ^ (unsigned)b; }
 
-CondenseResult Condense::run(const Graph& g, const std::vector<int>& sccId, int sccCnt){
+CondenseResult Condense::run(const Graph& g, const std::vector<int>& sccId, int sccCnt, TaskControl* ctl){
+    TRACE_SCOPE("Condense::run");
     Graph dag(sccCnt);
     std::vector<Step> steps;
 
     std::unordered_set<long long> seen; // 去重 dag 边
     for(auto [u,v]: g.edges){
+        if(ctl && !ctl->tick()) break;
         int su = sccId[u], sv = sccId[v];
         if(su == sv) continue;
         long long k = key(su, sv);
@@ -31,3 +35,32 @@ CondenseResult Condense::run(const Graph& g, const std::vector<int>& sccId, int
 
     return {dag, steps};
 }
+
+DagComponents weakComponents(const Graph& g){
+    // 并查集：按边合并，再按点号顺序给每个集合编号。
+    std::vector<int> parent(g.n + 1);
+    for(int v = 0; v <= g.n; ++v) parent[v] = v;
+    auto find = [&parent](int v){
+        while(parent[v] != v){
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    for(int u = 1; u <= g.n; ++u){
+        for(int v : g.adj[u]){
+            int a = find(u), b = find(v);
+            if(a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    DagComponents res;
+    res.id.assign(g.n + 1, -1);
+    std::vector<int> rootId(g.n + 1, -1);
+    for(int v = 1; v <= g.n; ++v){
+        int r = find(v);
+        if(rootId[r] < 0) rootId[r] = res.count++;
+        res.id[v] = rootId[r];
+    }
+    return res;
+}
@@ -16,6 +16,7 @@
 #pragma once
 #include "Graph.h"
 #include "Steps.h"
+#include "TaskControl.h"
 #include <vector>
 
 
@@ -26,5 +27,14 @@ struct CondenseResult{
 
 class Condense {
 public:
-    CondenseResult run(const Graph& g, const std::vector<int>& sccId, int sccCnt);
+    // ctl 非空时可被取消/限时（每处理一条边记一次进度）。
+    CondenseResult run(const Graph& g, const std::vector<int>& sccId, int sccCnt, TaskControl* ctl = nullptr);
 };
+
+// 弱连通分量（忽略边的方向）：DAG 的各分量之间没有约束，拓扑序就是各分量拓扑序的任意交错，
+// 计数 / 解码可以按分量分开做（见 TopoRank）。
+struct DagComponents {
+    int count = 0;
+    std::vector<int> id;   // [v] = v 所在分量，0..count-1；按各分量最小的点从小到大编号
+};
+DagComponents weakComponents(const Graph& g);
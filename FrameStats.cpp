@@ -0,0 +1,92 @@
+/* ANNOTATED_FOR_STUDY
+@file FrameStats.cpp
+@brief 逐帧统计的环形缓冲、滚动直方图与 CSV 导出。
+*/
+
+#include "FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+
+const std::vector<double>& FrameStats::bucketEdges()
+{
+    static const std::vector<double> edges = {1, 2, 4, 8, 1000.0 / 60, 1000.0 / 30, 50, 100};
+    return edges;
+}
+
+void FrameStats::add(const FrameSample& s)
+{
+    if (mRing.size() < kCapacity) mRing.resize(kCapacity);
+    mRing[mHead] = s;
+    mHead = (mHead + 1) % kCapacity;
+    mCount = std::min(mCount + 1, kCapacity);
+}
+
+void FrameStats::clear()
+{
+    mHead = 0;
+    mCount = 0;
+}
+
+const FrameSample& FrameStats::latest() const
+{
+    static const FrameSample empty;
+    if (mCount == 0) return empty;
+    return mRing[(mHead + kCapacity - 1) % kCapacity];
+}
+
+FrameSample FrameStats::average() const
+{
+    FrameSample avg;
+    if (mCount == 0) return avg;
+    double restyled = 0, painted = 0;
+    for (std::size_t i = 0; i < mCount; ++i) {
+        const FrameSample& s = mRing[(mHead + kCapacity - 1 - i) % kCapacity];
+        avg.intervalMs += s.intervalMs;
+        avg.paintMs += s.paintMs;
+        avg.tickMs += s.tickMs;
+        restyled += s.restyled;
+        painted += s.painted;
+        avg.alpha += s.alpha;
+        avg.stepsPerSec += s.stepsPerSec;
+    }
+    const double k = 1.0 / double(mCount);
+    avg.intervalMs *= k;
+    avg.paintMs *= k;
+    avg.tickMs *= k;
+    avg.restyled = int(restyled * k + 0.5);
+    avg.painted = int(painted * k + 0.5);
+    avg.alpha *= k;
+    avg.stepsPerSec *= k;
+    return avg;
+}
+
+std::vector<int> FrameStats::histogram(double FrameSample::*field) const
+{
+    const std::vector<double>& edges = bucketEdges();
+    std::vector<int> h(edges.size() + 1, 0);
+    for (std::size_t i = 0; i < mCount; ++i) {
+        const double v = mRing[i].*field;
+        // 第一个上界 >= v 的桶；都小于 v 则落在最后一个桶。
+        const std::size_t b = std::size_t(std::lower_bound(edges.begin(), edges.end(), v) - edges.begin());
+        h[b]++;
+    }
+    return h;
+}
+
+bool FrameStats::writeCsv(std::ostream& out) const
+{
+    const std::vector<double>& edges = bucketEdges();
+    const std::vector<int> interval = histogram(&FrameSample::intervalMs);
+    const std::vector<int> paint = histogram(&FrameSample::paintMs);
+    const std::vector<int> tick = histogram(&FrameSample::tickMs);
+
+    out << "lo_ms,hi_ms,frame_interval,paint,force_tick\n";
+    char buf[64];
+    for (std::size_t b = 0; b <= edges.size(); ++b) {
+        const double lo = (b == 0) ? 0.0 : edges[b - 1];
+        if (b < edges.size()) std::snprintf(buf, sizeof(buf), "%.1f,%.1f", lo, edges[b]);
+        else std::snprintf(buf, sizeof(buf), "%.1f,", lo);
+        out << buf << ',' << interval[b] << ',' << paint[b] << ',' << tick[b] << '\n';
+    }
+    return bool(out);
+}
@@ -0,0 +1,52 @@
+/* ANNOTATED_FOR_STUDY
+@file FrameStats.h
+@brief 画布的逐帧统计：最近若干帧的帧间隔、绘制耗时、力导 tick 耗时等，外加滚动直方图与 CSV 导出。
+
+GraphView 每画完一帧记一条 FrameSample；浮层显示“最近一帧 + 窗口平均”，
+直方图按固定的毫秒分桶统计窗口内的帧数，导出成 CSV 就能比较不同渲染设置/不同版本。
+
+分桶上界（ms）：1, 2, 4, 8, 16.7(60FPS), 33.3(30FPS), 50, 100, 以及 >100。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+struct FrameSample {
+    double intervalMs = 0;     // 与上一帧的间隔（静止时会很长，落在最后一个桶）
+    double paintMs = 0;        // 本帧 QGraphicsView::paintEvent 的耗时
+    double tickMs = 0;         // 上一帧以来力导 tick 的总耗时
+    int restyled = 0;          // 上一帧以来被标记重绘（update()）的 item 数
+    int painted = 0;           // 本帧实际调用 paint() 的 item 数
+    double alpha = 0;          // 力导温度
+    double stepsPerSec = 0;    // 最近一秒应用的 Step 数
+};
+
+class FrameStats {
+public:
+    static constexpr std::size_t kCapacity = 600;   // 约 10 秒 @ 60FPS
+
+    // 分桶上界；最后一个桶没有上界。
+    static const std::vector<double>& bucketEdges();
+
+    void add(const FrameSample& s);
+    void clear();
+
+    std::size_t size() const { return mCount; }
+    const FrameSample& latest() const;       // size() == 0 时返回全 0
+    FrameSample average() const;             // 窗口内各字段的平均
+
+    // 窗口内某个耗时字段（&FrameSample::intervalMs 等）的直方图，长度 = bucketEdges().size() + 1。
+    std::vector<int> histogram(double FrameSample::*field) const;
+
+    // 表头：lo_ms,hi_ms,frame_interval,paint,force_tick；每行一个桶，值是帧数。
+    bool writeCsv(std::ostream& out) const;
+
+private:
+    std::vector<FrameSample> mRing;   // 环形缓冲，mHead 是下一条写入的位置
+    std::size_t mHead = 0;
+    std::size_t mCount = 0;
+};
@@ -5,45 +5,33 @@
 
 - 从“数据如何流动”开始：
   MainWindow 点击按钮 -> 运行算法生成 steps -> QTimer 一步步调用 view->applyStep(step)
-- applyStep() 只改状态，不直接画；最后统一 resetStyle()，这样回放确定、好 debug。
+- applyStep() 只改状态表(VisualState)，不直接画；受影响的 item 在 paint() 时按状态表现算外观，这样回放确定、好 debug。
 - 力导布局在 onForceTick()：可以把它理解为“每帧都做一次物理模拟”。
 */
 
 #include "GraphView.h"
+#include "Trace.h"
 #include <QPen>
 #include <QBrush>
 #include <QDebug>
 #include <QTimer>
 #include <QMouseEvent>
 #include <QColor>
-#include <QVariant>
 #include <QFrame>
+#include <QStyle>
+#include <QFontMetricsF>
+#include <QPaintEvent>
 
 namespace {
 /**
- * 可视化状态通过 setData()/data() 存储在每个 QGraphicsItem 上。
+ * 可视化状态集中存放在 GraphView::mVis（VisualState，struct-of-arrays）里，
+ * NodeItem/EdgeItem 只在 paint() 时读取。
  *
  * 原因：
- *  - 避免对 NodeItem/EdgeItem 的类定义做侵入式修改。
- *  - 保持算法与界面解耦：算法层只产出 Step 序列。
- *  - 允许随时调用 resetStyle() 进行确定性重绘。
+ *  - 回放热路径上不再有 QVariant 装箱/拆箱，也不再逐 item setBrush/setPen。
+ *  - 保持算法与界面解耦：算法层只产出 Step 序列，StepProgram 编译成 VisualOp，VisualState 执行。
+ *  - 状态表可以整体拷贝，重绘依然是确定性的“状态 -> 外观”投影。
  */
-constexpr int kRoleSccId     = 0x100;   // int：所属 SCC id，0 表示未分配
-constexpr int kRoleInStack   = 0x101;   // bool：Tarjan 栈成员标记（SCC 阶段）
-constexpr int kRoleActive    = 0x102;   // bool：当前 Step 的瞬时高亮
-
-// --- 拓扑排序（Kahn）相关的持久化 界面 状态 ---
-// 这些状态存到 item 的 data 里，而不是写进算法代码里，从而让 GraphView 仍然是可复用的
-// 渲染组件（工程上常见的“关注点分离”）。
-constexpr int kRoleTopoQueued = 0x110;  // bool：当前是否在 Kahn 队列中
-constexpr int kRoleTopoDone   = 0x111;  // bool：是否已出队/输出
-constexpr int kRoleTopoIndeg  = 0x112;  // int：当前入度值（用于刷新标签）
-
-// --- 边的瞬时高亮（仅当前 Step） ---
-constexpr int kRoleEdgeActive = 0x200;  // bool：当前 Step 高亮该边
-constexpr int kRoleEdgeU      = 0x201;  // int：起点节点 id（缓存到 EdgeItem）
-constexpr int kRoleEdgeV      = 0x202;  // int：终点节点 id（缓存到 EdgeItem）
-
 static QColor sccColor(int sccId) {
     // 使用 HSV 生成确定性的鲜艳调色板；重绘/重新布局时颜色保持稳定。
     const int hue = (sccId * 47) % 360;
@@ -62,16 +50,36 @@ static QColor blendColor(const QColor& base, const QColor& overlay, double t)
                   lerp(base.blue(),  overlay.blue()));
 }
 
-static void styleNode(NodeItem* node) {
-    if (!node) return;
+// 帧时间浮层用：本帧实际调用了 paint() 的 item 数（只在界面线程读写）。
+int gPaintedItems = 0;
+
+// 把作用域的耗时累加到 *acc（毫秒）；acc 为空时什么都不做。给有多个出口的函数计时用。
+class MsAccumulator {
+public:
+    explicit MsAccumulator(double* acc) : mAcc(acc) { if (mAcc) mClock.start(); }
+    ~MsAccumulator() { if (mAcc) *mAcc += mClock.nsecsElapsed() / 1e6; }
+    MsAccumulator(const MsAccumulator&) = delete;
+    MsAccumulator& operator=(const MsAccumulator&) = delete;
+private:
+    double* mAcc;
+    QElapsedTimer mClock;
+};
+
+} // namespace
 
-    const int  sccId    = node->data(kRoleSccId).toInt();
-    const bool inStack  = node->data(kRoleInStack).toBool();
-    const bool active   = node->data(kRoleActive).toBool();
+void NodeItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
+{
+    ++gPaintedItems;
+    const VisualState& vs = *m_vis;
+    const bool known = vs.valid(m_id);
+
+    const int  sccId    = known ? vs.sccId[m_id] : 0;
+    const bool inStack  = known && vs.has(m_id, VisualState::InStack);
+    const bool active   = known && vs.isActive(m_id);
 
     // 拓扑排序状态（仅在 DAG 模式/Topo 回放阶段使用）。
-    const bool queued   = node->data(kRoleTopoQueued).toBool();
-    const bool done     = node->data(kRoleTopoDone).toBool();
+    const bool queued   = known && vs.has(m_id, VisualState::Queued);
+    const bool done     = known && vs.has(m_id, VisualState::Done);
 
     // ---------- 填充色（持久状态） ----------
     QColor baseFill = (sccId > 0) ? sccColor(sccId) : QColor(Qt::white);
@@ -80,8 +88,7 @@ static void styleNode(NodeItem* node) {
     // done（已输出）需要与 queued（已入队/就绪）有明显区分。
     if (done)  baseFill = blendColor(baseFill, QColor(120, 200, 120), 0.35);
     if (queued) baseFill = blendColor(baseFill, QColor(100, 170, 255), 0.25);
-
-    node->setBrush(QBrush(baseFill));
+    if (m_picked) baseFill = QColor(255, 255, 200); // 加边模式选中的起点
 
     // ---------- 描边（瞬时优先级） ----------
     // 优先级：active(红) > inStack(橙) > done(绿) > queued(蓝) > 默认(黑)
@@ -95,15 +102,68 @@ static void styleNode(NodeItem* node) {
     } else if (queued) {
         pen = QPen(QColor(60, 120, 220), 3);
     }
-    node->setPen(pen);
+
+    painter->setPen(pen);
+    painter->setBrush(baseFill);
+    painter->drawEllipse(rect());
+
+    if (option->state & QStyle::State_Selected) {
+        painter->setPen(QPen(QColor(100, 116, 139), 1, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(rect().adjusted(-3, -3, 3, 3));
+    }
+
+    if (!known) return;
+
+    // 入度（节点下方）与输出序号（节点上方）直接画，不再挂子 item。
+    const QFontMetricsF fm(painter->font());
+    painter->setPen(Qt::black);
+    if (vs.has(m_id, VisualState::IndegShown)) {
+        const QString t = QString::number(vs.indeg[m_id]);
+        painter->drawText(QPointF(-fm.horizontalAdvance(t) / 2.0, m_r * 0.55 + fm.ascent()), t);
+    }
+    if (vs.order[m_id] > 0) {
+        const QString t = QString::number(vs.order[m_id]);
+        painter->drawText(QPointF(-fm.horizontalAdvance(t) / 2.0, -m_r - fm.height() * 0.2 + fm.ascent()), t);
+    }
 }
 
-} // namespace
+void EdgeItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*)
+{
+    ++gPaintedItems;
+    if (!m_valid) return;
+
+    // 边的样式策略：
+    //  - 活跃边：红色加粗
+    //  - 从“已输出节点”出发的边：淡化（帮助观察 Kahn 的 frontier）
+    const VisualState& vs = *m_vis;
+    const int u = m_from->id();
+    const bool active = (vs.activeEdge == m_id);
+    const bool fromDone = vs.valid(u) && vs.has(u, VisualState::Done);
+
+    QPen pen(Qt::black, 2);
+    if (active) {
+        pen = QPen(QColor(220, 40, 40), 4);
+    } else if (fromDone) {
+        pen = QPen(QColor(160, 160, 160), 2);
+    }
+
+    painter->setPen(pen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawLine(m_start, m_end);
+    const QPointF arrow[3] = { m_wing1, m_end, m_wing2 };
+    painter->drawPolyline(arrow, 3);
+}
 
 GraphView::GraphView(QWidget* parent)
     : QGraphicsView(parent)
 {
-    mScene = new QGraphicsScene(this);
+    for (SceneCache& c : mSlots) {
+        c.scene = new QGraphicsScene(this);
+        // 力导布局每帧都在移动几乎所有 item，BSP 索引的维护成本远高于它带来的查询收益。
+        c.scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    }
+    mScene = mSlots[int(mActiveSlot)].scene;
     setScene(mScene);
     connect(&mForceTimer, &QTimer::timeout, this, &GraphView::onForceTick);
     mForceTimer.setInterval(16); // 约 60FPS
@@ -117,29 +177,50 @@ GraphView::GraphView(QWidget* parent)
     setBackgroundBrush(QColor(248, 250, 252));
     setFrameShape(QFrame::NoFrame);
 
+    // 浮层打开后每 250ms 刷新一次（只重画浮层那块），画面静止时数字也会更新。
+    mOverlayTimer.setInterval(250);
+    connect(&mOverlayTimer, &QTimer::timeout, this, [this]() { viewport()->update(mOverlayRect); });
 }
 
-void GraphView::showGraph(const Graph& g, const QVector<QPointF>& pos)
+void GraphView::showGraph(const Graph& g, const QVector<QPointF>& pos, quint64 key)
 {
     // 保留旧接口，兼容性。
-    showGraphEx(g, pos, QStringList(), QVector<int>());
+    showGraphEx(g, pos, QStringList(), QVector<int>(), SceneSlot::Original, key);
 
 }
 
 void GraphView::showGraphEx(const Graph& g,
                             const QVector<QPointF>& pos,
                             const QStringList& labels,
-                            const QVector<int>& colorId)
+                            const QVector<int>& colorId,
+                            SceneSlot slot,
+                            quint64 key)
 {
+    TRACE_SCOPE("GraphView::showGraphEx");
     // 这里刻意选择“重建 场景”：
     //  - 避免在模式切换（原图 vs DAG）时做复杂的增量 diff。
     //  - 保证每次阶段切换后的状态是确定且可复现的。
+    // 只重建目标槽位；数据没变时调用方会先试 restoreScene()。
+    cancelEdgePick();
+    if (slot != mActiveSlot) {
+        stashActive();
+        activateSlot(slot);
+    }
+    mSlots[int(slot)].valid = true;
+    mSlots[int(slot)].key = key;
     mScene->clear();
-    nodeItem.clear();
-    edgeItem.clear();
+    mMovedNodes.clear();
+
+    // 稠密存储按本图规模一次性分配好。
+    mNodes.fill(nullptr, g.n + 1);
+    mForce.fill(QPointF(0, 0), g.n + 1);
+    mOutEdges.clear();
+    mOutEdges.resize(g.n + 1);
+    mEdges.clear();
+    mEdges.reserve((int)g.edges.size());
     mEdgeWeight.clear();
-    mIndegText.clear();
-    mOrderText.clear();
+    mEdgeWeight.reserve((int)g.edges.size());
+    resetVisual(g.n, colorId);
 
     const qreal R = 30.0;
     mNodeRadius = R;
@@ -148,22 +229,9 @@ void GraphView::showGraphEx(const Graph& g,
     for (int i = 1; i <= g.n; i++) {
         if (i <= 0 || i >= pos.size()) continue;
 
-        auto* node = new NodeItem(i, R);
-        node->setPen(QPen(Qt::black, 2));
+        auto* node = new NodeItem(i, R, &mVis);
         node->setPos(pos[i]);
 
-        // 初始化每个节点的可视化状态（role 数据）。
-        const int cid = (i < colorId.size()) ? colorId[i] : 0;
-        node->setData(kRoleSccId, cid);
-        node->setData(kRoleInStack, false);
-        node->setData(kRoleActive, false);
-
-        // Topo 相关 界面 状态始终初始化（即使本阶段暂时不用），
-        // 这样后续算法切换不会依赖“之前显示过什么”。
-        node->setData(kRoleTopoQueued, false);
-        node->setData(kRoleTopoDone, false);
-        node->setData(kRoleTopoIndeg, 0);
-
         // 标签作为子 item，跟随节点移动。
         const QString text = (i < labels.size() && !labels[i].isEmpty())
                                  ? labels[i]
@@ -173,7 +241,10 @@ void GraphView::showGraphEx(const Graph& g,
         label->setPos(-br.width() / 2.0, -br.height() / 2.0);
 
         mScene->addItem(node);
-        nodeItem[i] = node;
+        mNodes[i] = node;
+
+        // 点的位置变化只记账，相连边在帧末统一更新。
+        connect(node, &NodeItem::moved, this, [this, node]() { markNodeMoved(node); });
 
         // 用户交互后重新“加热”力导布局，让布局继续调整。
         connect(node, &NodeItem::dragStarted, this, [this]() { heatUp(1.0); });
@@ -183,23 +254,128 @@ void GraphView::showGraphEx(const Graph& g,
 
     // 2) 再创建边。
     for (auto [u, v] : g.edges) {
-        if (!nodeItem.contains(u) || !nodeItem.contains(v)) continue;
-        auto* e = new EdgeItem(nodeItem[u], nodeItem[v], R);
+        NodeItem* nu = node(u);
+        NodeItem* nv = node(v);
+        if (!nu || !nv) continue;
+        auto* e = new EdgeItem(mEdges.size(), nu, nv, R, &mVis);
         mScene->addItem(e);
-        edgeItem[{u, v}] = e;
-
-        // 在 EdgeItem 上缓存 (u,v)，以便样式/高亮无需额外外部映射。
-        e->setData(kRoleEdgeU, u);
-        e->setData(kRoleEdgeV, v);
-        e->setData(kRoleEdgeActive, false);
+        mOutEdges[u].push_back({v, (int)mEdges.size()});
+        mEdges.push_back(e);
+        nu->edges.push_back(e);
+        nv->edges.push_back(e);
 
-        mEdgeWeight[{u, v}] = 1.0; // 旧边初始强度=1（完全生效）。
+        mEdgeWeight.push_back(1.0); // 旧边初始强度=1（完全生效）。
     }
+    mEdgeDirty.fill(0, mEdges.size());
 
     // 3) 重新渲染所有 item（例如 SCC 调色板填充色）。
     resetStyle();
 
     // 4) View framing & force layout bootstrap.
+    refitScene();
+
+    // 重置仿真参数，让重建后的图能从干净状态“稳定下来”。
+    mAlpha = 1.0;
+    for (NodeItem* n : mNodes) {
+        if (n) n->vel = QPointF(0, 0);
+    }
+    if (mForceEnabled) startForceLayout();
+}
+
+void GraphView::resetVisual(int n, const QVector<int>& colorId)
+{
+    mNodeDirty.fill(0, n + 1);
+    mEdgeDirty.fill(0, mEdges.size());
+    mDirtyNodeIds.clear();
+    mDirtyEdgeIds.clear();
+    mTimeline.clear();
+
+    // 初始化可视化状态表。Topo 相关状态始终清零（即使本阶段暂时不用），
+    // 这样后续算法切换不会依赖“之前显示过什么”。
+    mVis.reset(n);
+    for (int i = 1; i <= n && i < colorId.size(); ++i) mVis.sccId[i] = colorId[i];
+}
+
+void GraphView::stashActive()
+{
+    // 没 flush 的点还挂着 moveQueued 标记，切回来以后就再也不会入队：先把边更新完。
+    flushEdgeUpdates();
+    stopForceLayout();
+
+    SceneCache& c = mSlots[int(mActiveSlot)];
+    c.nodes = std::move(mNodes);
+    c.edges = std::move(mEdges);
+    c.outEdges = std::move(mOutEdges);
+    c.edgeWeight = std::move(mEdgeWeight);
+    c.layoutMode = mLayoutMode;
+    c.alpha = mAlpha;
+    c.lastRect = lastRect;
+    c.layoutBounds = mLayoutBounds;
+}
+
+void GraphView::activateSlot(SceneSlot slot)
+{
+    SceneCache& c = mSlots[int(slot)];
+    mActiveSlot = slot;
+    mScene = c.scene;
+    setScene(mScene);
+
+    mNodes = std::move(c.nodes);
+    mEdges = std::move(c.edges);
+    mOutEdges = std::move(c.outEdges);
+    mEdgeWeight = std::move(c.edgeWeight);
+    mLayoutMode = c.layoutMode;
+    mAlpha = c.alpha;
+    lastRect = c.lastRect;
+    mLayoutBounds = c.layoutBounds;
+    mForce.fill(QPointF(0, 0), mNodes.size());
+}
+
+bool GraphView::restoreScene(SceneSlot slot, quint64 key, const QVector<int>& colorId)
+{
+    TRACE_SCOPE("GraphView::restoreScene");
+    const SceneCache& c = mSlots[int(slot)];
+    if (!c.valid || c.key != key) return false;
+
+    cancelEdgePick();
+    if (slot != mActiveSlot) {
+        stashActive();
+        activateSlot(slot);
+    }
+    resetVisual(mNodes.size() - 1, colorId);
+    resetStyle();
+
+    // 取景沿用离开时的范围；力导从离开时的温度接着跑（已经冷却的就不动）。
+    resetTransform();
+    QTimer::singleShot(0, this, [this]() {
+        if (!lastRect.isNull()) fitInView(lastRect, Qt::KeepAspectRatio);
+    });
+    for (NodeItem* n : mNodes) {
+        if (n) n->vel = QPointF(0, 0);
+    }
+    if (mForceEnabled && mAlpha >= mAlphaMin) startForceLayout();
+    return true;
+}
+
+void GraphView::setSceneKey(quint64 key)
+{
+    mSlots[int(mActiveSlot)].key = key;
+}
+
+void GraphView::dropScene(SceneSlot slot)
+{
+    SceneCache& c = mSlots[int(slot)];
+    if (slot == mActiveSlot || !c.valid) return;
+    c.valid = false;
+    c.nodes.clear();
+    c.edges.clear();
+    c.outEdges.clear();
+    c.edgeWeight.clear();
+    c.scene->clear();
+}
+
+void GraphView::refitScene()
+{
     QRectF rect = mScene->itemsBoundingRect();
     rect = rect.adjusted(-80, -80, 80, 80);
     mScene->setSceneRect(rect);
@@ -213,27 +389,54 @@ void GraphView::showGraphEx(const Graph& g,
 
     mLayoutBounds = mScene->itemsBoundingRect().adjusted(-200, -200, 200, 200);
     mScene->setSceneRect(mLayoutBounds);
+}
 
-    // 重置仿真参数，让重建后的图能从干净状态“稳定下来”。
-    mAlpha = 1.0;
-    for (auto it = nodeItem.begin(); it != nodeItem.end(); ++it) {
-        it.value()->vel = QPointF(0, 0);
+void GraphView::setLayoutMode(LayoutMode mode)
+{
+    if (mLayoutMode == mode) return;
+    mLayoutMode = mode;
+    if (mode == LayoutMode::Static) stopForceLayout();
+    else heatUp(1.0);
+}
+
+void GraphView::applyPositions(const QVector<QPointF>& pos, double settleAlpha)
+{
+    mInForceTick = true;
+    for (int i = 1; i < mNodes.size() && i < pos.size(); ++i) {
+        NodeItem* nd = mNodes[i];
+        if (!nd) continue;
+        nd->vel = QPointF(0, 0);
+        nd->setPos(pos[i]);
+    }
+    mInForceTick = false;
+    flushEdgeUpdates();
+    refitScene();
+
+    if (settleAlpha > 0 && mLayoutMode == LayoutMode::Force) {
+        mAlpha = settleAlpha;   // 直接设（不取 max）：布局已经基本排好，不要再“烧”一遍
+        if (mForceEnabled) startForceLayout();
     }
-    if (mForceEnabled) startForceLayout();
 }
 
 QVector<QPointF> GraphView::snapshotPositions(int n) const
 {
     QVector<QPointF> pos(n + 1);
     for (int i = 1; i <= n; ++i) {
-        // QMap::operator[] 不是 const 安全的；在 const 上下文用 value() 查询。
-        NodeItem* node = nodeItem.value(i, nullptr);
-        if (node) pos[i] = node->pos();
+        if (NodeItem* nd = node(i)) pos[i] = nd->pos();
     }
     return pos;
 
 }
 
+int GraphView::edgeId(int u, int v) const
+{
+    if (u < 1 || u >= mOutEdges.size()) return -1;
+    for (const auto& ve : mOutEdges[u]) {
+        if (ve.first == v) return ve.second;
+    }
+    return -1;
+}
+
 
 void GraphView::resizeEvent(QResizeEvent* event)
 {
@@ -243,201 +446,287 @@ void GraphView::resizeEvent(QResizeEvent* event)
     }
 }
 
-
-void GraphView::resetStyle()
+void GraphView::setOverlayEnabled(bool on)
 {
-    // 基于 item data 中存储的状态，确定性地重绘所有节点/边。
-    // 每次应用 Step 后都会调用该函数，从而保证回放过程是确定性的。
+    if (mOverlayEnabled == on) return;
+    mOverlayEnabled = on;
+    mTickMsSinceFrame = 0;
+    mRestyledSinceFrame = 0;
+    mStepsInWindow = 0;
+    mStepsPerSec = 0;
+    mFrameClock.invalidate();
+    if (on) {
+        mStepWindow.start();
+        mOverlayTimer.start();
+    } else {
+        mOverlayTimer.stop();
+        mOverlayRect = QRect();
+    }
+    viewport()->update();
+}
 
-    for (auto it = nodeItem.begin(); it != nodeItem.end(); ++it) {
-        styleNode(it.value());
+void GraphView::countSteps(int k)
+{
+    if (!mOverlayEnabled) return;
+    mStepsInWindow += k;
+    const qint64 ms = mStepWindow.elapsed();
+    if (ms >= 1000) {
+        mStepsPerSec = mStepsInWindow * 1000.0 / double(ms);
+        mStepsInWindow = 0;
+        mStepWindow.restart();
     }
+}
 
-    // 边的样式策略：
-    //  - 活跃边：红色加粗
-    //  - 从“已输出节点”出发的边：淡化（帮助观察 Kahn 的 frontier）
-    for (auto it = edgeItem.begin(); it != edgeItem.end(); ++it) {
-        const int u = it.key().first;
-        EdgeItem* e = it.value();
-        if (!e) continue;
-
-        const bool active = e->data(kRoleEdgeActive).toBool();
-        const bool fromDone = nodeItem.contains(u) ? nodeItem[u]->data(kRoleTopoDone).toBool() : false;
-
-        QPen pen(Qt::black, 2);
-        if (active) {
-            pen = QPen(QColor(220, 40, 40), 4);
-        } else if (fromDone) {
-            pen = QPen(QColor(160, 160, 160), 2);
-        }
-        e->setPen(pen);
+void GraphView::paintEvent(QPaintEvent* event)
+{
+    if (!mOverlayEnabled) {
+        QGraphicsView::paintEvent(event);
+        return;
     }
+
+    // 定时器只刷新浮层那一块时，这次绘制不算一帧（否则静止画面也会被记成 4FPS）。
+    const bool overlayOnly = !mOverlayRect.isEmpty() && mOverlayRect.contains(event->rect());
+    countSteps(0);
+    gPaintedItems = 0;
+    QElapsedTimer clock;
+    clock.start();
+    QGraphicsView::paintEvent(event);
+    if (overlayOnly) return;
+
+    FrameSample s;
+    s.paintMs = clock.nsecsElapsed() / 1e6;
+    s.intervalMs = mFrameClock.isValid() ? mFrameClock.nsecsElapsed() / 1e6 : 0.0;
+    s.tickMs = mTickMsSinceFrame;
+    s.restyled = mRestyledSinceFrame;
+    s.painted = gPaintedItems;
+    s.alpha = mAlpha;
+    s.stepsPerSec = mStepsPerSec;
+    mFrameStats.add(s);
+
+    mFrameClock.start();
+    mTickMsSinceFrame = 0;
+    mRestyledSinceFrame = 0;
 }
 
+void GraphView::drawForeground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (mOverlayEnabled) drawOverlay(painter);
+}
 
-void GraphView::applyStep(const Step& step)
+void GraphView::drawOverlay(QPainter* painter)
 {
-    // 将单个算法 Step 应用到场景（只改状态，不直接画）。
-    //
-    // 设计要点（工程化理由）：
-    //  - 算法层保持纯净且与 界面 解耦：只负责产出 Steps。
-    //  - GraphView 将可视化状态存放在 QGraphicsItem 的 setData()/data() 中。
-    //  - 每个 Step 只修改少量 role；随后 resetStyle() 做确定性重渲染。
+    // 浮层画在 viewport 坐标里，不随缩放/平移变化。
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    QFont f = font();
+    f.setPointSizeF(9);
+    painter->setFont(f);
+    const QFontMetrics fm(f);
+
+    const FrameSample& last = mFrameStats.latest();
+    const FrameSample avg = mFrameStats.average();
+    const double fps = avg.intervalMs > 0 ? 1000.0 / avg.intervalMs : 0.0;
+    const QStringList lines = {
+        tr("帧间隔 %1 ms（均 %2，约 %3 FPS）").arg(last.intervalMs, 0, 'f', 1).arg(avg.intervalMs, 0, 'f', 1).arg(fps, 0, 'f', 0),
+        tr("绘制 %1 ms（均 %2）").arg(last.paintMs, 0, 'f', 2).arg(avg.paintMs, 0, 'f', 2),
+        tr("力导 tick %1 ms（均 %2）").arg(last.tickMs, 0, 'f', 2).arg(avg.tickMs, 0, 'f', 2),
+        tr("标记重绘 %1 · 实际 paint %2").arg(last.restyled).arg(last.painted),
+        tr("alpha %1 · %2 步/秒").arg(mAlpha, 0, 'f', 3).arg(mStepsPerSec, 0, 'f', 0),
+    };
 
-    // 1) 清除上一帧的瞬时高亮（节点 + 边）。
-    for (auto it = nodeItem.begin(); it != nodeItem.end(); ++it) {
-        it.value()->setData(kRoleActive, false);
+    // 帧间隔直方图：每个桶一根柱子，柱高按窗口内最多的桶归一化。
+    static const char* const kBucketLabels[] = {"1", "2", "4", "8", "17", "33", "50", "100", ">"};
+    const std::vector<int> hist = mFrameStats.histogram(&FrameSample::intervalMs);
+    const int barW = 18, barGap = 2, barMaxH = 32;
+    const int histW = int(hist.size()) * (barW + barGap) - barGap;
+
+    const int pad = 8, lineH = fm.height();
+    int textW = histW;
+    for (const QString& l : lines) textW = std::max(textW, fm.horizontalAdvance(l));
+    const int h = pad + int(lines.size()) * lineH + 6 + barMaxH + lineH + pad;
+    mOverlayRect = QRect(8, 8, textW + 2 * pad, h);
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(15, 23, 42, 200));
+    painter->drawRect(mOverlayRect);
+
+    painter->setPen(QColor(226, 232, 240));
+    int y = mOverlayRect.top() + pad;
+    for (const QString& l : lines) {
+        painter->drawText(mOverlayRect.left() + pad, y + fm.ascent(), l);
+        y += lineH;
     }
-    for (auto it = edgeItem.begin(); it != edgeItem.end(); ++it) {
-        if (it.value()) it.value()->setData(kRoleEdgeActive, false);
+    y += 6;
+
+    const int maxCount = std::max(1, *std::max_element(hist.begin(), hist.end()));
+    int x = mOverlayRect.left() + pad;
+    for (int b = 0; b < (int)hist.size(); ++b) {
+        const int bh = hist[b] > 0 ? std::max(1, hist[b] * barMaxH / maxCount) : 0;
+        // 16.7ms（60FPS）以内绿色，33.3ms 以内黄色，更慢红色。
+        const QColor c = b <= 4 ? QColor(74, 222, 128) : (b == 5 ? QColor(250, 204, 21) : QColor(248, 113, 113));
+        painter->fillRect(QRect(x, y + barMaxH - bh, barW, bh), c);
+        const QString label = QString::fromLatin1(kBucketLabels[b]);
+        painter->drawText(x + (barW - fm.horizontalAdvance(label)) / 2, y + barMaxH + fm.ascent(), label);
+        x += barW + barGap;
     }
+    painter->restore();
+}
 
-    // 2) 特殊处理：重置可视化状态。
-    if (step.type == StepType::ResetVisual) {
-        const bool clearScc = (step.val != 0);
 
-        // 清理拓扑相关文本（入度/输出序号）。
-        for (auto it = mIndegText.begin(); it != mIndegText.end(); ++it) {
-            delete it.value();
-        }
-        mIndegText.clear();
+void GraphView::resetStyle()
+{
+    TRACE_SCOPE("GraphView::resetStyle");
+    // 外观是 mVis 的纯投影：让所有 item 重画一遍即可。
+    // 只在阶段切换（重建场景 / ResetVisual）时整体调用；逐步回放走 restyleDirty()。
+    for (NodeItem* n : mNodes) {
+        if (n) n->update();
+    }
+    for (EdgeItem* e : mEdges) {
+        e->update();
+    }
+    if (mOverlayEnabled) mRestyledSinceFrame += int(mNodes.size() - 1 + mEdges.size());
 
-        for (auto it = mOrderText.begin(); it != mOrderText.end(); ++it) {
-            delete it.value();
-        }
-        mOrderText.clear();
-        mTopoOrderIndex = 0;
+    // 全量重绘后，之前积攒的脏标记已无意义。
+    for (int id : mDirtyNodeIds) mNodeDirty[id] = 0;
+    for (int eid : mDirtyEdgeIds) mEdgeDirty[eid] = 0;
+    mDirtyNodeIds.clear();
+    mDirtyEdgeIds.clear();
+}
 
-        for (auto it = nodeItem.begin(); it != nodeItem.end(); ++it) {
-            NodeItem* node = it.value();
-            if (!node) continue;
+void GraphView::markNodeDirty(int id)
+{
+    if (id < 1 || id >= mNodeDirty.size() || mNodeDirty[id]) return;
+    mNodeDirty[id] = 1;
+    mDirtyNodeIds.push_back(id);
+}
 
-            node->setData(kRoleActive, false);
-            node->setData(kRoleInStack, false);
+void GraphView::markEdgeDirty(int eid)
+{
+    if (eid < 0 || eid >= mEdgeDirty.size() || mEdgeDirty[eid]) return;
+    mEdgeDirty[eid] = 1;
+    mDirtyEdgeIds.push_back(eid);
+}
 
-            // Topo 的持久化状态。
-            node->setData(kRoleTopoQueued, false);
-            node->setData(kRoleTopoDone, false);
-            node->setData(kRoleTopoIndeg, 0);
+void GraphView::markEffectDirty(const StepEffect& fx)
+{
+    for (int id : fx.nodes) markNodeDirty(id);
+    for (int eid : fx.edges) markEdgeDirty(eid);
+    // 出边的“淡化”取决于起点是否 done，这些边也要重绘。
+    if (fx.doneNode >= 1 && fx.doneNode < mOutEdges.size()) {
+        for (const auto& ve : mOutEdges[fx.doneNode]) markEdgeDirty(ve.second);
+    }
+}
 
-            if (clearScc) node->setData(kRoleSccId, 0);
-        }
+void GraphView::restyleDirty()
+{
+    if (mOverlayEnabled) mRestyledSinceFrame += int(mDirtyNodeIds.size() + mDirtyEdgeIds.size());
+    for (int id : mDirtyNodeIds) {
+        mNodeDirty[id] = 0;
+        if (mNodes[id]) mNodes[id]->update();
+    }
+    for (int eid : mDirtyEdgeIds) {
+        mEdgeDirty[eid] = 0;
+        mEdges[eid]->update();
+    }
+    mDirtyNodeIds.clear();
+    mDirtyEdgeIds.clear();
+}
 
-        for (auto it = edgeItem.begin(); it != edgeItem.end(); ++it) {
-            if (it.value()) it.value()->setData(kRoleEdgeActive, false);
-        }
 
+void GraphView::applyStep(const Step& step)
+{
+    // 将单个算法 Step 应用到场景（只改状态，不直接画）。
+    //
+    // 设计要点（工程化理由）：
+    //  - 算法层保持纯净且与 界面 解耦：只负责产出 Steps。
+    //  - Step 的语义由 StepProgram::compile 翻译成 VisualOp，这里只负责解析边编号和安排重绘。
+    //  - apply 报告本步影响到的 item（上一步高亮 + 本步改动），只 update() 这些，单步代价 O(1)
+    //    （出队时另加该点出边数）。
+    const int eid = (step.type == StepType::TopoIndegDec) ? edgeId(step.u, step.v) : -1;
+
+    // 状态被时间轴之外的操作改动，已装载的时间轴不再与 mVis 对应。
+    mTimeline.clear();
+
+    StepEffect fx;
+    mVis.apply(StepProgram::compile(step, mVis.n, eid), &fx);
+    refreshAfter(fx);
+    countSteps(1);
+}
+
+void GraphView::refreshAfter(const StepEffect& fx)
+{
+    if (fx.full) {
+        // ResetVisual / 关键帧还原 是整体替换，允许 O(n+m)。
         resetStyle();
         return;
     }
+    markEffectDirty(fx);
+    restyleDirty();
+}
 
-    NodeItem* nodeU = nodeItem.contains(step.u) ? nodeItem[step.u] : nullptr;
-    NodeItem* nodeV = nodeItem.contains(step.v) ? nodeItem[step.v] : nullptr;
-    EdgeItem* edgeUV = edgeItem.contains({step.u, step.v}) ? edgeItem[{step.u, step.v}] : nullptr;
-
-    auto ensureIndegText = [this](int id, NodeItem* node, int indeg) {
-        if (!node) return;
-        QGraphicsSimpleTextItem* t = mIndegText.value(id, nullptr);
-        if (!t) {
-            t = new QGraphicsSimpleTextItem(QString::number(indeg), node);
-            t->setZValue(2);
-            mIndegText[id] = t;
-        } else {
-            t->setText(QString::number(indeg));
-        }
-        QRectF br = t->boundingRect();
-        // 将入度文字放在节点下方并居中。
-        t->setPos(-br.width() / 2.0, mNodeRadius * 0.55);
-    };
-
-    auto ensureOrderText = [this](int id, NodeItem* node, int orderIdx) {
-        if (!node) return;
-        QGraphicsSimpleTextItem* t = mOrderText.value(id, nullptr);
-        if (!t) {
-            t = new QGraphicsSimpleTextItem(QString::number(orderIdx), node);
-            t->setZValue(2);
-            mOrderText[id] = t;
-        } else {
-            t->setText(QString::number(orderIdx));
-        }
-        QRectF br = t->boundingRect();
-        // 将输出序号放在节点上方并居中。
-        t->setPos(-br.width() / 2.0, -mNodeRadius - br.height() * 0.2);
-    };
+void GraphView::loadTimeline(const QVector<Step>& steps)
+{
+    // 针对当前场景编译一次（点校验、边编号、位掩码都在这里定下来），之后的回放只执行 op。
+    // 直接读 QVector 的连续存储，不再把整条 trace（连同每步的 QString）拷一份。
+    StepProgram program;
+    program.build(steps.constData(), std::size_t(steps.size()), mVis.n,
+                  [this](int u, int v) { return edgeId(u, v); });
+    mTimeline.load(std::move(program), mVis);
+}
 
-    switch (step.type) {
-    // --- SCC（Tarjan）阶段 ---
-    case StepType::Visit:
-        if (nodeU) nodeU->setData(kRoleActive, true);
-        break;
-    case StepType::PushStack:
-        if (nodeU) {
-            nodeU->setData(kRoleInStack, true);
-            nodeU->setData(kRoleActive, true);
-        }
-        break;
-    case StepType::PopStack:
-        if (nodeU) {
-            nodeU->setData(kRoleInStack, false);
-            nodeU->setData(kRoleActive, true);
-        }
-        break;
-    case StepType::AssignSCC:
-        if (nodeU) {
-            nodeU->setData(kRoleSccId, step.scc);
-            nodeU->setData(kRoleInStack, false);
-            nodeU->setData(kRoleActive, true);
-        }
-        break;
-
-    // --- 拓扑排序（Kahn）阶段 ---
-    case StepType::TopoInitIndeg:
-        if (nodeU) {
-            nodeU->setData(kRoleTopoIndeg, step.val);
-            ensureIndegText(step.u, nodeU, step.val);
-            nodeU->setData(kRoleActive, true);
-        }
-        break;
+void GraphView::loadTimeline(std::shared_ptr<StepSource> source)
+{
+    // 边要等取到那一步时才查；换场景时时间轴会被清掉，不会拿旧 source 去查新场景的边。
+    StepProgram program;
+    program.stream(std::move(source), mVis.n, [this](int u, int v) { return edgeId(u, v); });
+    mTimeline.load(std::move(program), mVis);
+}
 
-    case StepType::TopoEnqueue:
-        if (nodeU) {
-            nodeU->setData(kRoleTopoQueued, true);
-            nodeU->setData(kRoleActive, true);
-        }
-        break;
+bool GraphView::branchTimeline(int pos, std::shared_ptr<StepSource> source)
+{
+    if (mTimeline.empty() || pos < 0 || pos > mTimeline.built()) return false;
+    timelineSeek(pos);
+    mTimeline.branch(std::move(source));
+    return true;
+}
 
-    case StepType::TopoDequeue:
-        if (nodeU) {
-            nodeU->setData(kRoleTopoQueued, false);
-            nodeU->setData(kRoleTopoDone, true);
-            nodeU->setData(kRoleActive, true);
+void GraphView::clearTimeline()
+{
+    mTimeline.clear();
+}
 
-            // 给节点分配输出序号（从 1 开始）。
-            mTopoOrderIndex++;
-            ensureOrderText(step.u, nodeU, mTopoOrderIndex);
-        }
-        break;
-
-    case StepType::TopoIndegDec:
-        // 高亮当前处理的边 (u -> v)，并更新 v 的入度显示。
-        if (edgeUV) edgeUV->setData(kRoleEdgeActive, true);
-        if (nodeV) {
-            nodeV->setData(kRoleTopoIndeg, step.val);
-            ensureIndegText(step.v, nodeV, step.val);
-            nodeV->setData(kRoleActive, true);
-        }
-        if (nodeU) nodeU->setData(kRoleActive, true);
-        break;
+bool GraphView::timelineForward()
+{
+    StepEffect fx;
+    if (!mTimeline.stepForward(mVis, &fx)) return false;
+    refreshAfter(fx);
+    countSteps(1);
+    return true;
+}
 
-    default:
-        // 本里程碑暂不处理；保留为空操作，便于后续扩展并保持向前兼容。
-        break;
-    }
+bool GraphView::timelineBackward()
+{
+    StepEffect fx;
+    if (!mTimeline.stepBackward(mVis, &fx)) return false;
+    refreshAfter(fx);
+    countSteps(1);
+    return true;
+}
 
-    resetStyle();
+void GraphView::timelineSeek(int pos)
+{
+    // 近距离跳转逐步累积脏集合；远距离跳转（关键帧还原）直接全量重绘。
+    const int from = mTimeline.position();
+    const bool full = mTimeline.seek(mVis, pos, [this](const StepEffect& fx) { markEffectDirty(fx); });
+    if (full) resetStyle();
+    else restyleDirty();
+    countSteps(std::abs(mTimeline.position() - from));
 }
 
 void GraphView::startForceLayout() {
+    if (mLayoutMode != LayoutMode::Force) return;
     if (!mForceTimer.isActive()) mForceTimer.start();
 }
 
@@ -450,9 +739,50 @@ void GraphView::setForceEnabled(bool on) {
     if (on) startForceLayout();
     else stopForceLayout();
 }
+void GraphView::markNodeMoved(NodeItem* node)
+{
+    if (!node->moveQueued) {
+        node->moveQueued = true;
+        mMovedNodes.push_back(node);
+    }
+    // 力导 tick 内的移动由 tick 末尾统一 flush；其它来源（拖拽等）推迟到下一轮事件循环。
+    if (!mInForceTick && !mEdgeFlushQueued) {
+        mEdgeFlushQueued = true;
+        QTimer::singleShot(0, this, &GraphView::flushEdgeUpdates);
+    }
+}
+
+void GraphView::flushEdgeUpdates()
+{
+    mEdgeFlushQueued = false;
+    if (mMovedNodes.isEmpty()) return;
+    TRACE_SCOPE("GraphView::flushEdgeUpdates");
+
+    // 先去重收集：一条边两端都动了也只算一次。
+    mDirtyEdges.clear();
+    for (NodeItem* n : mMovedNodes) {
+        n->moveQueued = false;
+        for (EdgeItem* e : n->edges) {
+            if (e->updateQueued) continue;
+            e->updateQueued = true;
+            mDirtyEdges.push_back(e);
+        }
+    }
+    mMovedNodes.clear();
+
+    for (EdgeItem* e : mDirtyEdges) {
+        e->updateQueued = false;
+        e->updatePath();
+    }
+    mDirtyEdges.clear();
+}
+
 void GraphView::onForceTick()
 {
-    if (!mScene || nodeItem.isEmpty()) return;
+    TRACE_SCOPE("GraphView::onForceTick");
+    MsAccumulator tickClock(mOverlayEnabled ? &mTickMsSinceFrame : nullptr);
+    const int n = mNodes.size() - 1;
+    if (!mScene || n <= 0) return;
 
     // 冷却系数
     mAlpha *= (1.0 - mAlphaDecay);
@@ -461,24 +791,22 @@ void GraphView::onForceTick()
         return;
     }
 
-    QMap<int, QPointF> force;
-    for (auto it = nodeItem.begin(); it != nodeItem.end(); ++it)
-        force[it.key()] = QPointF(0, 0);
-
-    QList<int> ids = nodeItem.keys();
+    // 受力缓冲区是成员，按节点编号直接下标访问；每帧只清零不分配。
+    QPointF* force = mForce.data();
+    std::fill(force, force + n + 1, QPointF(0, 0));
 
     // 每 tick 让新边权重更接近 1（让新边更顺滑）
-    for (auto it = mEdgeWeight.begin(); it != mEdgeWeight.end(); ++it) {
-        it.value() = std::min(1.0, it.value() + 0.08);
+    for (double& w : mEdgeWeight) {
+        w = std::min(1.0, w + 0.08);
     }
 
     // 2) 点-点排斥 + 防重叠
-    for (int a = 0; a < ids.size(); ++a) {
-        for (int b = a + 1; b < ids.size(); ++b) {
-            int i = ids[a], j = ids[b];
-            NodeItem* ni = nodeItem[i];
-            NodeItem* nj = nodeItem[j];
-            if (!ni || !nj) continue;
+    for (int i = 1; i <= n; ++i) {
+        NodeItem* ni = mNodes[i];
+        if (!ni) continue;
+        for (int j = i + 1; j <= n; ++j) {
+            NodeItem* nj = mNodes[j];
+            if (!nj) continue;
 
             QPointF d = ni->pos() - nj->pos();
             double dx = d.x(), dy = d.y();
@@ -502,14 +830,12 @@ void GraphView::onForceTick()
     }
 
     // 3) 边弹簧
-    for (auto it = edgeItem.begin(); it != edgeItem.end(); ++it) {
-        int u = it.key().first;
-        int v = it.key().second;
-        if (!nodeItem.contains(u) || !nodeItem.contains(v)) continue;
-
-        NodeItem* nu = nodeItem[u];
-        NodeItem* nv = nodeItem[v];
-        if (!nu || !nv) continue;
+    for (int eid = 0; eid < mEdges.size(); ++eid) {
+        EdgeItem* e = mEdges[eid];
+        NodeItem* nu = e->from();
+        NodeItem* nv = e->to();
+        const int u = nu->id();
+        const int v = nv->id();
 
         QPointF d = nv->pos() - nu->pos();
         double dx = d.x(), dy = d.y();
@@ -518,7 +844,7 @@ void GraphView::onForceTick()
 
         QPointF dir = d / dist;
         double stretch = dist - mRestLen;
-        double w = mEdgeWeight.value({u, v}, 1.0);
+        double w = mEdgeWeight[eid];
         QPointF f = dir * (mSpringK * w * stretch);
 
         force[u] += f;
@@ -527,39 +853,40 @@ void GraphView::onForceTick()
 
     // 4) 向中心轻微拉力
     QPointF center = mScene->sceneRect().center();
-    for (int id : ids) {
-        NodeItem* n = nodeItem[id];
-        if (!n) continue;
-        force[id] += (center - n->pos()) * mCenterPull;
+    for (int id = 1; id <= n; ++id) {
+        NodeItem* nd = mNodes[id];
+        if (!nd) continue;
+        force[id] += (center - nd->pos()) * mCenterPull;
     }
 
     // 乘上 alpha：越到后面越“冷”
-    for (int id : ids) force[id] *= mAlpha;
+    for (int id = 1; id <= n; ++id) force[id] *= mAlpha;
 
     QGraphicsItem* grabbed = mScene->mouseGrabberItem();
 
-    for (int id : ids) {
-        NodeItem* n = nodeItem[id];
-        if (!n) continue;
+    mInForceTick = true;
+    for (int id = 1; id <= n; ++id) {
+        NodeItem* nd = mNodes[id];
+        if (!nd) continue;
 
         bool dragging = false;
-        if (grabbed) dragging = (grabbed == n) || (grabbed->parentItem() == n);
+        if (grabbed) dragging = (grabbed == nd) || (grabbed->parentItem() == nd);
 
         // 拖拽时临时固定；pin 的点永久固定
-        if (n->pinned() || dragging) {
-            n->vel = QPointF(0,0);
+        if (nd->pinned() || dragging) {
+            nd->vel = QPointF(0,0);
             continue;
         }
 
         // 速度更新（保留 dt 用一次就够）
-        n->vel = (n->vel + force[id] * mDt) * mDamping;
+        nd->vel = (nd->vel + force[id] * mDt) * mDamping;
 
         // 限速
-        double sp = std::hypot(n->vel.x(), n->vel.y());
-        if (sp > mMaxSpeed) n->vel *= (mMaxSpeed / sp);
+        double sp = std::hypot(nd->vel.x(), nd->vel.y());
+        if (sp > mMaxSpeed) nd->vel *= (mMaxSpeed / sp);
 
         // 关键：位移不要再乘 dt（否则太慢）
-        QPointF np = n->pos() + n->vel;
+        QPointF np = nd->pos() + nd->vel;
 
         // 边界约束
         const double margin = 40.0;
@@ -567,25 +894,31 @@ void GraphView::onForceTick()
         np.setX(std::min(r.right()  - margin, std::max(r.left() + margin, np.x())));
         np.setY(std::min(r.bottom() - margin, std::max(r.top()  + margin, np.y())));
 
-        n->setPos(np);
+        nd->setPos(np);
     }
+    mInForceTick = false;
+
+    // 本帧所有点都挪完了，再统一更新边。
+    flushEdgeUpdates();
 }
 
 bool GraphView::addEdge(int u, int v)
 {
     if (!mScene) return false;
-    if (!nodeItem.contains(u) || !nodeItem.contains(v)) return false;
-    if (edgeItem.contains({u, v})) return false;
+    NodeItem* nu = node(u);
+    NodeItem* nv = node(v);
+    if (!nu || !nv) return false;
+    if (edgeId(u, v) >= 0) return false;
 
-    auto* e = new EdgeItem(nodeItem[u], nodeItem[v], mNodeRadius);
+    auto* e = new EdgeItem(mEdges.size(), nu, nv, mNodeRadius, &mVis);
     mScene->addItem(e);
-    edgeItem[{u, v}] = e;
+    mOutEdges[u].push_back({v, (int)mEdges.size()});
+    mEdges.push_back(e);
+    nu->edges.push_back(e);
+    nv->edges.push_back(e);
 
-    e->setData(kRoleEdgeU, u);
-    e->setData(kRoleEdgeV, v);
-    e->setData(kRoleEdgeActive, false);
-
-    mEdgeWeight[{u, v}] = 0.0;  // 新边从 0 开始慢慢增强
+    mEdgeWeight.push_back(0.0); // 新边从 0 开始慢慢增强
+    mEdgeDirty.push_back(0);
     heatUp(1.0);                // reheat
     startForceLayout();         // 确保 timer 在跑
     return true;
@@ -608,9 +941,7 @@ void GraphView::mousePressEvent(QMouseEvent* event)
 
         // 点空白：取消
         if (!node) {
-            if (mEdgeFromNode) mEdgeFromNode->setBrush(QBrush(Qt::white));
-            mEdgeFrom = -1; mEdgeFromNode = nullptr;
-            if (mPreviewLine) { delete mPreviewLine; mPreviewLine = nullptr; }
+            cancelEdgePick();
             event->accept();
             return;
         }
@@ -619,7 +950,7 @@ void GraphView::mousePressEvent(QMouseEvent* event)
             // 选起点
             mEdgeFrom = node->id();
             mEdgeFromNode = node;
-            mEdgeFromNode->setBrush(QBrush(QColor(255, 255, 200))); // 高亮一下
+            mEdgeFromNode->setPicked(true); // 高亮一下
 
             if (!mPreviewLine) {
                 mPreviewLine = mScene->addLine(QLineF(node->pos(), node->pos()),
@@ -633,10 +964,7 @@ void GraphView::mousePressEvent(QMouseEvent* event)
             int from = mEdgeFrom;
             int to = node->id();
 
-            if (mEdgeFromNode) mEdgeFromNode->setBrush(QBrush(Qt::white));
-            mEdgeFrom = -1; mEdgeFromNode = nullptr;
-
-            if (mPreviewLine) { delete mPreviewLine; mPreviewLine = nullptr; }
+            cancelEdgePick();
 
             if (from != to) emit edgeRequested(from, to);
         }
@@ -661,9 +989,14 @@ void GraphView::mouseMoveEvent(QMouseEvent* event)
 void GraphView::leaveEvent(QEvent* event)
 {
     // 鼠标离开视图就取消预览
-    if (mEdgeFromNode) mEdgeFromNode->setBrush(QBrush(Qt::white));
-    mEdgeFrom = -1; mEdgeFromNode = nullptr;
-    if (mPreviewLine) { delete mPreviewLine; mPreviewLine = nullptr; }
+    cancelEdgePick();
 
     QGraphicsView::leaveEvent(event);
 }
+
+void GraphView::cancelEdgePick()
+{
+    if (mEdgeFromNode) mEdgeFromNode->setPicked(false);
+    mEdgeFrom = -1; mEdgeFromNode = nullptr;
+    if (mPreviewLine) { delete mPreviewLine; mPreviewLine = nullptr; }
+}
@@ -7,9 +7,11 @@
 - item 天生支持拖拽、选择、事件分发、Z 值(层级)、父子关系（文字跟着节点走）。
 
 可以把 GraphView 分成 3 件事：
-1) showGraphEx(): 把某一张图(原图 / DAG)投影到场景里（重建节点/边 item）
+1) showGraphEx(): 把某一张图(原图 / DAG)投影到场景里（重建节点/边 item）；
+   原图和 DAG 各占一个场景槽位，restoreScene() 直接换回没过期的那套 item，不必重建
 2) 力导布局(ForceLayout): QTimer 每 16ms tick 一次，算力并更新坐标，让图“灵动”
-3) applyStep(): 接收算法产生的 Step，修改每个 item 的 data(role)，然后 resetStyle() 重绘样式
+3) applyStep(): 接收算法产生的 Step，写入 VisualState 状态表，只让受影响的 item update()；
+   NodeItem/EdgeItem 在 paint() 时按状态表现算颜色
 
 NodeItem / EdgeItem 为什么写在 .h 里？
 - 课程项目规模不大，把它们作为 GraphView 的“内部小组件”放在一个文件里更好找。
@@ -24,7 +26,6 @@ NodeItem / EdgeItem 为什么写在 .h 里？
 #include <QGraphicsScene>
 #include <QGraphicsEllipseItem>
 #include <QGraphicsTextItem>
-#include <QMap>
 #include <QVector>
 #include <QPointF>
 
@@ -36,9 +37,17 @@ NodeItem / EdgeItem 为什么写在 .h 里？
 #include <algorithm>
 #include <QGraphicsRectItem>
 #include <QStringList>
+#include <QPainter>
+#include <QPainterPath>
+#include <QStyleOptionGraphicsItem>
 
 #include "Graph.h"
 #include "Steps.h"
+#include "VisualState.h"
+#include "Timeline.h"
+#include <memory>
+#include "FrameStats.h"
+#include <QElapsedTimer>
 
 // 前向声明
 class NodeItem;
@@ -47,9 +56,14 @@ class EdgeItem;
 class GraphView : public QGraphicsView {
     Q_OBJECT
 public:
+    // Force：力导布局持续迭代；Static：坐标由外部一次算好（如 DAG 的分层布局），不跑力导。
+    enum class LayoutMode { Force, Static };
+    // 场景槽位：原图与 DAG 各有一个 QGraphicsScene 和一套 item，来回切换只换场景。
+    enum class SceneSlot { Original = 0, Dag = 1 };
+
     explicit GraphView(QWidget* parent = nullptr);
 
-    void showGraph(const Graph& g, const QVector<QPointF>& pos); // pos[1..n]
+    void showGraph(const Graph& g, const QVector<QPointF>& pos, quint64 key = 0); // pos[1..n]，原图槽位
 
     /**
      * @brief showGraphEx 根据图结构与坐标重建场景，可选传入标签/颜色分组。
@@ -65,11 +79,25 @@ public:
      * @param labels    可选节点标签（labels[1..n]）。为空时使用数字标签。
      * @param colorId   可选的“持久颜色分组 id”（colorId[1..n]）。
      *                 提供后将按该 id 使用 SCC 调色板进行填充。
+     * @param slot      重建到哪个场景槽位（另一个槽位的缓存保持不动）。
+     * @param key       这套 item 对应的数据版本，之后 restoreScene() 用它判断缓存是否过期。
      */
     void showGraphEx(const Graph& g,
                      const QVector<QPointF>& pos,
                      const QStringList& labels,
-                     const QVector<int>& colorId);
+                     const QVector<int>& colorId,
+                     SceneSlot slot = SceneSlot::Original,
+                     quint64 key = 0);
+
+    /**
+     * @brief restoreScene 槽位里缓存的场景仍是 key 这一版时，直接切过去（坐标保持上次离开时的样子），
+     * 可视化状态按 colorId 重置，与 showGraphEx 的结果一致；没有可用缓存时返回 false，调用方走 showGraphEx。
+     * 切换代价是 O(n + m) 次 update()，不再新建/销毁任何 item。
+     */
+    bool restoreScene(SceneSlot slot, quint64 key, const QVector<int>& colorId);
+    void setSceneKey(quint64 key);     // 当前场景被增量修改（如 addEdge）后，更新它对应的版本
+    void dropScene(SceneSlot slot);    // 丢弃不在显示的槽位里的缓存（数据已变，留着只占内存）
+    SceneSlot activeSlot() const { return mActiveSlot; }
 
     /**
      * @brief snapshotPositions 抓取当前布局下 N 个节点的坐标。
@@ -78,10 +106,46 @@ public:
      * 使缩点后的图从更自然的位置开始显示。
      */
     QVector<QPointF> snapshotPositions(int n) const;
+
+    void setLayoutMode(LayoutMode mode);
+    LayoutMode layoutMode() const { return mLayoutMode; }
+
+    /**
+     * @brief applyPositions 一次性把所有节点挪到 pos[1..n]（后台算好的布局结果）。
+     * 移动期间只记账，最后统一更新一次边并重新取景，不会每挪一个点就重算一遍相连的边。
+     * settleAlpha > 0 且处于力导模式时，以这个（较低的）温度继续力导，只做微调。
+     */
+    void applyPositions(const QVector<QPointF>& pos, double settleAlpha = 0.0);
     void resetStyle();
+    // 直接应用单个 Step（如 ResetVisual）。会使已装载的时间轴失效。
     void applyStep(const Step& step);
+
+    /**
+     * 时间轴回放：以当前可视化状态为起点装载整条 trace，之后可前进/后退/任意跳转。
+     * 跳转代价受关键帧间隔约束，与 trace 总长无关（见 Timeline.h）。
+     */
+    void loadTimeline(const QVector<Step>& steps);
+    // 流式：不预先编译，播到哪儿才从 source（算法状态机）取步到哪儿，开播无需等整条 trace。
+    void loadTimeline(std::shared_ptr<StepSource> source);
+    // 沿用已装载时间轴的前 pos 步，跳到那里后改接 source（从第 pos 步往后产出）。
+    // 调用方保证前 pos 步与新 trace 相同；还没播到过 pos 时返回 false，什么都不做。
+    bool branchTimeline(int pos, std::shared_ptr<StepSource> source);
+    void clearTimeline();
+    const Timeline& timeline() const { return mTimeline; }
+    bool timelineForward();
+    bool timelineBackward();
+    void timelineSeek(int pos);
     bool addEdge(int u, int v);          // 动态加边（只改视图）
     void setEdgeEditMode(bool on) { mEdgeEditMode = on; } // 可选项：面板勾选后不需按Shift
+
+    /**
+     * 帧时间浮层：左上角显示帧间隔/绘制耗时/力导 tick 耗时、每帧重绘与实际 paint 的 item 数、
+     * 当前 mAlpha、每秒应用的 Step 数，以及帧间隔的滚动直方图。关闭时只剩几个整数自增。
+     */
+    void setOverlayEnabled(bool on);
+    bool overlayEnabled() const { return mOverlayEnabled; }
+    const FrameStats& frameStats() const { return mFrameStats; }
+    void clearFrameStats() { mFrameStats.clear(); }
 signals:
     void edgeRequested(int u, int v);
 public slots:
@@ -93,17 +157,48 @@ protected:
     void mouseMoveEvent(QMouseEvent* event) override;
     void leaveEvent(QEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    void drawForeground(QPainter* painter, const QRectF& rect) override;
 private slots:
     void onForceTick();
+    void flushEdgeUpdates(); // 每帧一次：只重算端点移动过的边
 private:
-    QGraphicsScene* mScene = nullptr;
-    QMap<int, NodeItem*> nodeItem;
-    QMap<QPair<int,int>, class EdgeItem*> edgeItem;
+    QGraphicsScene* mScene = nullptr;   // 当前槽位的场景（即 mSlots[mActiveSlot].scene）
+
+    // 不在显示的槽位把自己的 item 表存在这里；当前槽位的表在下面的成员里（只有 key/valid 用这里的）。
+    struct SceneCache {
+        QGraphicsScene* scene = nullptr;
+        bool valid = false;
+        quint64 key = 0;
+        QVector<NodeItem*> nodes;
+        QVector<EdgeItem*> edges;
+        QVector<QVector<QPair<int,int>>> outEdges;
+        QVector<double> edgeWeight;
+        LayoutMode layoutMode = LayoutMode::Force;
+        double alpha = 0;
+        QRectF lastRect, layoutBounds;
+    };
+    SceneCache mSlots[2];
+    SceneSlot mActiveSlot = SceneSlot::Original;
+    void stashActive();                 // 当前槽位的 item 表和力导状态存回 mSlots
+    void activateSlot(SceneSlot slot);  // 从 mSlots 取回，并把它的场景挂到视图上
+    void resetVisual(int n, const QVector<int>& colorId);   // 状态表、脏标记、时间轴按 n 个点重置
+
+    // --- 稠密下标的 item 存储 ---
+    // 节点编号本来就是 1..n，直接用数组下标；边按插入顺序分配 edgeId = 0..m-1。
+    // (u,v) -> edgeId 通过 mOutEdges[u] 的出边表线性查找（出度通常很小），不再走 QMap 的树查找。
+    QVector<NodeItem*> mNodes;                     // [1..n]，下标 0 不用
+    QVector<EdgeItem*> mEdges;                     // [edgeId]
+    QVector<QVector<QPair<int,int>>> mOutEdges;    // [u] -> {(v, edgeId)}
+    int edgeId(int u, int v) const;                // 不存在返回 -1
+    NodeItem* node(int id) const { return (id >= 1 && id < mNodes.size()) ? mNodes[id] : nullptr; }
+    EdgeItem* edge(int u, int v) const { const int e = edgeId(u, v); return e >= 0 ? mEdges[e] : nullptr; }
 
     QRectF lastRect;
 
     QTimer mForceTimer;
     bool mForceEnabled = true;
+    LayoutMode mLayoutMode = LayoutMode::Force;
 
     // Force 参数（默认值先用这套，之后可以做成 界面 可调）
     // 如果抖/乱飞：减小 mDt 或减小 mRepulsion；如果挤在一起：增大 mRepulsion 或 mCollisionK。
@@ -126,39 +221,71 @@ private:
 
     void heatUp(double a = 1.0) {
         mAlpha = std::max(mAlpha, a);
-        if (mForceEnabled && !mForceTimer.isActive()) mForceTimer.start();
+        if (mForceEnabled && mLayoutMode == LayoutMode::Force && !mForceTimer.isActive()) mForceTimer.start();
     }
     bool mEdgeEditMode = false;          // true=一直处于加边模式；false=按Shift才加边
     int mEdgeFrom = -1;
     NodeItem* mEdgeFromNode = nullptr;
     QGraphicsLineItem* mPreviewLine = nullptr;
+    // 取消加边预览。清空/切换场景前必须先调，否则 mPreviewLine / mEdgeFromNode 会指向已删除或别的场景里的 item。
+    void cancelEdgePick();
 
-    QMap<QPair<int,int>, double> mEdgeWeight; // 新边弹簧权重 0..1（更顺滑）
+    QVector<double> mEdgeWeight;  // [edgeId] 新边弹簧权重 0..1（更顺滑）
+    QVector<QPointF> mForce;      // [1..n] 力导 tick 的受力缓冲区，跨帧复用避免分配
 
     QGraphicsRectItem* mArenaItem = nullptr;
     int mNodeCountHint = 0;
 
+    void refitScene();               // 按当前 item 范围重设场景与取景
     void updateArena(int n);
     void clampNodeToArena(NodeItem* n);
 
-    // --- Step 回放相关的可视化状态 ---
-    int mActiveNode = -1;
-    QPair<int,int> mActiveEdge = {-1, -1};
-    int mTopoOrderIndex = 0;
-
-    QMap<int, QBrush> mBaseBrush;
-    QMap<int, QPen>   mBasePen;
-    QMap<QPair<int,int>, QPen> mBaseEdgePen;
+    // --- 边路径的每帧批量更新 ---
+    // 点的 moved 信号只负责“记账”，真正的 updatePath 在帧末（力导 tick 结束 / 拖拽后的下一轮事件循环）统一做。
+    QVector<NodeItem*> mMovedNodes;
+    QVector<EdgeItem*> mDirtyEdges;   // flush 时复用的缓冲区
+    bool mEdgeFlushQueued = false;
+    bool mInForceTick = false;        // 力导 tick / applyPositions 批量移动期间为 true
+    void markNodeMoved(NodeItem* node);
 
-    QMap<int, QGraphicsSimpleTextItem*> mIndegText;   // 入度显示
-    QMap<int, QGraphicsSimpleTextItem*> mOrderText;   // 拓扑输出序号显示
+    // --- Step 回放相关的可视化状态 ---
+    // 状态表归 GraphView 所有；item 只持有它的 const 指针，paint() 时读取。
+    VisualState mVis;
+    Timeline mTimeline;   // 与 mVis 同步：mVis 恒为“已执行 mTimeline.position() 步”的状态
+
+    // 增量重绘：StepEffect 报告的点/边记入脏集合，applyStep 末尾只 update() 这些 item，
+    // 回放单步不再是 O(n+m)。
+    QVector<char> mNodeDirty;      // [1..n]
+    QVector<char> mEdgeDirty;      // [edgeId]
+    QVector<int>  mDirtyNodeIds;
+    QVector<int>  mDirtyEdgeIds;
+    void markNodeDirty(int id);
+    void markEdgeDirty(int eid);
+    void markEffectDirty(const StepEffect& fx);
+    void restyleDirty();
+    void refreshAfter(const StepEffect& fx);
+
+    // --- 帧时间浮层 ---
+    // 计数在两次 paintEvent 之间累加，paintEvent 结束时打包成一条 FrameSample。
+    bool mOverlayEnabled = false;
+    FrameStats mFrameStats;
+    QTimer mOverlayTimer;            // 静止时也定期刷新浮层（只重画浮层那一块）
+    QRect mOverlayRect;              // 浮层在 viewport 坐标下的位置，drawForeground 时更新
+    QElapsedTimer mFrameClock;       // 上一帧结束的时刻
+    double mTickMsSinceFrame = 0;
+    int mRestyledSinceFrame = 0;
+    QElapsedTimer mStepWindow;       // 每秒 Step 数：按 1 秒窗口计数
+    int mStepsInWindow = 0;
+    double mStepsPerSec = 0;
+    void countSteps(int k);
+    void drawOverlay(QPainter* painter);
 };
 
 class NodeItem : public QObject, public QGraphicsEllipseItem {
     Q_OBJECT
 public:
-    NodeItem(int id, qreal r)
-        : m_id(id), m_r(r) {
+    NodeItem(int id, qreal r, const VisualState* vis)
+        : m_id(id), m_r(r), m_vis(vis) {
         setRect(-r, -r, 2*r, 2*r);
         setFlag(ItemIsMovable, true);
         setFlag(ItemSendsGeometryChanges, true);
@@ -166,6 +293,18 @@ public:
     }
 
     int id() const { return m_id; }
+
+    // 加边模式下被选为起点时的临时高亮（纯交互状态，不进 VisualState）。
+    void setPicked(bool on) { if (m_picked != on) { m_picked = on; update(); } }
+
+    // 四周留出最粗描边与选中虚线框，上方留出输出序号、下方留出入度文字的位置；
+    // 文字比圆宽时左右也要放宽。回放只重绘脏 item，包围盒小了会留下残影。
+    QRectF boundingRect() const override {
+        const qreal side = std::max(kStrokePad, kTextHalfWidth - m_r);
+        return rect().adjusted(-side, -kTextPad, side, kTextPad);
+    }
+    // 外观全部由 VisualState 现算（见 GraphView.cpp）。
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
     bool fixed() const { return m_fixed; }
     void setFixed(bool f) { m_fixed = f; }
 
@@ -173,6 +312,10 @@ public:
 
     QPointF vel{0, 0};
 
+    // 与该点相连的边（出边 + 入边）。点移动后，GraphView 在帧末只更新这些边。
+    QVector<EdgeItem*> edges;
+    bool moveQueued = false; // 本帧是否已记入“移动过的点”列表
+
 signals:
     void moved();
     void dragStarted();
@@ -203,71 +346,116 @@ protected:
     }
 
 private:
+    static constexpr qreal kTextPad = 24.0;
+    static constexpr qreal kMaxPenWidth = 4.0;                   // paint() 里最粗的描边（active）
+    static constexpr qreal kStrokePad = kMaxPenWidth / 2 + 3;    // 半个笔宽 + 选中虚线框外扩的 3
+    static constexpr qreal kTextHalfWidth = 40.0;                // 入度 / 序号文字（至多 10 位数字）宽度的一半
+
     int m_id;
     qreal m_r;
+    const VisualState* m_vis = nullptr;
+    bool m_picked = false;
     bool m_fixed = false;   // 真正的“固定”
     bool m_pinned = false;  // 双击切换 pin
 };
 
 
-class EdgeItem : public QObject, public QGraphicsPathItem {
-    Q_OBJECT
+/**
+ * EdgeItem 不再继承 QGraphicsPathItem：路径（线段 + 箭头两翼）的几何量缓存在成员里，
+ * paint() 直接画缓存好的点，不再每次都构造 QPainterPath。
+ *
+ * 更新时机也改了：EdgeItem 不再直接连端点的 moved 信号（那样一次力导 tick 每条边要算两次），
+ * 而是由 GraphView 在每帧结束时统一调用 updatePath()，每条边最多一次。
+ */
+class EdgeItem : public QGraphicsItem {
 public:
-    EdgeItem(NodeItem* from, NodeItem* to, qreal nodeRadius)
-        : m_from(from), m_to(to), m_r(nodeRadius)
+    EdgeItem(int id, NodeItem* from, NodeItem* to, qreal nodeRadius, const VisualState* vis)
+        : m_id(id), m_from(from), m_to(to), m_r(nodeRadius), m_vis(vis)
     {
-        setPen(QPen(Qt::black, 2));
         setZValue(-1); // 让边在点的下面
-
-        connect(m_from, &NodeItem::moved, this, &EdgeItem::updatePath);
-        connect(m_to,   &NodeItem::moved, this, &EdgeItem::updatePath);
-
         updatePath();
     }
 
-public slots:
+    int id() const { return m_id; }
+    NodeItem* from() const { return m_from; }
+    NodeItem* to() const { return m_to; }
+
+    bool updateQueued = false; // GraphView 的每帧批处理用：本帧是否已排队
+
+    // 按端点当前位置重算缓存几何；端点没动则直接返回（不触碰场景索引）。
     void updatePath() {
         if (!m_from || !m_to) return;
 
-        QPointF A = m_from->pos();
-        QPointF B = m_to->pos();
+        const QPointF A = m_from->pos();
+        const QPointF B = m_to->pos();
+        if (m_valid && A == m_lastA && B == m_lastB) return;
 
-        QLineF line(A, B);
-        if (line.length() < 1.0) return;
+        const qreal dx = B.x() - A.x();
+        const qreal dy = B.y() - A.y();
+        const qreal len = std::sqrt(dx*dx + dy*dy);
+        if (len < 1.0) return;
 
-        // 把线段两端“缩短”，避免穿过圆心（看起来更像连到圆边）
-        QLineF ab(A, B);
-        ab.setLength(std::max(0.0, ab.length() - m_r));
-        QPointF end = ab.p2();
+        // 单位方向向量；箭头两翼 = 方向向量旋转 ±120°（cos=-1/2, sin=±√3/2），免去 atan2/sin/cos。
+        const qreal ux = dx / len, uy = dy / len;
 
-        QLineF ba(B, A);
-        ba.setLength(std::max(0.0, ba.length() - m_r));
-        QPointF start = ba.p2();
+        // 把线段两端“缩短”，避免穿过圆心（看起来更像连到圆边）
+        const qreal keep = std::max<qreal>(0.0, len - m_r);
+        const QPointF end(A.x() + ux * keep, A.y() + uy * keep);
+        const QPointF start(B.x() - ux * keep, B.y() - uy * keep);
+
+        constexpr qreal kArrowSize = 10.0;
+        constexpr qreal kSin120 = 0.86602540378443864676;
+        const QPointF w1 = end + QPointF((-0.5 * ux + kSin120 * uy) * kArrowSize,
+                                         (-0.5 * uy - kSin120 * ux) * kArrowSize);
+        const QPointF w2 = end + QPointF((-0.5 * ux - kSin120 * uy) * kArrowSize,
+                                         (-0.5 * uy + kSin120 * ux) * kArrowSize);
+
+        prepareGeometryChange();
+        m_lastA = A; m_lastB = B;
+        m_start = start; m_end = end;
+        m_wing1 = w1; m_wing2 = w2;
+
+        const qreal left   = std::min({start.x(), end.x(), w1.x(), w2.x()});
+        const qreal right  = std::max({start.x(), end.x(), w1.x(), w2.x()});
+        const qreal top    = std::min({start.y(), end.y(), w1.y(), w2.y()});
+        const qreal bottom = std::max({start.y(), end.y(), w1.y(), w2.y()});
+        const qreal pad = kMaxPenWidth;
+        m_bounds = QRectF(QPointF(left - pad, top - pad), QPointF(right + pad, bottom + pad));
+        m_valid = true;
+    }
 
-        QLineF core(start, end);
+    QRectF boundingRect() const override { return m_bounds; }
 
+    // 命中测试仍按真实线条（否则空白处的点击会被边的包围盒吃掉）；只在需要时构造。
+    QPainterPath shape() const override {
         QPainterPath path;
-        path.moveTo(core.p1());
-        path.lineTo(core.p2());
-
-        // 箭头（三角形两翼）
-        const qreal arrowSize = 10.0;
-        const qreal angle = std::atan2(-core.dy(), core.dx());
-
-        QPointF p1 = core.p2() + QPointF(std::cos(angle + M_PI * 2.0/3.0) * arrowSize,
-                                         -std::sin(angle + M_PI * 2.0/3.0) * arrowSize);
-        QPointF p2 = core.p2() + QPointF(std::cos(angle + M_PI * 4.0/3.0) * arrowSize,
-                                         -std::sin(angle + M_PI * 4.0/3.0) * arrowSize);
-
-        path.moveTo(p1);
-        path.lineTo(core.p2());
-        path.lineTo(p2);
-
-        setPath(path);
+        if (!m_valid) return path;
+        path.moveTo(m_start);
+        path.lineTo(m_end);
+        path.moveTo(m_wing1);
+        path.lineTo(m_end);
+        path.lineTo(m_wing2);
+        QPainterPathStroker stroker;
+        stroker.setWidth(kMaxPenWidth);
+        return stroker.createStroke(path);
     }
 
+    // 笔的颜色/粗细由 VisualState 现算（见 GraphView.cpp）。
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
 private:
+    // 包围盒按最粗的边笔宽预留边距，换样式不需要 prepareGeometryChange()。
+    static constexpr qreal kMaxPenWidth = 4.0;
+
+    int m_id;
     NodeItem* m_from = nullptr;
     NodeItem* m_to   = nullptr;
     qreal m_r = 0;
+    const VisualState* m_vis = nullptr;
+
+    // 缓存的几何（端点不变就不重算）
+    bool m_valid = false;
+    QPointF m_lastA, m_lastB;
+    QPointF m_start, m_end, m_wing1, m_wing2;
+    QRectF m_bounds;
 };
@@ -0,0 +1,150 @@
+/* ANNOTATED_FOR_STUDY
+@file LayeredLayout.cpp
+@brief 分层布局实现：最长路分层 + 重心扫描 + 相邻层交叉计数（只保留交叉最少的一轮）。
+*/
+
+#include "LayeredLayout.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+// 相邻两层之间的交叉数：边按 (上端位置, 下端位置) 排序后，下端位置序列的逆序对数（树状数组）。
+long long countCrossings(const std::vector<std::vector<int>>& layers,
+                         const std::vector<std::vector<int>>& succ,
+                         const std::vector<int>& layer, const std::vector<int>& idx)
+{
+    long long total = 0;
+    std::vector<std::pair<int, int>> es;
+    std::vector<int> bit;
+    for (std::size_t L = 0; L + 1 < layers.size(); ++L) {
+        es.clear();
+        for (int u : layers[L]) {
+            for (int v : succ[std::size_t(u)]) {
+                if (layer[std::size_t(v)] == int(L) + 1) es.push_back({idx[std::size_t(u)], idx[std::size_t(v)]});
+            }
+        }
+        std::sort(es.begin(), es.end());
+        const int width = (int)layers[L + 1].size();
+        bit.assign(std::size_t(width) + 1, 0);
+        long long seen = 0;
+        for (const auto& e : es) {
+            // 已插入的边里下端位置 > e.second 的个数。
+            long long le = 0;
+            for (int i = e.second + 1; i > 0; i -= i & -i) le += bit[std::size_t(i)];
+            total += seen - le;
+            for (int i = e.second + 1; i <= width; i += i & -i) bit[std::size_t(i)]++;
+            ++seen;
+        }
+    }
+    return total;
+}
+} // namespace
+
+std::vector<LayoutPoint> LayeredLayout::run(const Graph& g, TaskControl* ctl)
+{
+    TRACE_SCOPE("LayeredLayout::run");
+    const int n = g.n;
+    mLayers.clear();
+    mCrossings = 0;
+
+    std::vector<std::vector<int>> pred(std::size_t(n) + 1), succ(std::size_t(n) + 1);
+    std::vector<int> indeg(std::size_t(n) + 1, 0);
+    for (int u = 1; u <= n; ++u) {
+        for (int v : g.adj[std::size_t(u)]) {
+            succ[std::size_t(u)].push_back(v);
+            pred[std::size_t(v)].push_back(u);
+            indeg[std::size_t(v)]++;
+        }
+    }
+
+    // 1) 最长路分层（Kahn 顺序）。
+    std::vector<int> layer(std::size_t(n) + 1, 0);
+    std::vector<int> order;
+    order.reserve(std::size_t(n));
+    for (int v = 1; v <= n; ++v) {
+        if (indeg[std::size_t(v)] == 0) order.push_back(v);
+    }
+    for (std::size_t head = 0; head < order.size(); ++head) {
+        const int u = order[head];
+        for (int v : succ[std::size_t(u)]) {
+            layer[std::size_t(v)] = std::max(layer[std::size_t(v)], layer[std::size_t(u)] + 1);
+            if (--indeg[std::size_t(v)] == 0) order.push_back(v);
+        }
+    }
+    int maxLayer = 0;
+    for (int u : order) maxLayer = std::max(maxLayer, layer[std::size_t(u)]);
+    if ((int)order.size() < n) {
+        // 有环：没出队的点放到最底下一层。
+        ++maxLayer;
+        for (int v = 1; v <= n; ++v) {
+            if (indeg[std::size_t(v)] > 0) {
+                layer[std::size_t(v)] = maxLayer;
+                order.push_back(v);
+            }
+        }
+    }
+    if (n > 0) mLayers.assign(std::size_t(maxLayer) + 1, {});
+    for (int u : order) mLayers[std::size_t(layer[std::size_t(u)])].push_back(u);
+
+    // 2) 重心扫描。key 是归一化位置，跨层的邻居也能直接比较。
+    std::vector<int> idx(std::size_t(n) + 1, 0);
+    std::vector<double> key(std::size_t(n) + 1, 0);
+    auto reindex = [&](const std::vector<int>& row) {
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            idx[std::size_t(row[i])] = int(i);
+            key[std::size_t(row[i])] = (double(i) + 0.5) / double(row.size());
+        }
+    };
+    for (const auto& row : mLayers) reindex(row);
+
+    std::vector<std::vector<int>> best = mLayers;
+    mCrossings = countCrossings(mLayers, succ, layer, idx);
+    std::vector<double> bary(std::size_t(n) + 1, 0);
+
+    for (int s = 0; s < sweeps && mCrossings > 0; ++s) {
+        if (ctl && !ctl->tick(std::uint64_t(n) + 1)) return {};
+        const bool down = (s % 2 == 0);
+        const auto& nbr = down ? pred : succ;
+        const int L0 = down ? 1 : maxLayer - 1;
+        const int step = down ? 1 : -1;
+        for (int L = L0; L >= 0 && L <= maxLayer; L += step) {
+            auto& row = mLayers[std::size_t(L)];
+            for (int v : row) {
+                // 越近的邻居权重越大：相邻层的边决定交叉数，长边只作参考。
+                // 同层的邻居（只在有环时出现）不参与。
+                double sum = 0, wsum = 0;
+                for (int u : nbr[std::size_t(v)]) {
+                    const int d = std::abs(layer[std::size_t(u)] - L);
+                    if (d == 0) continue;
+                    sum += key[std::size_t(u)] / double(d);
+                    wsum += 1.0 / double(d);
+                }
+                // 没有这一侧的邻居：原地不动。
+                bary[std::size_t(v)] = (wsum > 0) ? sum / wsum : key[std::size_t(v)];
+            }
+            std::stable_sort(row.begin(), row.end(),
+                             [&bary](int a, int b) { return bary[std::size_t(a)] < bary[std::size_t(b)]; });
+            reindex(row);
+        }
+
+        const long long c = countCrossings(mLayers, succ, layer, idx);
+        if (c < mCrossings) {
+            mCrossings = c;
+            best = mLayers;
+        }
+    }
+    mLayers = std::move(best);
+
+    // 3) 坐标：每层以 x = 0 为中心。
+    std::vector<LayoutPoint> pos(std::size_t(n) + 1);
+    for (std::size_t L = 0; L < mLayers.size(); ++L) {
+        const auto& row = mLayers[L];
+        const double left = -0.5 * double(row.size() - 1) * nodeGap;
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            pos[std::size_t(row[i])] = {left + double(i) * nodeGap, double(L) * layerGap};
+        }
+    }
+    return pos;
+}
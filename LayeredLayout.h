@@ -0,0 +1,45 @@
+/* ANNOTATED_FOR_STUDY
+@file LayeredLayout.h
+@brief 分层布局（Sugiyama 风格）：按拓扑层次从上往下排，层内用重心法减少交叉。
+
+为什么 DAG 要单独一种布局？
+- 力导布局每帧 O(n²)，而且要跑很多帧才稳定；对 DAG 来说，最能看懂的画法其实是“边都朝下”；
+- 分层布局一次算完：分层 O(n + m)，每轮重心排序 O(m + n log n)，只跑固定几轮。
+
+三步：
+1) 分层：最长路分层（Kahn 顺序里 layer[v] = max(layer[u] + 1)），每条边都从上层指向下层；
+2) 层内排序：先按拓扑序摆，再做若干轮上下交替的“重心扫描”——
+   向下扫时每个点取它所有前驱的平均位置（位置按所在层归一化到 0..1），按这个值重排；向上扫时看后继；
+   跨多层的长边不插虚拟点，直接按归一化位置参与平均（省掉虚拟点，复杂度保持线性）；
+3) 坐标：y = 层号 * layerGap，x 以 0 为中心、间距 nodeGap。
+
+纯逻辑模块，不含 Qt 类型；输入若有环，环上剩下的点统一放在最底下一层。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "TaskControl.h"
+#include <vector>
+
+struct LayoutPoint {
+    double x = 0;
+    double y = 0;
+};
+
+class LayeredLayout {
+public:
+    double layerGap = 150.0;
+    double nodeGap = 110.0;
+    int sweeps = 8;             // 重心扫描轮数（上下各算一轮）
+
+    // 返回 pos[1..n]（pos[0] 不用）。ctl 被取消时返回空。
+    std::vector<LayoutPoint> run(const Graph& g, TaskControl* ctl = nullptr);
+
+    // 上一次 run 的层数与相邻层之间的交叉边对数（调试/显示用）。
+    int layerCount() const { return (int)mLayers.size(); }
+    long long crossings() const { return mCrossings; }
+
+private:
+    std::vector<std::vector<int>> mLayers;   // [层] -> 层内从左到右的点
+    long long mCrossings = 0;
+};
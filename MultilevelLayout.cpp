@@ -0,0 +1,277 @@
+/* ANNOTATED_FOR_STUDY
+@file MultilevelLayout.cpp
+@brief 多级布局实现：SCC 缩点 + 重边匹配粗化，最粗层精排，逐层展开后用网格加速的 FR 迭代微调。
+*/
+
+#include "MultilevelLayout.h"
+#include "Trace.h"
+#include "TarjanSCC.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <utility>
+
+namespace {
+// 纯逻辑模块不引 Qt，M_PI 又不是标准的（MSVC 要 _USE_MATH_DEFINES），自己定义。
+constexpr double kPi = 3.14159265358979323846;
+
+// 无向邻接表按邻居编号排序后合并重数。
+void mergeAdj(std::vector<std::pair<int, int>>& row)
+{
+    std::sort(row.begin(), row.end());
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < row.size(); ++i) {
+        if (out > 0 && row[out - 1].first == row[i].first) row[out - 1].second += row[i].second;
+        else row[out++] = row[i];
+    }
+    row.resize(out);
+}
+} // namespace
+
+MultilevelLayout::Level MultilevelLayout::fromGraph(const Graph& g)
+{
+    Level lv;
+    lv.n = g.n;
+    lv.adj.assign(std::size_t(g.n), {});
+    lv.mass.assign(std::size_t(g.n), 1.0);
+    for (int u = 1; u <= g.n; ++u) {
+        for (int v : g.adj[std::size_t(u)]) {
+            if (u == v) continue;
+            lv.adj[std::size_t(u - 1)].push_back({v - 1, 1});
+            lv.adj[std::size_t(v - 1)].push_back({u - 1, 1});
+        }
+    }
+    for (auto& row : lv.adj) mergeAdj(row);
+    return lv;
+}
+
+MultilevelLayout::Level MultilevelLayout::contract(const Level& fine, std::vector<int>& parent, int coarseN)
+{
+    Level lv;
+    lv.n = coarseN;
+    lv.adj.assign(std::size_t(coarseN), {});
+    lv.mass.assign(std::size_t(coarseN), 0.0);
+    for (int v = 0; v < fine.n; ++v) {
+        const int pv = parent[std::size_t(v)];
+        lv.mass[std::size_t(pv)] += fine.mass[std::size_t(v)];
+        for (const auto& e : fine.adj[std::size_t(v)]) {
+            const int pw = parent[std::size_t(e.first)];
+            if (pw != pv) lv.adj[std::size_t(pv)].push_back({pw, e.second});
+        }
+    }
+    for (auto& row : lv.adj) mergeAdj(row);
+    return lv;
+}
+
+int MultilevelLayout::matchLevel(const Level& fine, std::vector<int>& parent, std::uint64_t seed)
+{
+    std::vector<int> order(fine.mass.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    parent.assign(std::size_t(fine.n), -1);
+    int cnt = 0;
+    for (int v : order) {
+        if (parent[std::size_t(v)] >= 0) continue;
+        // 连边最多的未配对邻居；一样多时选质量小的，避免粗点越滚越大。
+        int best = -1, bestC = 0;
+        for (const auto& e : fine.adj[std::size_t(v)]) {
+            const int w = e.first;
+            if (parent[std::size_t(w)] >= 0) continue;
+            if (best < 0 || e.second > bestC
+                || (e.second == bestC && fine.mass[std::size_t(w)] < fine.mass[std::size_t(best)])) {
+                best = w;
+                bestC = e.second;
+            }
+        }
+        parent[std::size_t(v)] = cnt;
+        if (best >= 0) parent[std::size_t(best)] = cnt;
+        ++cnt;
+    }
+    return cnt;
+}
+
+bool MultilevelLayout::relax(const Level& lv, std::vector<LayoutPoint>& pos, int iters, double k, bool exact,
+                             TaskControl* ctl) const
+{
+    const int n = lv.n;
+    if (n <= 1) return true;
+
+    double totalMass = 0;
+    for (double m : lv.mass) totalMass += m;
+    const double avgMass = totalMass / n;
+    const double k2 = k * k;
+    // 最粗层要从圆形摆放里解开全局结构，温度给大；细层只做局部微调。
+    const double t0 = exact ? k * std::sqrt(double(n)) * 0.5 : k * 0.5;
+
+    std::vector<LayoutPoint> disp(pos.size());
+    const double cutoff2 = 4.0 * k2;   // 细层只算 2k 以内的排斥
+    std::vector<int> cellOf, cellStart, cellItems;
+
+    auto repel = [&](int i, int j) {
+        const double dx = pos[std::size_t(i)].x - pos[std::size_t(j)].x;
+        const double dy = pos[std::size_t(i)].y - pos[std::size_t(j)].y;
+        const double d2 = std::max(dx * dx + dy * dy, 1e-4);
+        if (!exact && d2 > cutoff2) return;
+        // f = k² / d，质量按平均值归一化后相乘：重的粗点推得更开。
+        const double w = (lv.mass[std::size_t(i)] / avgMass) * (lv.mass[std::size_t(j)] / avgMass);
+        const double s = k2 * w / d2;   // = (k²w/d) / d，乘上 (dx, dy) 就是沿方向的力
+        disp[std::size_t(i)].x += dx * s;
+        disp[std::size_t(i)].y += dy * s;
+        if (exact) {
+            disp[std::size_t(j)].x -= dx * s;
+            disp[std::size_t(j)].y -= dy * s;
+        }
+    };
+
+    for (int it = 0; it < iters; ++it) {
+        if (ctl && !ctl->tick(std::uint64_t(n))) return false;
+        std::fill(disp.begin(), disp.end(), LayoutPoint());
+
+        if (exact) {
+            for (int i = 0; i < n; ++i) {
+                for (int j = i + 1; j < n; ++j) repel(i, j);
+            }
+        } else {
+            // 网格（计数排序分桶）：格子边长 >= 2k，只看自己和周围 8 个格子。
+            double minX = pos[0].x, maxX = minX, minY = pos[0].y, maxY = minY;
+            for (const auto& p : pos) {
+                minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+                minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+            }
+            // 点很分散时放大格子，格子总数不超过 4n。
+            const double cell = std::max(2.0 * k, std::sqrt((maxX - minX + 1) * (maxY - minY + 1) / (4.0 * n)));
+            const int gw = int((maxX - minX) / cell) + 1;
+            const int gh = int((maxY - minY) / cell) + 1;
+            cellOf.resize(std::size_t(n));
+            cellStart.assign(std::size_t(gw) * std::size_t(gh) + 1, 0);
+            cellItems.resize(std::size_t(n));
+            for (int i = 0; i < n; ++i) {
+                const int cx = std::min(gw - 1, int((pos[std::size_t(i)].x - minX) / cell));
+                const int cy = std::min(gh - 1, int((pos[std::size_t(i)].y - minY) / cell));
+                cellOf[std::size_t(i)] = cy * gw + cx;
+                cellStart[std::size_t(cellOf[std::size_t(i)]) + 1]++;
+            }
+            for (std::size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+            {
+                std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+                for (int i = 0; i < n; ++i) cellItems[std::size_t(fill[std::size_t(cellOf[std::size_t(i)])]++)] = i;
+            }
+            for (int i = 0; i < n; ++i) {
+                const int cx = cellOf[std::size_t(i)] % gw;
+                const int cy = cellOf[std::size_t(i)] / gw;
+                for (int y = std::max(0, cy - 1); y <= std::min(gh - 1, cy + 1); ++y) {
+                    for (int x = std::max(0, cx - 1); x <= std::min(gw - 1, cx + 1); ++x) {
+                        const int c = y * gw + x;
+                        for (int t = cellStart[std::size_t(c)]; t < cellStart[std::size_t(c) + 1]; ++t) {
+                            if (cellItems[std::size_t(t)] != i) repel(i, cellItems[std::size_t(t)]);
+                        }
+                    }
+                }
+            }
+        }
+
+        // 吸引：f = d² / k，重边（粗层合并出来的多重边）按对数加权。
+        for (int v = 0; v < n; ++v) {
+            for (const auto& e : lv.adj[std::size_t(v)]) {
+                const int w = e.first;
+                if (w <= v) continue;
+                const double dx = pos[std::size_t(w)].x - pos[std::size_t(v)].x;
+                const double dy = pos[std::size_t(w)].y - pos[std::size_t(v)].y;
+                const double d = std::sqrt(dx * dx + dy * dy);
+                const double s = d / k * (1.0 + std::log(double(e.second)));   // = (d²/k) / d
+                disp[std::size_t(v)].x += dx * s;
+                disp[std::size_t(v)].y += dy * s;
+                disp[std::size_t(w)].x -= dx * s;
+                disp[std::size_t(w)].y -= dy * s;
+            }
+        }
+
+        // 每步位移不超过当前温度。
+        const double t = t0 * (1.0 - double(it) / double(iters)) + 0.01 * k;
+        for (int v = 0; v < n; ++v) {
+            auto& d = disp[std::size_t(v)];
+            const double len = std::sqrt(d.x * d.x + d.y * d.y);
+            if (len < 1e-9) continue;
+            const double step = std::min(len, t) / len;
+            pos[std::size_t(v)].x += d.x * step;
+            pos[std::size_t(v)].y += d.y * step;
+        }
+    }
+    return true;
+}
+
+std::vector<LayoutPoint> MultilevelLayout::run(const Graph& g, TaskControl* ctl)
+{
+    TRACE_SCOPE("MultilevelLayout::run");
+    mLevelSizes.clear();
+    const int n = g.n;
+    if (n <= 0) return std::vector<LayoutPoint>(1);
+
+    // 1) 建层次。levels[i].parent 指向 levels[i + 1]。
+    std::vector<Level> levels;
+    levels.push_back(fromGraph(g));
+    if (useScc) {
+        SCCResult scc = TarjanSCC().run(g, ctl);
+        if (ctl && ctl->stopped()) return {};
+        if (scc.sccCnt < n) {
+            std::vector<int> parent(levels.back().mass.size());
+            for (int v = 1; v <= n; ++v) parent[std::size_t(v - 1)] = scc.sccId[std::size_t(v)] - 1;
+            levels.back().parent = parent;
+            Level next = contract(levels.back(), parent, scc.sccCnt);
+            levels.push_back(std::move(next));
+        }
+    }
+    std::uint64_t seed = 1;
+    while (levels.back().n > coarsest) {
+        if (ctl && !ctl->tick(std::uint64_t(levels.back().n))) return {};
+        std::vector<int> parent;
+        const int cnt = matchLevel(levels.back(), parent, seed++);
+        if (cnt > levels.back().n * 19 / 20) break;   // 缩不动了（如星形图）
+        levels.back().parent = parent;
+        Level next = contract(levels.back(), parent, cnt);
+        levels.push_back(std::move(next));
+    }
+    for (const Level& lv : levels) mLevelSizes.push_back(lv.n);
+
+    // 2) 最粗层：摆成一圈（相邻点间距约 k），两两排斥精排。
+    const Level& top = levels.back();
+    auto levelK = [&](const Level& lv) { return restLen * std::sqrt(double(n) / double(std::max(1, lv.n))); };
+    std::vector<LayoutPoint> pos(top.mass.size());
+    {
+        const double k = levelK(top);
+        const double radius = k * top.n / (2.0 * kPi) + k;
+        for (int i = 0; i < top.n; ++i) {
+            const double a = 2.0 * kPi * i / top.n;
+            pos[std::size_t(i)] = {radius * std::cos(a), radius * std::sin(a)};
+        }
+        if (!relax(top, pos, coarseIters, k, true, ctl)) return {};
+    }
+
+    // 3) 逐层展开：细点从所属粗点的位置出发，加一点随机偏移把同组的点分开，再局部迭代。
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> angle(0.0, 2.0 * kPi);
+    for (int L = int(levels.size()) - 2; L >= 0; --L) {
+        const Level& fine = levels[std::size_t(L)];
+        const double k = levelK(fine);
+        std::vector<LayoutPoint> fpos(fine.mass.size());
+        for (int v = 0; v < fine.n; ++v) {
+            const LayoutPoint& p = pos[std::size_t(fine.parent[std::size_t(v)])];
+            const double a = angle(rng);
+            fpos[std::size_t(v)] = {p.x + 0.3 * k * std::cos(a), p.y + 0.3 * k * std::sin(a)};
+        }
+        pos = std::move(fpos);
+        if (!relax(fine, pos, refineIters, k, fine.n <= coarsest * 4, ctl)) return {};
+    }
+
+    // 4) 以原点为中心输出，pos[0] 不用。
+    double cx = 0, cy = 0;
+    for (const auto& p : pos) { cx += p.x; cy += p.y; }
+    cx /= n;
+    cy /= n;
+    std::vector<LayoutPoint> out(std::size_t(n) + 1);
+    for (int v = 0; v < n; ++v) out[std::size_t(v + 1)] = {pos[std::size_t(v)].x - cx, pos[std::size_t(v)].y - cy};
+    return out;
+}
@@ -0,0 +1,59 @@
+/* ANNOTATED_FOR_STUDY
+@file MultilevelLayout.h
+@brief 多级布局：先把图一层层“缩小”，在最粗的图上排好，再逐层展开、微调。
+
+为什么？
+- 力导布局从圆形坐标出发，大图要跑很多帧才能解开缠绕：每个点只能一点点挪，全局结构要靠成百上千次迭代慢慢“传”过去；
+- 粗图只有几十个点，几百次迭代也很便宜，就能把全局结构排对；展开后每个点从它所属粗点的位置出发，
+  只需要少量局部迭代。
+
+层次怎么建：
+1) 第 0 层：原图（当无向图看，去掉重边和自环）；
+2) 第 1 层：Tarjan 缩点（分组与 Condense 相同）——同一个 SCC 的点本来就该挨在一起，这是现成的“自然分组”；
+   （图里没有非平凡 SCC 时跳过这一层）
+3) 再往上：重边匹配（heavy-edge matching）——每个点和一个还没配对的邻居合并，优先选连边最多、
+   合并后质量最小的邻居；直到点数不超过 coarsest，或者一轮下来几乎缩不动（比如星形图）。
+每个粗点记“质量”（代表多少个原图点），排斥力按质量加权，粗层的理想边长按平均质量放大。
+
+每层的迭代是 Fruchterman-Reingold：排斥 k²/d、吸引 d²/k、温度线性下降；
+最粗层两两计算排斥，细层用网格只算 2k 以内的点对，单次迭代近似线性。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "LayeredLayout.h"   // LayoutPoint
+#include "TaskControl.h"
+#include <vector>
+
+class MultilevelLayout {
+public:
+    double restLen = 120.0;      // 原图上的理想边长（与 GraphView 的力导参数一致）
+    int coarsest = 24;           // 粗化到这么多点以内就停
+    int coarseIters = 300;       // 最粗层的迭代次数
+    int refineIters = 40;        // 其余每层的迭代次数
+    bool useScc = true;          // 是否用 SCC 缩点作为第一层粗化
+
+    // 返回 pos[1..n]（pos[0] 不用），以原点为中心。ctl 被取消时返回空。
+    std::vector<LayoutPoint> run(const Graph& g, TaskControl* ctl = nullptr);
+
+    // 上一次 run 的各层点数（[0] 是原图）。
+    const std::vector<int>& levelSizes() const { return mLevelSizes; }
+
+private:
+    struct Level {
+        int n = 0;
+        std::vector<std::vector<std::pair<int, int>>> adj;   // [v] -> {(邻居, 重数)}，无向，0 起编号
+        std::vector<double> mass;                            // [v] 代表的原图点数
+        std::vector<int> parent;                             // [v] -> 上一层（更粗）里的点
+    };
+
+    std::vector<int> mLevelSizes;
+
+    static Level fromGraph(const Graph& g);
+    static Level contract(const Level& fine, std::vector<int>& parent, int coarseN);
+    static int matchLevel(const Level& fine, std::vector<int>& parent, std::uint64_t seed);
+    bool relax(const Level& lv, std::vector<LayoutPoint>& pos, int iters, double k, bool exact,
+               TaskControl* ctl) const;
+};
@@ -0,0 +1,163 @@
+/* ANNOTATED_FOR_STUDY
+@file NodeBits.h
+@brief 定宽点集位图 NodeBits<W>（W 个 64 位字，最多 64*W 个点），给小/中规模 DAG 的枚举、计数、解码用。
+
+n ≤ 256 时，“已输出的点”“当前候选”“v 的前驱”都能放进 1/2/4 个机器字：
+- v 是否就绪 = (pred[v] & ~used) 为空，几条与/或指令，不用逐个前驱查；
+- 按编号升序遍历候选 = 反复取最低位（ctz），顺序与原来的 for 循环 / std::set 一致；
+- 计数表以位图本身为键，定长、不分配，哈希也只是几次乘法。
+n 更大时仍走原来的 vector 实现。调用方按 nodeBitsWords(n) 在运行时选宽度，
+再用 withNodeBits 把宽度变成模板参数，分派到对应的特化内核。
+
+约定：点编号 1..n，第 v 个点占第 v-1 位。
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 最低的 1 位的位置；x 不能为 0。
+inline int lowestBit(std::uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long i = 0;
+    _BitScanForward64(&i, x);
+    return int(i);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+template <int W>
+struct NodeBits {
+    static constexpr int kMaxNodes = 64 * W;
+    std::uint64_t w[W] = {};
+
+    void set(int v) { w[(v - 1) >> 6] |= std::uint64_t(1) << ((v - 1) & 63); }
+    void reset(int v) { w[(v - 1) >> 6] &= ~(std::uint64_t(1) << ((v - 1) & 63)); }
+    bool test(int v) const { return (w[(v - 1) >> 6] >> ((v - 1) & 63)) & 1u; }
+
+    bool any() const
+    {
+        std::uint64_t x = 0;
+        for (int i = 0; i < W; ++i) x |= w[i];
+        return x != 0;
+    }
+    // this ∩ ~other 是否为空（“前驱是否都已输出”就是 pred.coveredBy(used)）。
+    bool coveredBy(const NodeBits& other) const
+    {
+        std::uint64_t x = 0;
+        for (int i = 0; i < W; ++i) x |= w[i] & ~other.w[i];
+        return x == 0;
+    }
+
+    // 编号最小的点；空集返回 0。
+    int first() const
+    {
+        for (int i = 0; i < W; ++i) {
+            if (w[i]) return (i << 6) + lowestBit(w[i]) + 1;
+        }
+        return 0;
+    }
+    // 编号大于 v 的最小点（v 可为 0）；没有返回 0。
+    int firstAfter(int v) const
+    {
+        if (v >= kMaxNodes) return 0;
+        int i = v >> 6;
+        std::uint64_t x = w[i] & (~std::uint64_t(0) << (v & 63));
+        for (;;) {
+            if (x) return (i << 6) + lowestBit(x) + 1;
+            if (++i == W) return 0;
+            x = w[i];
+        }
+    }
+
+    NodeBits& operator|=(const NodeBits& o)
+    {
+        for (int i = 0; i < W; ++i) w[i] |= o.w[i];
+        return *this;
+    }
+    // this ∩ ~o
+    NodeBits minus(const NodeBits& o) const
+    {
+        NodeBits r;
+        for (int i = 0; i < W; ++i) r.w[i] = w[i] & ~o.w[i];
+        return r;
+    }
+
+    bool operator==(const NodeBits& o) const
+    {
+        for (int i = 0; i < W; ++i) {
+            if (w[i] != o.w[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const NodeBits& o) const { return !(*this == o); }
+
+    // 按编号升序逐个访问集合里的点：f(v)。
+    template <class F>
+    void forEach(F&& f) const
+    {
+        for (int i = 0; i < W; ++i) {
+            for (std::uint64_t x = w[i]; x; x &= x - 1) f((i << 6) + lowestBit(x) + 1);
+        }
+    }
+};
+
+template <int W>
+struct NodeBitsHash {
+    std::size_t operator()(const NodeBits<W>& b) const
+    {
+        // 逐字混入后再做一次 splitmix64 收尾：开放寻址按低位取槽，高位的差别也要落到低位上。
+        std::uint64_t h = 0;
+        for (int i = 0; i < W; ++i) h = (h ^ b.w[i]) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return std::size_t(h);
+    }
+};
+
+// 每个点的前驱集 / 后继集（下标 1..n；重边只记一次）。
+template <int W>
+void nodeBitsAdjacency(const Graph& g, std::vector<NodeBits<W>>& pred, std::vector<NodeBits<W>>& succ)
+{
+    pred.assign(std::size_t(g.n) + 1, NodeBits<W>());
+    succ.assign(std::size_t(g.n) + 1, NodeBits<W>());
+    for (int u = 1; u <= g.n; ++u) {
+        for (int v : g.adj[std::size_t(u)]) {
+            pred[std::size_t(v)].set(u);
+            succ[std::size_t(u)].set(v);
+        }
+    }
+}
+
+// n 个点要几个字：1 / 2 / 4；超过 256 返回 0（走通用实现）。
+inline int nodeBitsWords(int n)
+{
+    if (n <= 64) return 1;
+    if (n <= 128) return 2;
+    if (n <= 256) return 4;
+    return 0;
+}
+
+// 按 nodeBitsWords(n) 调用 f(std::integral_constant<int, W>{})，返回 true；n 太大时不调用，返回 false。
+template <class F>
+bool withNodeBits(int n, F&& f)
+{
+    switch (nodeBitsWords(n)) {
+    case 1: f(std::integral_constant<int, 1>{}); return true;
+    case 2: f(std::integral_constant<int, 2>{}); return true;
+    case 4: f(std::integral_constant<int, 4>{}); return true;
+    default: return false;
+    }
+}
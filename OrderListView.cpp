@@ -0,0 +1,259 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderListView.cpp
+@brief 虚拟列表实现：顶行下标 + 按需取行 + 滚动条比例映射。
+*/
+
+#include "OrderListView.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <algorithm>
+
+namespace {
+// 滚动条能精确表示的最大行号；超过后改成按比例映射。
+constexpr quint64 kBarMax = quint64(1) << 30;
+
+const QColor kTextColor("#111827");
+const QColor kHintColor("#6b7280");
+const QColor kSelectedBg("#dbeafe");
+const QColor kCurrentBg("#dcfce7");
+} // namespace
+
+OrderListView::OrderListView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+    , mCache(2048)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &OrderListView::onBarMoved);
+    syncScrollBar();
+}
+
+void OrderListView::setSource(quint64 count, RowText text)
+{
+    mCount = count;
+    mText = std::move(text);
+    mCache.clear();
+    mTop = 0;
+    mSelected = kNoRow;
+    mCurrent = kNoRow;
+    syncScrollBar();
+    viewport()->update();
+}
+
+void OrderListView::clear()
+{
+    setSource(0, RowText());
+}
+
+void OrderListView::setPlaceholderText(const QString& text)
+{
+    mPlaceholder = text;
+    if (mCount == 0) viewport()->update();
+}
+
+void OrderListView::setCurrentRow(quint64 row)
+{
+    if (row == mCurrent) return;
+    mCurrent = row;
+    viewport()->update();
+}
+
+void OrderListView::scrollToRow(quint64 row)
+{
+    if (mCount == 0) return;
+    row = std::min(row, mCount - 1);
+    mSelected = row;
+    const quint64 half = pageRows() / 2;
+    setTop(row > half ? row - half : 0);
+}
+
+int OrderListView::rowHeight() const
+{
+    return fontMetrics().height() + 6;
+}
+
+quint64 OrderListView::pageRows() const
+{
+    return quint64(std::max(1, viewport()->height() / rowHeight()));
+}
+
+quint64 OrderListView::maxTop() const
+{
+    const quint64 page = pageRows();
+    return (mCount > page) ? mCount - page : 0;
+}
+
+quint64 OrderListView::rowAt(int y) const
+{
+    if (y < 0) return kNoRow;
+    const quint64 row = mTop + quint64(y / rowHeight());
+    return (row < mCount) ? row : kNoRow;
+}
+
+QString OrderListView::textFor(quint64 row) const
+{
+    if (QString* cached = mCache.object(row)) return *cached;
+    const QString text = mText ? mText(row) : QString();
+    mCache.insert(row, new QString(text));
+    return text;
+}
+
+void OrderListView::setTop(quint64 top)
+{
+    top = std::min(top, maxTop());
+    if (top != mTop) {
+        mTop = top;
+        syncScrollBar();
+    }
+    viewport()->update();
+}
+
+void OrderListView::scrollByRows(qint64 delta)
+{
+    if (delta < 0) {
+        const quint64 d = quint64(-delta);
+        setTop(mTop > d ? mTop - d : 0);
+    } else {
+        const quint64 d = quint64(delta);
+        setTop(mTop + std::min(d, maxTop() - std::min(mTop, maxTop())));
+    }
+}
+
+void OrderListView::selectRow(quint64 row)
+{
+    if (mCount == 0) return;
+    row = std::min(row, mCount - 1);
+    mSelected = row;
+    const quint64 page = pageRows();
+    if (row < mTop) setTop(row);
+    else if (row >= mTop + page) setTop(row - page + 1);
+    else viewport()->update();
+}
+
+void OrderListView::syncScrollBar()
+{
+    QScrollBar* bar = verticalScrollBar();
+    const quint64 mt = maxTop();
+    mSyncingBar = true;
+    if (mt <= kBarMax) {
+        bar->setRange(0, int(mt));
+        bar->setPageStep(int(pageRows()));
+        bar->setSingleStep(1);
+        bar->setValue(int(mTop));
+    } else {
+        bar->setRange(0, int(kBarMax));
+        bar->setPageStep(int(std::max<quint64>(1, kBarMax / 1000)));
+        bar->setSingleStep(1);
+        bar->setValue(int((long double)mTop / (long double)mt * (long double)kBarMax));
+    }
+    mSyncingBar = false;
+}
+
+void OrderListView::onBarMoved(int value)
+{
+    if (mSyncingBar) return;
+    const quint64 mt = maxTop();
+    if (mt <= kBarMax) {
+        mTop = quint64(value);
+    } else {
+        const long double t = (long double)value / (long double)kBarMax * (long double)mt;
+        mTop = std::min(mt, quint64(t));
+    }
+    viewport()->update();
+}
+
+void OrderListView::resizeEvent(QResizeEvent* e)
+{
+    QAbstractScrollArea::resizeEvent(e);
+    syncScrollBar();
+    setTop(mTop);
+}
+
+void OrderListView::paintEvent(QPaintEvent*)
+{
+    QPainter p(viewport());
+    const QRect area = viewport()->rect();
+
+    if (mCount == 0) {
+        p.setPen(kHintColor);
+        p.drawText(area.adjusted(8, 6, -8, -6), Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, mPlaceholder);
+        return;
+    }
+
+    const int h = rowHeight();
+    const QFontMetrics fm = fontMetrics();
+    for (int y = 0; y < area.height(); y += h) {
+        const quint64 row = mTop + quint64(y / h);
+        if (row >= mCount) break;
+
+        const QRect r(0, y, area.width(), h);
+        if (row == mSelected) p.fillRect(r, kSelectedBg);
+        else if (row == mCurrent) p.fillRect(r, kCurrentBg);
+
+        p.setPen(kTextColor);
+        const QString text = fm.elidedText(textFor(row), Qt::ElideRight, r.width() - 12);
+        p.drawText(r.adjusted(6, 0, -6, 0), Qt::AlignLeft | Qt::AlignVCenter, text);
+    }
+}
+
+void OrderListView::wheelEvent(QWheelEvent* e)
+{
+    // 一格滚轮（120）滚 3 行。
+    mWheelRemainder += e->angleDelta().y();
+    const int rows = mWheelRemainder / 40;
+    mWheelRemainder -= rows * 40;
+    if (rows != 0) scrollByRows(-rows);
+    e->accept();
+}
+
+void OrderListView::keyPressEvent(QKeyEvent* e)
+{
+    if (mCount == 0) {
+        QAbstractScrollArea::keyPressEvent(e);
+        return;
+    }
+
+    const quint64 cur = (mSelected == kNoRow) ? mTop : mSelected;
+    const quint64 page = pageRows();
+    if (e->matches(QKeySequence::Copy)) {
+        if (mSelected != kNoRow) QApplication::clipboard()->setText(textFor(mSelected));
+        return;
+    }
+
+    switch (e->key()) {
+    case Qt::Key_Up:       selectRow(cur > 0 ? cur - 1 : 0); break;
+    case Qt::Key_Down:     selectRow(cur + 1); break;
+    case Qt::Key_PageUp:   selectRow(cur > page ? cur - page : 0); break;
+    case Qt::Key_PageDown: selectRow(cur + std::min(page, mCount - cur)); break;
+    case Qt::Key_Home:     selectRow(0); break;
+    case Qt::Key_End:      selectRow(mCount - 1); break;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        if (mSelected != kNoRow) emit rowActivated(mSelected);
+        break;
+    default:
+        QAbstractScrollArea::keyPressEvent(e);
+        break;
+    }
+}
+
+void OrderListView::mousePressEvent(QMouseEvent* e)
+{
+    const quint64 row = rowAt(e->pos().y());
+    if (row != kNoRow) {
+        mSelected = row;
+        viewport()->update();
+    }
+    setFocus();
+}
+
+void OrderListView::mouseDoubleClickEvent(QMouseEvent* e)
+{
+    const quint64 row = rowAt(e->pos().y());
+    if (row != kNoRow) emit rowActivated(row);
+}
@@ -0,0 +1,75 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderListView.h
+@brief 虚拟列表：行数用 quint64 表示，每一行在绘制时才通过回调 index -> 文本 现取。
+
+为什么不用 QListView + 模型？
+- QAbstractItemModel 的行号是 int，最多约 21 亿行；拓扑序列的条数轻松超过这个数。
+- 滚动条的取值也是 int。这里自己维护“顶行下标”(quint64)，行数不多时滚动条一格一行，
+  行数超过滚动条范围时按比例映射（拖动滚动条是粗定位，滚轮/方向键/跳转仍然逐行精确）。
+
+只绘制可见的十几行；最近取过的行文字放在一个小缓存里，来回滚动不用重复解码。
+*/
+
+#pragma once
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QString>
+#include <functional>
+
+class OrderListView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    using RowText = std::function<QString(quint64 index)>;
+    static constexpr quint64 kNoRow = ~quint64(0);
+
+    explicit OrderListView(QWidget* parent = nullptr);
+
+    // 换数据源：共 count 行，第 i 行的文字由 text(i) 给出。count 为 0 时显示占位文字。
+    void setSource(quint64 count, RowText text);
+    void clear();
+    quint64 count() const { return mCount; }
+
+    void setPlaceholderText(const QString& text);
+
+    // 高亮“当前正在播放”的那一行（kNoRow 表示不高亮）。
+    void setCurrentRow(quint64 row);
+    quint64 selectedRow() const { return mSelected; }
+
+    // 把第 row 行滚到可见区域内（尽量放在中间）并选中它。
+    void scrollToRow(quint64 row);
+
+signals:
+    void rowActivated(quint64 row);   // 双击或回车
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    void resizeEvent(QResizeEvent* e) override;
+    void wheelEvent(QWheelEvent* e) override;
+    void keyPressEvent(QKeyEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseDoubleClickEvent(QMouseEvent* e) override;
+
+private:
+    quint64 mCount = 0;
+    RowText mText;
+    quint64 mTop = 0;              // 顶行下标
+    quint64 mSelected = kNoRow;
+    quint64 mCurrent = kNoRow;
+    QString mPlaceholder;
+    mutable QCache<quint64, QString> mCache;
+    bool mSyncingBar = false;
+    int mWheelRemainder = 0;       // 触控板的小幅滚动累积到一行再滚
+
+    int rowHeight() const;
+    quint64 pageRows() const;      // 一屏能完整放下的行数（至少 1）
+    quint64 maxTop() const;
+    quint64 rowAt(int y) const;    // 视口 y 坐标对应的行，超出返回 kNoRow
+    QString textFor(quint64 row) const;
+
+    void setTop(quint64 top);
+    void scrollByRows(qint64 delta);
+    void selectRow(quint64 row);   // 选中并保证可见
+    void syncScrollBar();
+    void onBarMoved(int value);
+};
@@ -0,0 +1,96 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderPrefetcher.cpp
+@brief 预取工作线程：解码序列、求公共前缀、把分歧后缀的步骤录进 StepTape。
+*/
+
+#include "OrderPrefetcher.h"
+#include "TopoKahn.h"
+#include "Trace.h"
+
+void OrderPrefetcher::start(std::shared_ptr<const Graph> dag, const TopoRank* rank, std::uint64_t first,
+                            std::vector<int> baseOrder, std::uint64_t baseIndex, int ahead)
+{
+    stop();
+    mDag = std::move(dag);
+    mRank = rank;
+    mAhead = ahead;
+    mStop = false;
+    if (!mDag || !mRank || ahead <= 0) return;
+    mThread = std::thread(&OrderPrefetcher::run, this, first, std::move(baseOrder), baseIndex);
+}
+
+void OrderPrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    if (mThread.joinable()) mThread.join();
+    mReady.clear();
+}
+
+bool OrderPrefetcher::take(std::uint64_t index, Prepared& out)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mReady.empty() || mReady.front().index != index) return false;
+        out = std::move(mReady.front());
+        mReady.pop_front();
+    }
+    mWake.notify_all();
+    return true;
+}
+
+void OrderPrefetcher::run(std::uint64_t next, std::vector<int> baseOrder, std::uint64_t baseIndex)
+{
+    const std::uint64_t total = mRank->count();
+    while (next < total) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this]() { return mStop || (int)mReady.size() < mAhead; });
+            if (mStop) return;
+        }
+
+        std::vector<int> order = mRank->orderAt(next);
+        if (order.empty()) return;
+        Prepared p = prepare(next, order, baseOrder, baseIndex);
+        if (mStop) return;   // 后缀可能没录完
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mReady.push_back(std::move(p));
+        }
+        baseOrder = std::move(order);
+        baseIndex = next;
+        ++next;
+    }
+}
+
+OrderPrefetcher::Prepared OrderPrefetcher::prepare(std::uint64_t index, std::vector<int> order,
+                                                   const std::vector<int>& baseOrder, std::uint64_t baseIndex) const
+{
+    TRACE_SCOPE("OrderPrefetcher::prepare");
+    const int n = mDag->n;
+    Prepared p;
+    p.index = index;
+
+    // 公共前缀；与 base 完全相同（只有一条序列、循环回来时）就整条从头演示。
+    if (baseIndex != kNoBase && (int)baseOrder.size() == n) {
+        int d = 0;
+        while (d < n && baseOrder[d] == order[d]) ++d;
+        if (d < n) {
+            p.baseIndex = baseIndex;
+            p.depth = d;
+        }
+    }
+
+    auto stepper = std::make_unique<KahnOrderStepper>(*mDag, order, p.depth);
+    p.skipped = stepper->skippedSteps();
+    auto tape = std::make_shared<StepTape>(std::move(stepper));
+    Step s;
+    while (!mStop.load(std::memory_order_relaxed) && tape->next(s)) {}
+    p.suffix = std::move(tape);
+    p.order = std::move(order);
+    return p;
+}
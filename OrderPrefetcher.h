@@ -0,0 +1,74 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderPrefetcher.h
+@brief 后台预取：正在演示一条拓扑序列时，工作线程先把后面几条的步骤准备好。
+
+“播放下一条”要做的事：按下标解码出序列（TopoRank::orderAt，大 DAG 上要查很多次记忆化表）、
+求它与上一条的公共前缀、生成分歧后缀的全部步骤。这些都与界面无关，放到工作线程里提前做，
+轮到它时界面线程只需把现成的后缀接到时间轴上（见 Timeline::branch）。
+
+流水线：
+- start(first, base) 之后，工作线程依次准备 first, first+1, ... 条，最多领先 ahead 条，
+  每条都相对“它的前一条”求公共前缀（第一条相对 base，也就是正在时间轴上的那条）；
+- take(index) 取走准备好的一条，工作线程随即补上下一条；
+- 界面跳到别的序列（双击列表）时 take 对不上，调用方现算这一条并从它之后重新 start。
+
+准备好的后缀以 StepTape（16 字节记录）存放；编译成 VisualOp 仍在界面线程、取步时做（每步一个 switch，
+不需要在线程间传递场景的边表）。
+
+纯逻辑模块，不含 Qt 类型（Step 里的 QString 除外）。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "StepTrace.h"
+#include "TopoRank.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class OrderPrefetcher {
+public:
+    static constexpr std::uint64_t kNoBase = ~std::uint64_t(0);
+
+    struct Prepared {
+        std::uint64_t index = 0;
+        std::vector<int> order;
+        std::uint64_t baseIndex = kNoBase;        // 公共前缀是相对哪一条求的
+        int depth = -1;                           // 与 base 共享前 depth 个输出；-1 表示整条从头
+        std::size_t skipped = 0;                  // 共享前缀对应的步数（后缀从整条 trace 的这一步开始）
+        std::shared_ptr<const StepTape> suffix;   // 第 skipped 步往后的全部步
+    };
+
+    ~OrderPrefetcher() { stop(); }
+
+    // 在后台准备第 first 条起的序列，最多领先 ahead 条。baseOrder/baseIndex 是 first 的前一条（可为空 / kNoBase）。
+    // rank 在 stop() 之前不得修改；dag 由预取器共享持有。
+    void start(std::shared_ptr<const Graph> dag, const TopoRank* rank, std::uint64_t first,
+               std::vector<int> baseOrder, std::uint64_t baseIndex, int ahead);
+    void stop();
+    bool running() const { return mThread.joinable(); }
+
+    // 取走第 index 条（已准备好才有，否则返回 false，不等待）。
+    bool take(std::uint64_t index, Prepared& out);
+
+private:
+    std::shared_ptr<const Graph> mDag;
+    const TopoRank* mRank = nullptr;
+    int mAhead = 0;
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<Prepared> mReady;
+    std::atomic<bool> mStop{false};
+
+    void run(std::uint64_t next, std::vector<int> baseOrder, std::uint64_t baseIndex);
+    Prepared prepare(std::uint64_t index, std::vector<int> order,
+                     const std::vector<int>& baseOrder, std::uint64_t baseIndex) const;
+};
@@ -0,0 +1,311 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderStream.cpp
+@brief 导出格式的编码（OrderWriter）与解码/稀疏索引（OrderReader）。
+*/
+
+#include "OrderStream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const char kMagic[8] = {'T', 'O', 'P', 'O', 'O', 'R', 'D', '\1'};
+
+void putLE(std::string& buf, std::uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) buf.push_back(char((v >> (8 * i)) & 0xff));
+}
+
+std::uint32_t getLE(const std::uint8_t* p, int bytes)
+{
+    std::uint32_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= std::uint32_t(p[i]) << (8 * i);
+    return v;
+}
+
+void putVarint(std::string& buf, std::uint32_t v)
+{
+    while (v >= 0x80) {
+        buf.push_back(char((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(char(v));
+}
+
+bool getVarint(const std::uint8_t* data, std::size_t size, std::size_t& pos, std::uint32_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= size) return false;
+        const std::uint8_t b = data[pos++];
+        v |= std::uint32_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+void putDecimal(std::string& buf, int v)
+{
+    char tmp[12];
+    int len = 0;
+    unsigned u = unsigned(v);
+    do {
+        tmp[len++] = char('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (len) buf.push_back(tmp[--len]);
+}
+} // namespace
+
+// ---------------- OrderWriter ----------------
+
+OrderWriter::OrderWriter(OrderFormat format, int n, WriteFn write)
+    : mFormat(format)
+    , mN(n)
+    , mWidth(n < 0x10000 ? 2 : 4)
+    , mWrite(std::move(write))
+{
+    mBuf.reserve(kBufferBytes + 64);
+}
+
+bool OrderWriter::begin()
+{
+    mWritten = 0;
+    mPrev.clear();
+    if (mFormat == OrderFormat::Text) return true;
+
+    mBuf.append(kMagic, sizeof(kMagic));
+    mBuf.push_back(char(mFormat));
+    mBuf.push_back(char(mFormat == OrderFormat::Binary ? mWidth : 0));
+    putLE(mBuf, 0, 2);
+    putLE(mBuf, std::uint32_t(mN), 4);
+    return true;
+}
+
+void OrderWriter::resume(std::uint64_t written, const std::vector<int>& last)
+{
+    mWritten = written;
+    mPrev = last;
+}
+
+bool OrderWriter::put(const std::vector<int>& order, int changedFrom)
+{
+    if (mFailed || (int)order.size() != mN) return false;
+
+    switch (mFormat) {
+    case OrderFormat::Text:
+        for (int i = 0; i < mN; ++i) {
+            if (i) mBuf.push_back(' ');
+            putDecimal(mBuf, order[std::size_t(i)]);
+        }
+        mBuf.push_back('\n');
+        break;
+
+    case OrderFormat::Binary:
+        for (int v : order) putLE(mBuf, std::uint32_t(v), mWidth);
+        break;
+
+    case OrderFormat::Delta: {
+        // 同步点（以及没有上一条可比时）写完整序列。
+        int shared = std::max(0, std::min(changedFrom, mN));
+        if (mWritten % kSyncEvery == 0 || (int)mPrev.size() != mN) shared = 0;
+        putVarint(mBuf, std::uint32_t(shared));
+        for (int i = shared; i < mN; ++i) putVarint(mBuf, std::uint32_t(order[std::size_t(i)]));
+        if ((int)mPrev.size() != mN) mPrev.assign(std::size_t(mN), 0);
+        std::copy(order.begin() + shared, order.end(), mPrev.begin() + shared);
+        break;
+    }
+    }
+
+    ++mWritten;
+    return maybeFlush();
+}
+
+bool OrderWriter::flush()
+{
+    if (mFailed) return false;
+    if (mBuf.empty()) return true;
+    if (!mWrite || !mWrite(mBuf.data(), mBuf.size())) {
+        mFailed = true;
+        return false;
+    }
+    mBytesOut += mBuf.size();
+    mBuf.clear();
+    return true;
+}
+
+// ---------------- OrderReader ----------------
+
+bool OrderReader::open(const std::uint8_t* data, std::size_t size, TaskControl* ctl)
+{
+    mData = data;
+    mSize = size;
+    mN = 0;
+    mWidth = 0;
+    mCount = 0;
+    mValidBytes = 0;
+    mIndex.clear();
+
+    const bool headed = size >= kOrderHeaderBytes && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+    if (!headed) {
+        // Text：n 取第一行的数字个数；只数换行，每 kIndexEvery 行记一个偏移。
+        mFormat = OrderFormat::Text;
+        const std::uint8_t* nl = static_cast<const std::uint8_t*>(std::memchr(data, '\n', size));
+        if (!nl) return true;
+        bool inNum = false;
+        for (const std::uint8_t* p = data; p < nl; ++p) {
+            const bool digit = (*p >= '0' && *p <= '9');
+            if (digit && !inNum) ++mN;
+            inNum = digit;
+        }
+
+        std::size_t pos = 0;
+        while (pos < size) {
+            const void* hit = std::memchr(data + pos, '\n', size - pos);
+            if (!hit) break;
+            if (mCount % kIndexEvery == 0) mIndex.push_back(pos);
+            pos = std::size_t(static_cast<const std::uint8_t*>(hit) - data) + 1;
+            ++mCount;
+            if (ctl && !ctl->tick()) return false;
+        }
+        mValidBytes = pos;
+        return true;
+    }
+
+    const std::uint8_t fmt = data[8];
+    mN = int(getLE(data + 12, 4));
+    mValidBytes = kOrderHeaderBytes;
+
+    if (fmt == std::uint8_t(OrderFormat::Binary)) {
+        mFormat = OrderFormat::Binary;
+        mWidth = data[9];
+        if (mWidth != 2 && mWidth != 4) return false;
+        if (mN <= 0) return true;
+        const std::size_t rec = std::size_t(mN) * std::size_t(mWidth);
+        mCount = (size - kOrderHeaderBytes) / rec;
+        mValidBytes = kOrderHeaderBytes + std::size_t(mCount) * rec;
+        return true;
+    }
+
+    if (fmt == std::uint8_t(OrderFormat::Delta)) {
+        mFormat = OrderFormat::Delta;
+        // n 来自文件头，不可信：一条完整序列每个点至少占 1 字节，放不下一条的 n 不按它分配。
+        // 只有文件头（还没写进任何序列）时仍算合法的空文件。
+        if (mN > 0 && std::size_t(mN) > size - kOrderHeaderBytes) return size == kOrderHeaderBytes;
+        std::vector<int> cur(std::size_t(std::max(0, mN)), 0);
+        std::size_t pos = kOrderHeaderBytes;
+        while (pos < size) {
+            const std::size_t start = pos;
+            // 同步点必须是完整序列，否则视为损坏，停在这里。
+            if (mCount % kIndexEvery == 0) {
+                std::uint32_t shared = 0;
+                std::size_t peek = pos;
+                if (!getVarint(data, size, peek, shared) || shared != 0) break;
+            }
+            if (!parseDelta(pos, cur)) break;
+            if (mCount % kIndexEvery == 0) mIndex.push_back(start);
+            ++mCount;
+            mValidBytes = pos;
+            if (ctl && !ctl->tick()) return false;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool OrderReader::parseText(std::size_t& pos, std::vector<int>* out) const
+{
+    if (out) out->clear();
+    long long v = -1;
+    while (pos < mSize && mData[pos] != '\n') {
+        const std::uint8_t c = mData[pos++];
+        if (c >= '0' && c <= '9') {
+            v = (v < 0 ? 0 : v * 10) + (c - '0');
+        } else if (v >= 0) {
+            if (out) out->push_back(int(v));
+            v = -1;
+        }
+    }
+    if (pos >= mSize) return false;
+    if (v >= 0 && out) out->push_back(int(v));
+    ++pos; // 跳过 '\n'
+    return true;
+}
+
+bool OrderReader::parseDelta(std::size_t& pos, std::vector<int>& cur) const
+{
+    std::uint32_t shared = 0;
+    std::size_t p = pos;
+    if (!getVarint(mData, mSize, p, shared) || shared > std::uint32_t(mN)) return false;
+    for (int i = int(shared); i < mN; ++i) {
+        std::uint32_t v = 0;
+        if (!getVarint(mData, mSize, p, v)) return false;
+        cur[std::size_t(i)] = int(v);
+    }
+    pos = p;
+    return true;
+}
+
+bool OrderReader::orderAt(std::uint64_t index, std::vector<int>& out) const
+{
+    if (index >= mCount) return false;
+
+    switch (mFormat) {
+    case OrderFormat::Binary: {
+        const std::size_t rec = std::size_t(mN) * std::size_t(mWidth);
+        const std::uint8_t* p = mData + kOrderHeaderBytes + std::size_t(index) * rec;
+        out.resize(std::size_t(mN));
+        for (int i = 0; i < mN; ++i) out[std::size_t(i)] = int(getLE(p + std::size_t(i) * mWidth, mWidth));
+        return true;
+    }
+    case OrderFormat::Text: {
+        std::size_t pos = mIndex[std::size_t(index / kIndexEvery)];
+        for (std::uint64_t k = index % kIndexEvery; k > 0; --k) {
+            const void* hit = std::memchr(mData + pos, '\n', mSize - pos);
+            pos = std::size_t(static_cast<const std::uint8_t*>(hit) - mData) + 1;
+        }
+        return parseText(pos, &out);
+    }
+    case OrderFormat::Delta: {
+        std::size_t pos = mIndex[std::size_t(index / kIndexEvery)];
+        out.assign(std::size_t(mN), 0);
+        for (std::uint64_t k = index % kIndexEvery + 1; k > 0; --k) {
+            if (!parseDelta(pos, out)) return false;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+std::uint64_t OrderReader::copyTo(OrderSink& sink, TaskControl* ctl) const
+{
+    std::vector<int> cur;
+    std::vector<int> prev;
+    std::size_t pos = (mFormat == OrderFormat::Text) ? 0 : kOrderHeaderBytes;
+    if (mFormat == OrderFormat::Delta) cur.assign(std::size_t(mN), 0);
+
+    std::uint64_t out = 0;
+    for (; out < mCount; ++out) {
+        bool ok = true;
+        switch (mFormat) {
+        case OrderFormat::Binary: ok = orderAt(out, cur); break;
+        case OrderFormat::Text: ok = parseText(pos, &cur); break;
+        case OrderFormat::Delta: ok = parseDelta(pos, cur); break;
+        }
+        if (!ok) break;
+
+        // 与上一条的公共前缀：写端靠它压缩 Delta，记录里的前缀长度在同步点上是 0，不能直接用。
+        int same = 0;
+        if (prev.size() == cur.size()) {
+            while (same < (int)cur.size() && prev[std::size_t(same)] == cur[std::size_t(same)]) ++same;
+        }
+        if (!sink.put(cur, same)) break;
+        prev = cur;
+        if (ctl && !ctl->tick(std::uint64_t(std::max(1, mN)))) {
+            ++out;
+            break;
+        }
+    }
+    return out;
+}
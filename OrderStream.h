@@ -0,0 +1,118 @@
+/* ANNOTATED_FOR_STUDY
+@file OrderStream.h
+@brief 拓扑序列的落盘格式：边枚举边写（OrderWriter），以及对导出文件的随机访问（OrderReader）。
+
+三种格式：
+- Text   : 每行一条，节点编号用空格分隔；无文件头，方便直接拿去给别的工具用。
+- Binary : 16 字节文件头 + 定长记录（每个节点 2 或 4 字节小端）；第 i 条在 header + i*n*width，
+           可以 O(1) 随机访问。
+- Delta  : 文件头 + 变长记录：varint(与上一条相同的前缀长度) + 剩余后缀的 varint。
+           字典序相邻的拓扑序列前缀大多相同，体积通常只有 Binary 的几分之一。
+           每 kSyncEvery 条强制写一次完整序列（前缀长度 0），读的时候可以从最近的同步点解码，
+           不必从头扫。
+
+OrderWriter 只在内存里攒一个固定大小的缓冲区，满了就交给调用方提供的 write 回调，
+内存与已写条数无关；断点续写时 resume() 接着上一次的最后一条继续。
+
+OrderReader 只读调用方给的一段内存（通常是 QFile::map 的结果），打开时扫一遍建稀疏索引
+（每 kIndexEvery 条记一个偏移），之后按下标取任意一条。文件尾部不完整的记录（导出被中断）
+会被忽略，validBytes() 给出完整记录结束的位置，续写前截断到这里即可。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "TaskControl.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class OrderFormat : std::uint8_t { Text = 0, Binary = 1, Delta = 2 };
+
+// 枚举端只认这个接口：拿到一条就交出去。changedFrom = 与上一条相同的前缀长度。
+class OrderSink {
+public:
+    virtual ~OrderSink() = default;
+    virtual bool put(const std::vector<int>& order, int changedFrom) = 0;
+    // 存检查点前调用：把已交出的全部落盘，保证检查点之前的数据都在文件里。
+    virtual bool flush() { return true; }
+};
+
+class OrderWriter : public OrderSink {
+public:
+    using WriteFn = std::function<bool(const char* data, std::size_t len)>;
+
+    static constexpr std::size_t kBufferBytes = std::size_t(1) << 20;
+    static constexpr std::uint64_t kSyncEvery = 1024;
+
+    OrderWriter(OrderFormat format, int n, WriteFn write);
+
+    // 新文件：写文件头（Text 没有文件头）。
+    bool begin();
+    // 续写：文件里已有 written 条，最后一条是 last（Delta 要靠它算前缀）。不写文件头。
+    void resume(std::uint64_t written, const std::vector<int>& last);
+
+    bool put(const std::vector<int>& order, int changedFrom) override;
+    bool flush() override;
+
+    std::uint64_t written() const { return mWritten; }     // 文件里的总条数（含续写前的）
+    std::uint64_t bytesOut() const { return mBytesOut; }   // 本次写出的字节数
+    bool failed() const { return mFailed; }
+
+private:
+    OrderFormat mFormat;
+    int mN;
+    int mWidth;                      // Binary 每个节点的字节数
+    WriteFn mWrite;
+    std::string mBuf;
+    std::vector<int> mPrev;          // Delta：上一条
+    std::uint64_t mWritten = 0;
+    std::uint64_t mBytesOut = 0;
+    bool mFailed = false;
+
+    bool maybeFlush() { return mBuf.size() < kBufferBytes || flush(); }
+};
+
+class OrderReader {
+public:
+    static constexpr std::uint64_t kIndexEvery = OrderWriter::kSyncEvery;
+
+    // 解析 data[0, size)；ctl 非空时可被取消（返回 false）。格式无法识别也返回 false。
+    bool open(const std::uint8_t* data, std::size_t size, TaskControl* ctl = nullptr);
+
+    OrderFormat format() const { return mFormat; }
+    int nodeCount() const { return mN; }
+    std::uint64_t count() const { return mCount; }
+    std::size_t validBytes() const { return mValidBytes; }
+
+    // 第 index 条；越界返回 false。
+    bool orderAt(std::uint64_t index, std::vector<int>& out) const;
+
+    // 从第 0 条起顺序解码全部记录交给 sink（Delta 不必每条都回到同步点，比逐条 orderAt 快得多）。
+    // 返回交出的条数；sink 拒收或 ctl 要求停止时提前返回。
+    std::uint64_t copyTo(OrderSink& sink, TaskControl* ctl = nullptr) const;
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::size_t mSize = 0;
+    OrderFormat mFormat = OrderFormat::Text;
+    int mN = 0;
+    int mWidth = 0;
+    std::uint64_t mCount = 0;
+    std::size_t mValidBytes = 0;
+    std::vector<std::size_t> mIndex;   // Text/Delta：第 k*kIndexEvery 条的起始偏移
+
+    // 从 pos 解析一条，成功时返回 true 并把 pos 移到下一条开头。
+    bool parseText(std::size_t& pos, std::vector<int>* out) const;
+    bool parseDelta(std::size_t& pos, std::vector<int>& cur) const;
+};
+
+// 文件头（Binary / Delta）：
+//   0..7   "TOPOORD\1"
+//   8      格式（1 = Binary, 2 = Delta）
+//   9      Binary 每节点字节数（2 或 4），Delta 为 0
+//   10..11 保留
+//   12..15 节点数 n（小端 uint32）
+constexpr std::size_t kOrderHeaderBytes = 16;
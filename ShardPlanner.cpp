@@ -0,0 +1,186 @@
+/* ANNOTATED_FOR_STUDY
+@file ShardPlanner.cpp
+@brief 分片规划：按前缀拆搜索树，Knuth 随机路径估计子树大小。
+*/
+
+#include "ShardPlanner.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace {
+constexpr double kNegInf = -std::numeric_limits<double>::infinity();
+
+// log(e^a + e^b)，不溢出。
+double logAdd(double a, double b)
+{
+    if (a == kNegInf) return b;
+    if (b == kNegInf) return a;
+    const double hi = std::max(a, b);
+    return hi + std::log1p(std::exp(std::min(a, b) - hi));
+}
+} // namespace
+
+void ShardPlanner::reset(const Graph& dag)
+{
+    mN = dag.n;
+    mSucc.assign(std::size_t(mN) + 1, {});
+    mIndeg.assign(std::size_t(mN) + 1, 0);
+    for (int u = 1; u <= mN; ++u) {
+        for (int v : dag.adj[std::size_t(u)]) {
+            mSucc[std::size_t(u)].push_back(v);
+            mIndeg[std::size_t(v)]++;
+        }
+    }
+}
+
+// 把 prefix 依次输出后的状态：剩余入度 + 当前候选（无序）。prefix 不合法返回 false。
+static bool applyPrefix(const std::vector<std::vector<int>>& succ, std::vector<int>& indeg,
+                        const std::vector<int>& prefix, std::vector<int>& avail)
+{
+    const int n = int(indeg.size()) - 1;
+    std::vector<char> used(indeg.size(), 0);
+    for (int u : prefix) {
+        if (u < 1 || u > n || used[std::size_t(u)] || indeg[std::size_t(u)] != 0) return false;
+        used[std::size_t(u)] = 1;
+        for (int v : succ[std::size_t(u)]) indeg[std::size_t(v)]--;
+    }
+    avail.clear();
+    for (int v = 1; v <= n; ++v) {
+        if (!used[std::size_t(v)] && indeg[std::size_t(v)] == 0) avail.push_back(v);
+    }
+    return true;
+}
+
+std::vector<int> ShardPlanner::candidatesAfter(const std::vector<int>& prefix) const
+{
+    std::vector<int> indeg = mIndeg;
+    std::vector<int> avail;
+    if (!applyPrefix(mSucc, indeg, prefix, avail)) return {};
+    return avail;   // applyPrefix 按编号顺序收集，本身就是升序
+}
+
+double ShardPlanner::sampleEstimate(const std::vector<int>& prefix, int samples, std::uint64_t seed) const
+{
+    std::vector<int> baseIndeg = mIndeg;
+    std::vector<int> baseAvail;
+    if (!applyPrefix(mSucc, baseIndeg, prefix, baseAvail)) return kNegInf;
+
+    const int remaining = mN - int(prefix.size());
+    std::mt19937_64 rng(seed);
+    std::vector<int> indeg;
+    std::vector<int> avail;
+    double logSum = kNegInf;
+    samples = std::max(1, samples);
+    for (int s = 0; s < samples; ++s) {
+        indeg = baseIndeg;
+        avail = baseAvail;
+        double logProd = 0;
+        int placed = 0;
+        while (!avail.empty()) {
+            logProd += std::log(double(avail.size()));
+            const std::size_t k = std::size_t(rng() % avail.size());
+            const int u = avail[k];
+            avail[k] = avail.back();
+            avail.pop_back();
+            ++placed;
+            for (int v : mSucc[std::size_t(u)]) {
+                if (--indeg[std::size_t(v)] == 0) avail.push_back(v);
+            }
+        }
+        // 走进死路（有环）的路径对应 0 条序列。
+        if (placed == remaining) logSum = logAdd(logSum, logProd);
+    }
+    return logSum - std::log(double(samples));
+}
+
+std::vector<Shard> ShardPlanner::plan(int targetShards, const Estimator& est, TaskControl* ctl) const
+{
+    targetShards = std::max(1, targetShards);
+    const Estimator estimate = est ? est : [this](const std::vector<int>& p) { return sampleEstimate(p); };
+
+    std::vector<Shard> shards{{{}, estimate({})}};
+    const double limit = shards[0].logEstimate - std::log(double(targetShards));
+    const std::size_t maxShards = std::size_t(targetShards) * kMaxOversplit;
+
+    std::vector<char> leaf(1, 0);   // [i] = 这一片已经拆不动了
+    while (shards.size() < maxShards) {
+        if (ctl && !ctl->tick()) return {};
+
+        // 估计最大、还能拆的那一片；只剩 1 条的没必要拆。
+        std::size_t pick = shards.size();
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            if (leaf[i] || shards[i].logEstimate <= 0) continue;
+            if (pick == shards.size() || shards[i].logEstimate > shards[pick].logEstimate) pick = i;
+        }
+        if (pick == shards.size()) break;
+        if (shards.size() >= std::size_t(targetShards) && shards[pick].logEstimate <= limit) break;
+
+        // 只有一个候选的位置不产生分支，直接并进前缀（估计值不变），一次走到下一个分叉点。
+        std::vector<int> prefix = shards[pick].prefix;
+        std::vector<int> indeg = mIndeg;
+        std::vector<int> avail;
+        applyPrefix(mSucc, indeg, prefix, avail);
+        while (avail.size() == 1) {
+            const int u = avail[0];
+            avail.clear();
+            prefix.push_back(u);
+            for (int v : mSucc[std::size_t(u)]) {
+                if (--indeg[std::size_t(v)] == 0) avail.push_back(v);
+            }
+        }
+        if (avail.empty()) {
+            leaf[pick] = 1;
+            continue;
+        }
+        std::sort(avail.begin(), avail.end());
+
+        std::vector<Shard> children;
+        for (int u : avail) {
+            Shard c;
+            c.prefix = prefix;
+            c.prefix.push_back(u);
+            c.logEstimate = estimate(c.prefix);
+            children.push_back(std::move(c));
+        }
+        shards[pick] = std::move(children.front());
+        for (std::size_t i = 1; i < children.size(); ++i) {
+            shards.push_back(std::move(children[i]));
+            leaf.push_back(0);
+        }
+    }
+
+    // 前缀两两不互为前缀，字典序就是它们在完整枚举结果里的先后顺序。
+    std::sort(shards.begin(), shards.end(),
+              [](const Shard& a, const Shard& b) { return a.prefix < b.prefix; });
+    return shards;
+}
+
+std::string ShardPlanner::prefixToString(const std::vector<int>& prefix)
+{
+    if (prefix.empty()) return "-";
+    std::ostringstream os;
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        if (i) os << ',';
+        os << prefix[i];
+    }
+    return os.str();
+}
+
+bool ShardPlanner::prefixFromString(const std::string& text, std::vector<int>& prefix)
+{
+    prefix.clear();
+    if (text == "-") return true;
+    std::istringstream is(text);
+    std::string item;
+    while (std::getline(is, item, ',')) {
+        char* end = nullptr;
+        const long v = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || v < 1 || v > INT32_MAX) return false;
+        prefix.push_back(int(v));
+    }
+    return !prefix.empty();
+}
@@ -0,0 +1,62 @@
+/* ANNOTATED_FOR_STUDY
+@file ShardPlanner.h
+@brief 把“枚举全部拓扑序列”按固定前缀切成若干分片，交给多个独立进程并行跑，再按顺序拼回去。
+
+为什么按前缀切？
+- 回溯枚举（dfsAllTopo / TopoEnumerator）是按字典序走的：以同一个前缀开头的序列在结果里是连续的一段；
+- 所以只要分片的前缀两两互不为前缀、并且覆盖整棵搜索树，把分片按前缀的字典序排好、首尾相接，
+  就和单进程枚举的结果一模一样；每片的全局起始下标 = 它前面所有分片的条数之和。
+
+怎么切得均匀？
+- 每次把“估计最大”的那一片按下一位的候选点拆成若干子片，直到最大的一片不超过平均值，
+  或者片数到了上限；
+- 估计值：能精确计数时（TopoRank 计数成功）直接用精确值；否则用 Knuth 随机路径估计：
+  从前缀出发每一步随机选一个候选，把沿途的候选个数连乘，多次取平均——是子树大小的无偏估计。
+- 序列数动不动就超过 2^64，估计值一律用自然对数表示。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "TaskControl.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct Shard {
+    std::vector<int> prefix;       // 固定前缀
+    double logEstimate = 0;        // 估计条数的自然对数
+};
+
+class ShardPlanner {
+public:
+    // 返回以 prefix 开头的序列条数的对数估计；prefix 不合法时返回 -inf。
+    using Estimator = std::function<double(const std::vector<int>& prefix)>;
+
+    static constexpr int kDefaultSamples = 64;
+    static constexpr int kMaxOversplit = 8;     // 片数最多是目标的几倍
+
+    void reset(const Graph& dag);
+
+    // prefix 之后下一位可以选的点（升序）；prefix 不合法时为空。
+    std::vector<int> candidatesAfter(const std::vector<int>& prefix) const;
+
+    // Knuth 随机路径估计（对数）。seed 相同结果相同。
+    double sampleEstimate(const std::vector<int>& prefix, int samples = kDefaultSamples,
+                          std::uint64_t seed = 1) const;
+
+    // 切成大约 targetShards 片（至少 1 片），按字典序排好。est 为空时用 sampleEstimate。
+    // ctl 非空时可被取消（返回空）。
+    std::vector<Shard> plan(int targetShards, const Estimator& est = nullptr, TaskControl* ctl = nullptr) const;
+
+    // 前缀与命令行文本互转：“3,1,4”；空前缀是“-”。
+    static std::string prefixToString(const std::vector<int>& prefix);
+    static bool prefixFromString(const std::string& text, std::vector<int>& prefix);
+
+private:
+    int mN = 0;
+    std::vector<std::vector<int>> mSucc;
+    std::vector<int> mIndeg;
+};
@@ -0,0 +1,255 @@
+/* ANNOTATED_FOR_STUDY
+@file ShardWorker.cpp
+@brief 多进程分片导出的实现：QProcess 调度 + 顺序合并；子进程端只是 TopoEnumerator + OrderWriter。
+*/
+
+#include "ShardWorker.h"
+#include "TopoEnumerator.h"
+#include "TopoKahn.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <memory>
+
+bool writeDagFile(const QString& path, const Graph& dag)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+    QTextStream ts(&f);
+    ts << dag.n << ' ' << dag.edges.size() << '\n';
+    for (const auto& e : dag.edges) ts << e.first << ' ' << e.second << '\n';
+    ts.flush();
+    return ts.status() == QTextStream::Ok;
+}
+
+bool readDagFile(const QString& path, Graph& dag)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    QTextStream ts(&f);
+    int n = -1;
+    qint64 m = -1;
+    ts >> n >> m;
+    if (ts.status() != QTextStream::Ok || n < 0 || m < 0) return false;
+    dag = Graph(n);
+    for (qint64 i = 0; i < m; ++i) {
+        int u = 0, v = 0;
+        ts >> u >> v;
+        if (ts.status() != QTextStream::Ok || u < 1 || u > n || v < 1 || v > n) return false;
+        dag.addEdge(u, v);
+    }
+    return true;
+}
+
+// ---------------- 工作端 ----------------
+
+int runShardWorker(int argc, char* argv[])
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (argc != 6) {
+        err << "usage: " << argv[0] << " --shard-worker <dag file> <prefix> <format> <output>\n";
+        return 2;
+    }
+
+    Graph dag;
+    if (!readDagFile(QString::fromLocal8Bit(argv[2]), dag)) {
+        err << "cannot read DAG file " << argv[2] << '\n';
+        return 2;
+    }
+    std::vector<int> prefix;
+    TopoEnumerator it;
+    it.reset(dag);
+    if (!ShardPlanner::prefixFromString(argv[3], prefix) || !it.restrictToPrefix(prefix)) {
+        err << "invalid prefix " << argv[3] << '\n';
+        return 2;
+    }
+    const int format = QString::fromLatin1(argv[4]).toInt();
+    if (format < int(OrderFormat::Text) || format > int(OrderFormat::Delta)) {
+        err << "invalid format " << argv[4] << '\n';
+        return 2;
+    }
+
+    QFile file(QString::fromLocal8Bit(argv[5]));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "cannot open " << argv[5] << ": " << file.errorString() << '\n';
+        return 1;
+    }
+    OrderWriter writer(OrderFormat(format), dag.n, [&file](const char* data, std::size_t len) {
+        return file.write(data, qint64(len)) == qint64(len);
+    });
+    writer.begin();
+
+    // 借检查点回调定期报进度（回调前 writer 已 flush，报出去的条数都已经在文件里）。
+    auto progress = [&out](const TopoEnumerator& e) {
+        out << "progress " << e.emitted() << '\n';
+        out.flush();
+        return true;
+    };
+    TopoKahn().streamFrom(it, writer, nullptr, progress, std::chrono::seconds(1));
+    if (!writer.flush() || !file.flush()) {
+        err << "write failed: " << file.errorString() << '\n';
+        return 1;
+    }
+    out << "done " << writer.written() << '\n';
+    out.flush();
+    return 0;
+}
+
+// ---------------- 协调端 ----------------
+
+namespace {
+struct Running {
+    std::unique_ptr<QProcess> proc;
+    std::size_t shard = 0;
+    quint64 progress = 0;
+    bool done = false;
+};
+
+void killAll(std::vector<Running>& running)
+{
+    for (Running& r : running) {
+        r.proc->kill();
+        r.proc->waitForFinished(1000);
+    }
+    running.clear();
+}
+
+// 读完子进程 stdout 里已有的整行；返回本次新增的进度。
+quint64 drain(Running& r, ShardReport& report)
+{
+    quint64 added = 0;
+    while (r.proc->canReadLine()) {
+        const QByteArray line = r.proc->readLine().trimmed();
+        const int sp = line.indexOf(' ');
+        if (sp < 0) continue;
+        const QByteArray key = line.left(sp);
+        const quint64 value = line.mid(sp + 1).toULongLong();
+        if (value > r.progress) {
+            added += value - r.progress;
+            r.progress = value;
+        }
+        if (key == "done") {
+            r.done = true;
+            report.counts[r.shard] = value;
+        }
+    }
+    return added;
+}
+} // namespace
+
+bool runShardedExport(const ShardJob& job, TaskControl& ctl, ShardReport& report)
+{
+    report = ShardReport();
+    report.counts.assign(job.shards.size(), 0);
+
+    QTemporaryDir tmp;
+    const QString dagPath = tmp.filePath("dag.txt");
+    if (!tmp.isValid() || !writeDagFile(dagPath, job.dag)) {
+        report.error = QObject::tr("无法创建临时目录");
+        return false;
+    }
+    auto partPath = [&tmp](std::size_t i) { return tmp.filePath(QString("shard-%1.part").arg(i)); };
+
+    // 1) 子进程阶段：最多同时跑 processes 个，跑完一个补一个。
+    QElapsedTimer clock;
+    clock.start();
+    std::vector<Running> running;
+    std::size_t next = 0;
+    while (next < job.shards.size() || !running.empty()) {
+        if (!ctl.tick()) {
+            killAll(running);
+            return false;
+        }
+        while ((int)running.size() < std::max(1, job.processes) && next < job.shards.size()) {
+            Running r;
+            r.shard = next;
+            r.proc = std::make_unique<QProcess>();
+            r.proc->start(job.program, {"--shard-worker", dagPath,
+                                        QString::fromStdString(ShardPlanner::prefixToString(job.shards[next].prefix)),
+                                        QString::number(int(job.format)), partPath(next)});
+            if (!r.proc->waitForStarted()) {
+                report.error = QObject::tr("无法启动子进程：%1").arg(r.proc->errorString());
+                killAll(running);
+                return false;
+            }
+            running.push_back(std::move(r));
+            ++next;
+        }
+
+        for (std::size_t i = 0; i < running.size();) {
+            Running& r = running[i];
+            r.proc->waitForFinished(running.size() > 1 ? 10 : 50);
+            ctl.addFound(drain(r, report));
+            if (r.proc->state() != QProcess::NotRunning) {
+                ++i;
+                continue;
+            }
+            ctl.addFound(drain(r, report));
+            if (r.proc->exitStatus() != QProcess::NormalExit || r.proc->exitCode() != 0 || !r.done) {
+                report.error = QObject::tr("第 %1 片（前缀 %2）失败：%3")
+                                   .arg(r.shard + 1)
+                                   .arg(QString::fromStdString(ShardPlanner::prefixToString(job.shards[r.shard].prefix)))
+                                   .arg(QString::fromLocal8Bit(r.proc->readAllStandardError()).trimmed());
+                killAll(running);
+                return false;
+            }
+            running.erase(running.begin() + std::ptrdiff_t(i));
+        }
+    }
+    report.enumerateMs = clock.restart();
+
+    // 2) 合并：按前缀顺序逐片解码、写进最终文件，同时记下每片的全局起始下标。
+    QFile out(job.outPath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        report.error = QObject::tr("无法打开文件：%1").arg(out.errorString());
+        return false;
+    }
+    OrderWriter writer(job.format, job.dag.n, [&out](const char* data, std::size_t len) {
+        return out.write(data, qint64(len)) == qint64(len);
+    });
+    writer.begin();
+
+    QString manifest = QString("# start\tcount\tprefix\n");
+    for (std::size_t i = 0; i < job.shards.size(); ++i) {
+        QFile part(partPath(i));
+        if (!part.open(QIODevice::ReadOnly)) {
+            report.error = QObject::tr("找不到第 %1 片的结果").arg(i + 1);
+            return false;
+        }
+        const quint64 start = writer.written();
+        if (part.size() > 0) {
+            uchar* data = part.map(0, part.size());
+            OrderReader reader;
+            const bool ok = data && reader.open(data, std::size_t(part.size()), &ctl)
+                            && reader.count() == report.counts[i]
+                            && (reader.count() == 0 || reader.nodeCount() == job.dag.n)
+                            && reader.copyTo(writer, &ctl) == reader.count();
+            if (data) part.unmap(data);
+            if (!ok) {
+                if (ctl.stopped()) return false;
+                report.error = writer.failed() ? QObject::tr("写文件失败：%1").arg(out.errorString())
+                                               : QObject::tr("第 %1 片的结果文件不完整").arg(i + 1);
+                return false;
+            }
+        }
+        part.close();
+        part.remove();   // 边合并边删，临时空间不会翻倍
+        manifest += QString("%1\t%2\t%3\n").arg(start).arg(report.counts[i])
+                        .arg(QString::fromStdString(ShardPlanner::prefixToString(job.shards[i].prefix)));
+    }
+    if (!writer.flush() || !out.flush()) {
+        report.error = QObject::tr("写文件失败：%1").arg(out.errorString());
+        return false;
+    }
+    report.total = writer.written();
+    report.bytes = writer.bytesOut();
+    report.mergeMs = clock.elapsed();
+
+    QFile list(job.outPath + ".shards");
+    if (list.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) list.write(manifest.toUtf8());
+    return true;
+}
@@ -0,0 +1,52 @@
+/* ANNOTATED_FOR_STUDY
+@file ShardWorker.h
+@brief 多进程分片导出：协调端（起子进程、收进度、按顺序合并）与工作端（子进程入口）。
+
+流程：
+1) ShardPlanner 把搜索树按前缀切成若干片（见 ShardPlanner.h）；
+2) 协调端把 DAG 写进临时目录，用 QProcess 以
+       <本程序> --shard-worker <dag 文件> <前缀> <格式> <输出文件>
+   的方式同时起最多 processes 个子进程，每个子进程只枚举自己那个前缀下的序列，写成独立的导出文件，
+   周期性往 stdout 打 “progress <条数>”，结束时打 “done <条数>”；
+3) 全部跑完后按前缀字典序把各片文件顺序解码、重新编码进最终文件（Delta 的同步点按全局下标重排），
+   第 i 片的全局起始下标 = 前 i 片条数之和；另写一份 “<输出文件>.shards” 清单：起始下标 / 条数 / 前缀。
+
+子进程之间不共享任何状态，同一台机器上就能完整地测试；换成别的机器跑只需要换掉启动方式。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "OrderStream.h"
+#include "ShardPlanner.h"
+#include "TaskControl.h"
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+struct ShardJob {
+    Graph dag;
+    std::vector<Shard> shards;     // 已按前缀字典序排好
+    OrderFormat format = OrderFormat::Binary;
+    QString outPath;
+    QString program;               // 子进程可执行文件（通常就是自己）
+    int processes = 1;
+};
+
+struct ShardReport {
+    QString error;
+    std::vector<quint64> counts;   // [i] = 第 i 片的条数
+    quint64 total = 0;
+    quint64 bytes = 0;             // 最终文件写出的字节数
+    qint64 enumerateMs = 0;        // 子进程阶段耗时
+    qint64 mergeMs = 0;
+};
+
+// 协调端：在调用线程里同步跑完（放在后台任务里调用）。ctl 被取消时杀掉所有子进程，返回 false。
+bool runShardedExport(const ShardJob& job, TaskControl& ctl, ShardReport& report);
+
+// 工作端：main() 看到 --shard-worker 时直接转到这里，返回值就是进程退出码。
+int runShardWorker(int argc, char* argv[]);
+
+// DAG 的临时文本格式：第一行 “n m”，之后 m 行 “u v”。
+bool writeDagFile(const QString& path, const Graph& dag);
+bool readDagFile(const QString& path, Graph& dag);
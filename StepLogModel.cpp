@@ -0,0 +1,229 @@
+/* ANNOTATED_FOR_STUDY
+@file StepLogModel.cpp
+@brief 日志模型实现：环形缓冲 + 按需格式化 + 增量过滤。
+*/
+
+#include "StepLogModel.h"
+#include <QBrush>
+#include <QColor>
+#include <algorithm>
+
+StepLogModel::StepLogModel(QObject* parent, int capacity)
+    : QAbstractListModel(parent)
+    , mCapacity(std::max(1, capacity))
+{
+    // 缓冲按需增长到容量为止（见 slotFor），日志短时不占容量那么多内存。
+}
+
+void StepLogModel::resetTrace(const QVector<Step>& steps)
+{
+    resetTrace(steps.size(), [steps](int i) { return steps[i]; });
+}
+
+void StepLogModel::resetTrace(int count, StepFetch fetch)
+{
+    beginResetModel();
+    // 只清还在缓冲里的行（放掉说明文字）；其余格子在重新写入前不会被读到。每播一条序列都会走这里。
+    for (qint64 seq = mFirstSeq; seq < mFirstSeq + mCount; ++seq) mRing[size_t(seq % mCapacity)] = Entry();
+    mTraceSize = count;
+    mFetch = std::move(fetch);
+    mCount = 0;
+    mFirstSeq = 0;
+    mVisible.clear();
+    endResetModel();
+}
+
+void StepLogModel::clear()
+{
+    resetTrace(QVector<Step>());
+}
+
+void StepLogModel::appendText(const QString& text)
+{
+    evictOldest(mCount + 1 - mCapacity);
+    Entry& e = slotFor(mFirstSeq + mCount);
+    e.step = -1;
+    e.text = text;
+    commitAppended(1);
+}
+
+void StepLogModel::appendSteps(int from, int to)
+{
+    from = std::max(from, 0);
+    to = std::min(to, mTraceSize);
+    if (to <= from) return;
+
+    // 一次追加超过容量时，前面那部分进来也会立刻被挤掉，直接跳过。
+    if (to - from > mCapacity) from = to - mCapacity;
+    const int k = to - from;
+
+    evictOldest(mCount + k - mCapacity);
+    const qint64 base = mFirstSeq + mCount;
+    for (int i = 0; i < k; ++i) {
+        Entry& e = slotFor(base + i);
+        e.step = from + i;
+        e.text = QString();
+    }
+    commitAppended(k);
+}
+
+StepLogModel::Entry& StepLogModel::slotFor(qint64 seq)
+{
+    // seq 从 0 起连续分配，缓冲没满时要写的格子至多比现有的多一个。
+    const size_t i = size_t(seq % mCapacity);
+    if (i >= mRing.size()) mRing.resize(i + 1);
+    return mRing[i];
+}
+
+void StepLogModel::evictOldest(int k)
+{
+    k = std::min(k, mCount);
+    if (k <= 0) return;
+
+    const qint64 limit = mFirstSeq + k;
+    if (!filtering()) {
+        beginRemoveRows(QModelIndex(), 0, k - 1);
+        mFirstSeq = limit;
+        mCount -= k;
+        endRemoveRows();
+        return;
+    }
+
+    // 过滤时只有通过过滤的那些行在视图里。
+    int r = 0;
+    while (r < (int)mVisible.size() && mVisible[size_t(r)] < limit) ++r;
+    if (r > 0) beginRemoveRows(QModelIndex(), 0, r - 1);
+    mVisible.erase(mVisible.begin(), mVisible.begin() + r);
+    mFirstSeq = limit;
+    mCount -= k;
+    if (r > 0) endRemoveRows();
+}
+
+void StepLogModel::commitAppended(int k)
+{
+    if (k <= 0) return;
+    const qint64 base = mFirstSeq + mCount;
+
+    if (!filtering()) {
+        beginInsertRows(QModelIndex(), mCount, mCount + k - 1);
+        mCount += k;
+        endInsertRows();
+        return;
+    }
+
+    mCount += k;
+    std::vector<qint64> hits;
+    for (qint64 seq = base; seq < base + k; ++seq) {
+        if (accepts(entryAt(seq))) hits.push_back(seq);
+    }
+    if (hits.empty()) return;
+
+    const int row = (int)mVisible.size();
+    beginInsertRows(QModelIndex(), row, row + (int)hits.size() - 1);
+    mVisible.insert(mVisible.end(), hits.begin(), hits.end());
+    endInsertRows();
+}
+
+void StepLogModel::setTypeFilter(quint32 mask)
+{
+    if (mask == mTypeMask) return;
+    mTypeMask = mask;
+    rebuildVisible();
+}
+
+void StepLogModel::setSearchText(const QString& text)
+{
+    if (text == mSearch) return;
+    mSearch = text;
+    rebuildVisible();
+}
+
+void StepLogModel::rebuildVisible()
+{
+    // 过滤条件变化是用户操作，整体扫一遍缓冲即可（最多 capacity 行）。
+    beginResetModel();
+    mVisible.clear();
+    if (filtering()) {
+        for (qint64 seq = mFirstSeq; seq < mFirstSeq + mCount; ++seq) {
+            if (accepts(entryAt(seq))) mVisible.push_back(seq);
+        }
+    }
+    endResetModel();
+}
+
+bool StepLogModel::accepts(const Entry& e) const
+{
+    const quint32 bit = (e.step >= 0) ? (1u << int(mFetch(e.step).type)) : kTextBit;
+    if (!(mTypeMask & bit)) return false;
+    return mSearch.isEmpty() || lineText(e).contains(mSearch, Qt::CaseInsensitive);
+}
+
+qint64 StepLogModel::seqForRow(int row) const
+{
+    return filtering() ? mVisible[size_t(row)] : mFirstSeq + row;
+}
+
+int StepLogModel::stepIndexAt(int row) const
+{
+    if (row < 0 || row >= rowCount()) return -1;
+    return entryAt(seqForRow(row)).step;
+}
+
+int StepLogModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    return filtering() ? (int)mVisible.size() : mCount;
+}
+
+QString StepLogModel::lineText(const Entry& e) const
+{
+    if (e.step < 0) return e.text;
+
+    const Step st = mFetch(e.step);
+    if (!st.note.isEmpty()) return QString("%1. %2").arg(e.step + 1).arg(st.note);
+
+    // 没写 note 的步骤：按类型和端点拼一行，保证每步在日志里都有落点。
+    QString s = QString("%1. [%2]").arg(e.step + 1).arg(typeName(st.type));
+    if (st.u >= 0) s += QString(" u=%1").arg(st.u);
+    if (st.v >= 0) s += QString(" v=%1").arg(st.v);
+    return s;
+}
+
+QVariant StepLogModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    const Entry& e = entryAt(seqForRow(index.row()));
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return lineText(e);
+    case Qt::ToolTipRole:
+        if (e.step < 0) return QVariant();
+        return QString("第 %1 步 · %2").arg(e.step + 1).arg(typeName(mFetch(e.step).type));
+    case Qt::ForegroundRole:
+        // 说明文字行用浅灰，和 step 行区分开。
+        if (e.step < 0) return QBrush(QColor("#6b7280"));
+        return QVariant();
+    case StepIndexRole:
+        return e.step;
+    default:
+        return QVariant();
+    }
+}
+
+QString StepLogModel::typeName(StepType t)
+{
+    switch (t) {
+    case StepType::ResetVisual:        return QString("重置");
+    case StepType::Visit:              return QString("访问");
+    case StepType::PushStack:          return QString("入栈");
+    case StepType::PopStack:           return QString("出栈");
+    case StepType::AssignSCC:          return QString("分配 SCC");
+    case StepType::BuildCondensedEdge: return QString("缩点建边");
+    case StepType::TopoInitIndeg:      return QString("初始化入度");
+    case StepType::TopoEnqueue:        return QString("入队");
+    case StepType::TopoDequeue:        return QString("出队");
+    case StepType::TopoIndegDec:       return QString("入度减一");
+    }
+    return QString();
+}
@@ -0,0 +1,99 @@
+/* ANNOTATED_FOR_STUDY
+@file StepLogModel.h
+@brief 步骤日志的数据模型（model/view），替代原来“每步 append 一行”的 QTextEdit。
+
+为什么不用 QTextEdit？
+- QTextEdit 背后是 QTextDocument：每 append 一行都要做排版，文档越长越慢，内存也随行数线性涨，
+  长 trace（几十万步）播放到后面会明显卡顿。
+- 日志里绝大多数行就是 Step::note，本来就在 trace 里存着，没必要再拷一份进文档。
+  trace 可以是内存里的 QVector<Step>，也可以是按下标现取的来源（内存映射的 StepTrace 文件，note 现拼）。
+
+这里的做法：
+- 每一行只是一个很小的条目：要么引用 trace 里的第 i 步（只存下标），要么是一行说明文字；
+- 条目放在定长环形缓冲里，超出容量时丢弃最旧的行，内存有上界；
+- 配合 QListView(uniformItemSizes) 使用：视图只对可见的几十行调用 data()，文字在那时才格式化；
+- 支持按 Step 类型过滤与按文字搜索，过滤结果以“序号列表”维护，追加时增量更新。
+*/
+
+#pragma once
+#include <QAbstractListModel>
+#include <QVector>
+#include <QString>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "Steps.h"
+
+class StepLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    // 过滤掩码：第 k 位对应 StepType 的第 k 个枚举值，kTextBit 对应说明文字行。
+    static constexpr quint32 kTextBit = 1u << 31;
+    static constexpr quint32 kAllTypes = 0xffffffffu;
+
+    enum Role { StepIndexRole = Qt::UserRole + 1 };
+
+    explicit StepLogModel(QObject* parent = nullptr, int capacity = 1 << 20);
+
+    using StepFetch = std::function<Step(int index)>;
+
+    // 换一份 trace（同时清空日志）。QVector 是隐式共享的，这里只多一个引用，不复制 Step。
+    void resetTrace(const QVector<Step>& steps);
+    // 同上，第 i 步在需要显示/过滤时才调 fetch(i) 取（fetch 持有的数据须在下次 reset 前保持有效）。
+    void resetTrace(int count, StepFetch fetch);
+    void clear();
+
+    // 追加一行说明文字。
+    void appendText(const QString& text);
+    // 追加 trace 中 [from, to) 这些步；只记下标，不格式化。
+    void appendSteps(int from, int to);
+
+    void setTypeFilter(quint32 mask);
+    void setSearchText(const QString& text);
+    quint32 typeFilter() const { return mTypeMask; }
+
+    // 当前缓冲里的总行数（不受过滤影响）/ 因超出容量而丢弃的行数。
+    int totalLines() const { return mCount; }
+    qint64 droppedLines() const { return mFirstSeq; }
+
+    // 对应行引用的 step 下标；说明文字行返回 -1。
+    int stepIndexAt(int row) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    static QString typeName(StepType t);
+
+private:
+    struct Entry {
+        int step = -1;   // >= 0：引用 trace 的第 step 步；-1：说明文字
+        QString text;    // 只有说明文字行才非空
+    };
+
+    int mTraceSize = 0;
+    StepFetch mFetch;
+
+    // 环形缓冲：逻辑上第 seq 行（seq 单调递增，从不复用）存在 mRing[seq % capacity]。
+    // 按需增长，最多 capacity 格。
+    std::vector<Entry> mRing;
+    int mCapacity = 0;
+    int mCount = 0;            // 缓冲里当前的行数
+    qint64 mFirstSeq = 0;      // 最旧一行的 seq
+
+    // 过滤：未启用时第 row 行就是 seq = mFirstSeq + row；启用时用 mVisible[row] 查 seq。
+    quint32 mTypeMask = kAllTypes;
+    QString mSearch;
+    std::deque<qint64> mVisible;
+
+    bool filtering() const { return mTypeMask != kAllTypes || !mSearch.isEmpty(); }
+    bool accepts(const Entry& e) const;
+    const Entry& entryAt(qint64 seq) const { return mRing[size_t(seq % mCapacity)]; }
+    Entry& slotFor(qint64 seq);   // 要写第 seq 行的格子（缓冲没满时顺带增长）
+    qint64 seqForRow(int row) const;
+    QString lineText(const Entry& e) const;
+
+    void evictOldest(int k);
+    void commitAppended(int k);   // 新条目已写进环形缓冲尾部，通知视图并更新过滤结果
+    void rebuildVisible();
+};
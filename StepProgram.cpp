@@ -0,0 +1,154 @@
+/* ANNOTATED_FOR_STUDY
+@file StepProgram.cpp
+@brief Step -> VisualOp 的编译（原来 VisualState::apply/highlight 里回放时才做的那两个 switch）。
+*/
+
+#include "StepProgram.h"
+#include <algorithm>
+#include <climits>
+
+VisualOp StepProgram::compile(const Step& step, int n, int edgeId)
+{
+    VisualOp op;
+    if (step.type == StepType::ResetVisual) {
+        op.code = VisualOp::Reset;
+        op.value = (step.val != 0) ? 1 : 0;
+        return op;
+    }
+
+    const int u = (step.u >= 1 && step.u <= n) ? step.u : -1;
+    const int v = (step.v >= 1 && step.v <= n) ? step.v : -1;
+
+    // 持久改动：改哪个点、哪一列、哪些标志位。
+    switch (step.type) {
+    // --- SCC（Tarjan）阶段 ---
+    case StepType::PushStack:
+        op.node = u;
+        op.setMask = VisualState::InStack;
+        break;
+    case StepType::PopStack:
+        op.node = u;
+        op.clearMask = VisualState::InStack;
+        break;
+    case StepType::AssignSCC:
+        op.code = VisualOp::SetScc;
+        op.node = u;
+        op.value = step.scc;
+        op.clearMask = VisualState::InStack;
+        break;
+
+    // --- 拓扑排序（Kahn）阶段 ---
+    case StepType::TopoInitIndeg:
+        op.code = VisualOp::SetIndeg;
+        op.node = u;
+        op.value = step.val;
+        op.setMask = VisualState::IndegShown;
+        break;
+    case StepType::TopoEnqueue:
+        op.node = u;
+        op.setMask = VisualState::Queued;
+        break;
+    case StepType::TopoDequeue:
+        op.code = VisualOp::Dequeue;
+        op.node = u;
+        op.clearMask = VisualState::Queued;
+        op.setMask = VisualState::Done;
+        break;
+    case StepType::TopoIndegDec:
+        // 更新 v 的入度显示。
+        op.code = VisualOp::SetIndeg;
+        op.node = v;
+        op.value = step.val;
+        op.setMask = VisualState::IndegShown;
+        break;
+    default:
+        // Visit 等只有瞬时高亮。
+        break;
+    }
+    // 点越界时整步退化为“只有高亮”，不能留下一个没有目标的 SetScc/SetIndeg/Dequeue。
+    if (op.node < 0) {
+        op.code = VisualOp::Flags;
+        op.setMask = op.clearMask = 0;
+    }
+
+    // 瞬时高亮。
+    switch (step.type) {
+    case StepType::Visit:
+    case StepType::PushStack:
+    case StepType::PopStack:
+    case StepType::AssignSCC:
+    case StepType::TopoInitIndeg:
+    case StepType::TopoEnqueue:
+    case StepType::TopoDequeue:
+        op.hi0 = u;
+        break;
+    case StepType::TopoIndegDec:
+        // 高亮当前处理的边 (u -> v) 以及两个端点。
+        op.edge = edgeId;
+        op.hi0 = (v >= 0) ? v : u;
+        if (v >= 0 && u != v) op.hi1 = u;
+        break;
+    default:
+        break;
+    }
+    return op;
+}
+
+void StepProgram::clear()
+{
+    mOps.clear();
+    mOps.shrink_to_fit();
+    mSource.reset();
+    mResolve = nullptr;
+    mTotal = 0;
+}
+
+void StepProgram::build(const Step* steps, std::size_t count, int n, const EdgeResolver& resolve)
+{
+    clear();
+    mN = n;
+    mResolve = resolve;
+    mOps.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const Step& st = steps[i];
+        const int eid = (st.type == StepType::TopoIndegDec && resolve) ? resolve(st.u, st.v) : -1;
+        mOps.push_back(compile(st, n, eid));
+    }
+}
+
+void StepProgram::stream(std::shared_ptr<StepSource> source, int n, EdgeResolver resolve)
+{
+    clear();
+    if (!source) return;
+    mSource = std::move(source);
+    mN = n;
+    mResolve = std::move(resolve);
+    mTotal = int(std::min<std::size_t>(mSource->sizeHint(), INT_MAX));
+}
+
+void StepProgram::branch(int keep, std::shared_ptr<StepSource> source)
+{
+    mOps.resize(std::size_t(std::max(0, std::min(keep, size()))));
+    mSource = std::move(source);
+    const std::size_t hint = mSource ? mSource->sizeHint() : 0;
+    mTotal = int(std::min<std::size_t>(std::size_t(size()) + hint, INT_MAX));
+}
+
+bool StepProgram::fetch(int count)
+{
+    Step st;
+    while (size() < count) {
+        if (!mSource || !mSource->next(st)) {
+            // 比预计的少（输入不合法时会提前结束）：以实际步数为准。
+            mSource.reset();
+            return false;
+        }
+        const int eid = (st.type == StepType::TopoIndegDec && mResolve) ? mResolve(st.u, st.v) : -1;
+        mOps.push_back(compile(st, mN, eid));
+        if (size() == mTotal) {
+            // 预计的步数已取满，source 用完就放掉（它可能还持有 O(n) 的算法状态）。
+            mSource.reset();
+        }
+    }
+    return true;
+}
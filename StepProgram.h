@@ -0,0 +1,58 @@
+/* ANNOTATED_FOR_STUDY
+@file StepProgram.h
+@brief 把一条 trace（Step 序列）针对当前场景一次性“编译”成紧凑的 VisualOp 数组，回放时只照着数组执行。
+
+为什么要编译？
+- Step 是给人看的：带一条 QString 日志，u/v 可能越界，边要按 (u,v) 去查编号，
+  每种类型改哪一列、置/清哪些位都要在回放时用 switch 现判断；
+- 这些判断对同一条 trace、同一个场景每次结果都一样，没必要每放一步（每次前进/后退/跳转）都重做；
+- 编译后每步是 24 字节的定长记录（点已校验、边已解析、位掩码已算好），不含 QString，
+  几百万步的 trace 回放与关键帧重放都只是顺序扫一遍数组。
+
+编译结果只对“编译时的那个场景”有效（edgeId 依赖边的插入顺序），场景重建后要重新编译。
+
+也可以不预先编译：stream() 挂上一个按需取步的 StepSource（算法状态机），
+时间轴播到哪儿才通过 fetch() 取步编译到哪儿，开播不必等整条 trace 算完。
+
+纯逻辑模块，不含 Qt 类型（Step 里的 QString 除外，编译时不读它）。
+*/
+
+#pragma once
+#include "Steps.h"
+#include "VisualState.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class StepProgram {
+public:
+    using EdgeResolver = std::function<int(int u, int v)>;   // (u,v) -> edgeId，不存在返回 -1
+
+    // 单步编译。n 是场景的点数（越界的点按“没有”处理），edgeId 是 (step.u, step.v) 的边编号。
+    static VisualOp compile(const Step& step, int n, int edgeId);
+
+    // 编译整条 trace；只有 TopoIndegDec 需要查边。steps 指向连续存放的 count 个 Step。
+    void build(const Step* steps, std::size_t count, int n, const EdgeResolver& resolve);
+    // 流式装载：先不编译，fetch() 时才从 source 取步（resolve 届时才调用，场景须保持不变）。
+    void stream(std::shared_ptr<StepSource> source, int n, EdgeResolver resolve);
+    // 只留前 keep 步（keep <= size()），之后改从 source 取（source 产出的是第 keep 步往后）。点数与查边沿用原来的。
+    void branch(int keep, std::shared_ptr<StepSource> source);
+    // 保证前 count 步已编译；source 提前耗尽时返回 false，total() 随之收缩为实际步数。
+    bool fetch(int count);
+    void clear();
+
+    bool empty() const { return total() == 0; }
+    int size() const { return (int)mOps.size(); }          // 已编译的步数
+    int total() const { return mSource ? mTotal : size(); } // 总步数（流式时是 source 的预计值）
+    const VisualOp& operator[](int i) const { return mOps[std::size_t(i)]; }
+
+private:
+    std::vector<VisualOp> mOps;
+
+    // 流式装载时的来源；耗尽后释放。
+    std::shared_ptr<StepSource> mSource;
+    int mN = 0;
+    int mTotal = 0;
+    EdgeResolver mResolve;
+};
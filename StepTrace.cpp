@@ -0,0 +1,208 @@
+/* ANNOTATED_FOR_STUDY
+@file StepTrace.cpp
+@brief Step trace 的编码（StepTraceWriter）、解码（StepTraceReader）与图指纹。
+*/
+
+#include "StepTrace.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+const char kMagic[8] = {'T', 'O', 'P', 'O', 'S', 'T', 'P', '\1'};
+
+void putLE(std::string& buf, std::uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) buf.push_back(char((v >> (8 * i)) & 0xff));
+}
+
+std::uint64_t getLE(const std::uint8_t* p, int bytes)
+{
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= std::uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+// 一条 16 字节记录（格式见 StepTrace.h）。文件与内存里的 StepTape 共用。
+void encodeRecord(std::string& buf, const Step& step)
+{
+    const int arg = (step.type == StepType::AssignSCC) ? step.scc : step.val;
+    buf.push_back(char(step.type));
+    putLE(buf, 0, 3);
+    putLE(buf, std::uint32_t(step.u), 4);
+    putLE(buf, std::uint32_t(step.v), 4);
+    putLE(buf, std::uint32_t(arg), 4);
+}
+
+Step decodeRecord(const std::uint8_t* p)
+{
+    Step s;
+    // 认不出的类型按“什么都不做”处理（Visit 且没有点），不让坏文件把下游的 switch/位移带偏。
+    if (p[0] > std::uint8_t(StepType::TopoIndegDec)) {
+        s.type = StepType::Visit;
+        return s;
+    }
+    s.type = StepType(p[0]);
+    s.u = int(std::uint32_t(getLE(p + 4, 4)));
+    s.v = int(std::uint32_t(getLE(p + 8, 4)));
+    const int arg = int(std::uint32_t(getLE(p + 12, 4)));
+    if (s.type == StepType::AssignSCC) s.scc = arg;
+    else s.val = arg;
+    return s;
+}
+
+constexpr std::uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+void fnvMix(std::uint64_t& h, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        h ^= (v >> (8 * i)) & 0xff;
+        h *= kFnvPrime;
+    }
+}
+} // namespace
+
+std::uint64_t graphFingerprint(const Graph& g)
+{
+    std::vector<std::pair<int, int>> edges = g.edges;
+    std::sort(edges.begin(), edges.end());
+    std::uint64_t h = kFnvOffset;
+    fnvMix(h, std::uint32_t(g.n));
+    fnvMix(h, std::uint32_t(edges.size()));
+    for (const auto& e : edges) {
+        fnvMix(h, std::uint32_t(e.first));
+        fnvMix(h, std::uint32_t(e.second));
+    }
+    return h;
+}
+
+QString stepNote(const Step& s, TraceAlgorithm algorithm)
+{
+    const bool byOrder = (algorithm == TraceAlgorithm::KahnOrder);
+    switch (s.type) {
+    case StepType::ResetVisual:   return QString();
+    case StepType::Visit:         return QString("访问 %1").arg(s.u);
+    case StepType::PushStack:     return QString("入栈 %1").arg(s.u);
+    case StepType::PopStack:      return QString("弹出 %1").arg(s.u);
+    case StepType::AssignSCC:     return QString("添加节点 %1 到 SCC %2").arg(s.u).arg(s.scc);
+    case StepType::TopoInitIndeg: return QString("初始化入度 indeg[%1]=%2").arg(s.u).arg(s.val);
+    case StepType::TopoEnqueue:
+        // 按序列演示时，初始候选与后来入度归零的候选文字不同，但记录里分不出来，统一用后者。
+        return byOrder ? QString("入度变为 0，加入候选 %1").arg(s.u) : QString("入队 %1").arg(s.u);
+    case StepType::TopoDequeue:
+        return byOrder ? QString("选择 %1 作为本序列第 %2 个输出").arg(s.u).arg(s.val)
+                       : QString("出队 %1").arg(s.u);
+    case StepType::TopoIndegDec:
+        return byOrder ? QString("处理边 %1->%2, indeg[%2]-- => %3").arg(s.u).arg(s.v).arg(s.val)
+                       : QString("indeg[%1]-- => %2").arg(s.v).arg(s.val);
+    default:
+        return QString();
+    }
+}
+
+// ---------------- StepTraceWriter ----------------
+
+StepTraceWriter::StepTraceWriter(WriteFn write)
+    : mWrite(std::move(write))
+{
+    mBuf.reserve(kBufferBytes + kStepTraceRecordBytes);
+}
+
+bool StepTraceWriter::begin(const StepTraceHeader& header)
+{
+    mWritten = 0;
+    mBuf.append(kMagic, sizeof(kMagic));
+    mBuf.push_back(char(header.algorithm));
+    putLE(mBuf, 0, 3);
+    putLE(mBuf, std::uint32_t(header.n), 4);
+    putLE(mBuf, header.fingerprint, 8);
+    putLE(mBuf, header.orderIndex, 8);
+    return true;
+}
+
+bool StepTraceWriter::put(const Step& step)
+{
+    if (mFailed) return false;
+    encodeRecord(mBuf, step);
+    ++mWritten;
+    return mBuf.size() < kBufferBytes || flush();
+}
+
+bool StepTraceWriter::flush()
+{
+    if (mFailed) return false;
+    if (mBuf.empty()) return true;
+    if (!mWrite || !mWrite(mBuf.data(), mBuf.size())) {
+        mFailed = true;
+        return false;
+    }
+    mBuf.clear();
+    return true;
+}
+
+// ---------------- StepTraceReader ----------------
+
+bool StepTraceReader::open(const std::uint8_t* data, std::size_t size)
+{
+    mData = nullptr;
+    mCount = 0;
+    mHeader = StepTraceHeader();
+    if (!data || size < kStepTraceHeaderBytes || !std::equal(kMagic, kMagic + sizeof(kMagic), data)) return false;
+
+    const std::uint8_t algo = data[8];
+    if (algo < std::uint8_t(TraceAlgorithm::TarjanScc) || algo > std::uint8_t(TraceAlgorithm::KahnOrder)) return false;
+    mHeader.algorithm = TraceAlgorithm(algo);
+    mHeader.n = int(getLE(data + 12, 4));
+    mHeader.fingerprint = getLE(data + 16, 8);
+    mHeader.orderIndex = getLE(data + 24, 8);
+
+    mData = data;
+    mCount = (size - kStepTraceHeaderBytes) / kStepTraceRecordBytes;
+    return true;
+}
+
+Step StepTraceReader::stepAt(std::uint64_t index) const
+{
+    return decodeRecord(mData + kStepTraceHeaderBytes + index * kStepTraceRecordBytes);
+}
+
+// ---------------- StepTape ----------------
+
+StepTape::StepTape(std::unique_ptr<StepSource> source)
+    : mSource(std::move(source))
+{
+}
+
+StepTape::StepTape(std::unique_ptr<StepSource> source, const StepTape& prefix, std::size_t keep)
+    : mSource(std::move(source))
+    , mTape(prefix.mTape, 0, keep * kStepTraceRecordBytes)
+    , mBase(keep)
+{
+}
+
+bool StepTape::next(Step& out)
+{
+    if (!mSource || !mSource->next(out)) {
+        mSource.reset();   // 跑完了：状态机（连同它的 O(n) 数组）可以先放掉，录下的步还在
+        return false;
+    }
+    encodeRecord(mTape, out);
+    return true;
+}
+
+std::size_t StepTape::sizeHint() const
+{
+    return mSource ? mSource->sizeHint() : count() - mBase;
+}
+
+Step StepTape::stepAt(std::size_t index) const
+{
+    return decodeRecord(reinterpret_cast<const std::uint8_t*>(mTape.data()) + index * kStepTraceRecordBytes);
+}
+
+bool StepTapeReplay::next(Step& out)
+{
+    if (!mTape || mNext >= mTape->count()) return false;
+    out = mTape->stepAt(mNext++);
+    return true;
+}
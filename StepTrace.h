@@ -0,0 +1,134 @@
+/* ANNOTATED_FOR_STUDY
+@file StepTrace.h
+@brief Step 序列的二进制落盘格式：边跑算法边写（StepTraceWriter），内存映射后按下标随机读（StepTraceReader）。
+
+为什么要它？
+- 原来的 steps 每次都要重新跑算法生成，而且只活在 MainWindow::mSteps 里（每步还带一条 QString 日志）；
+- 大图的 trace 可以先在命令行里无界面地录下来（main.cpp 的 --capture-trace，见 TraceCapture.h），
+  之后在界面里直接打开回放，不必重跑算法，也不必把整条 trace 读进内存。
+
+格式（小端）：
+- 32 字节文件头：
+    0..7   "TOPOSTP\1"
+    8      算法（TraceAlgorithm）
+    9..11  保留
+    12..15 图的节点数 n（uint32）
+    16..23 图指纹（graphFingerprint，uint64）：回放前用它确认当前显示的就是录制时的那张图
+    24..31 拓扑序列下标（uint64；KahnOrder 演示的是第几条，其余为 kNoOrderIndex）
+- 之后是定长 16 字节记录，第 i 条在 32 + 16*i：
+    0      StepType
+    1..3   保留
+    4..7   u（int32）
+    8..11  v（int32）
+    12..15 arg（int32；AssignSCC 时是 scc，其余是 val）
+- 不存日志文字：读出来的 Step 的 note 为空，需要显示时用 stepNote() 按类型现拼（日志只格式化可见的几十行）。
+
+记录条数由文件长度决定，写到一半被中断的文件也能读（尾部不完整的半条被忽略）。
+
+纯逻辑模块，不含 Qt 类型（Step 里的 QString 与 stepNote() 除外）。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "Steps.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+enum class TraceAlgorithm : std::uint8_t {
+    TarjanScc = 1,   // 原图上的 Tarjan
+    Kahn      = 2,   // DAG 上的普通 Kahn（TopoKahn::run）
+    KahnOrder = 3,   // DAG 上按指定序列演示的 Kahn（TopoKahn::runWithOrder）
+};
+
+struct StepTraceHeader {
+    static constexpr std::uint64_t kNoOrderIndex = ~std::uint64_t(0);
+
+    TraceAlgorithm algorithm = TraceAlgorithm::TarjanScc;
+    int n = 0;
+    std::uint64_t fingerprint = 0;
+    std::uint64_t orderIndex = kNoOrderIndex;
+};
+
+constexpr std::size_t kStepTraceHeaderBytes = 32;
+constexpr std::size_t kStepTraceRecordBytes = 16;
+
+// 图指纹：n 加上排好序的边表做 FNV-1a。与加边顺序无关（trace 只引用点编号，边按 (u,v) 现查）。
+std::uint64_t graphFingerprint(const Graph& g);
+
+// 日志文字：与算法生成 Step 时写的 note 一致。
+QString stepNote(const Step& step, TraceAlgorithm algorithm);
+
+class StepTraceWriter : public StepSink {
+public:
+    using WriteFn = std::function<bool(const char* data, std::size_t len)>;
+
+    static constexpr std::size_t kBufferBytes = std::size_t(1) << 20;
+
+    explicit StepTraceWriter(WriteFn write);
+
+    bool begin(const StepTraceHeader& header);   // 写文件头
+    bool put(const Step& step) override;
+    bool flush();
+
+    std::uint64_t written() const { return mWritten; }
+    bool failed() const { return mFailed; }
+
+private:
+    WriteFn mWrite;
+    std::string mBuf;
+    std::uint64_t mWritten = 0;
+    bool mFailed = false;
+};
+
+class StepTraceReader {
+public:
+    // 解析 data[0, size)（通常是 QFile::map 的结果，读取期间必须保持映射）。文件头不对返回 false。
+    bool open(const std::uint8_t* data, std::size_t size);
+
+    const StepTraceHeader& header() const { return mHeader; }
+    std::uint64_t count() const { return mCount; }
+
+    // 第 index 条（note 为空）；调用方保证 index < count()。
+    Step stepAt(std::uint64_t index) const;
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::uint64_t mCount = 0;
+    StepTraceHeader mHeader;
+};
+
+// 按需取步的状态机（见 StepSource）外面包一层“录音带”：经过的每一步按上面同样的 16 字节记录存下来，
+// 日志要显示已经走过的第 i 步时从这里现解码，不必让状态机倒回去，也不必存带 QString 的 Step。
+class StepTape : public StepSource {
+public:
+    explicit StepTape(std::unique_ptr<StepSource> source);
+    // 先照抄 prefix 的前 keep 步，source 接着从第 keep 步往后产出（两条 trace 共享前缀时用）。
+    StepTape(std::unique_ptr<StepSource> source, const StepTape& prefix, std::size_t keep);
+
+    bool next(Step& out) override;
+    std::size_t sizeHint() const override;
+
+    std::size_t count() const { return mTape.size() / kStepTraceRecordBytes; }   // 已经取出过的步数
+    Step stepAt(std::size_t index) const;   // index < count()，note 为空
+
+private:
+    std::unique_ptr<StepSource> mSource;
+    std::string mTape;
+    std::size_t mBase = 0;   // 照抄来的前缀步数（不经 next() 产出）
+};
+
+// 把录好的 tape 当作 source 从头再放一遍（后台预取好的后缀就是这样接到时间轴上的，见 OrderPrefetcher）。
+class StepTapeReplay : public StepSource {
+public:
+    explicit StepTapeReplay(std::shared_ptr<const StepTape> tape) : mTape(std::move(tape)) {}
+
+    bool next(Step& out) override;
+    std::size_t sizeHint() const override { return mTape ? mTape->count() : 0; }
+
+private:
+    std::shared_ptr<const StepTape> mTape;
+    std::size_t mNext = 0;
+};
@@ -19,6 +19,7 @@
 // 可视化步骤定义
 #pragma once
 #include <QString>
+#include <cstddef>
 
 /*
 采用enum的好处：
@@ -44,3 +45,28 @@ struct Step {
     int val = 0;      // 例如入度变化后的值
     QString note;     // 右侧日志
 };
+
+// 逐步交出 Step 的接口：算法拿到 sink 时不再把 steps 攒在结果里，而是边跑边交出去
+// （例如 StepTraceWriter 直接落盘），trace 多长都不占内存。
+class StepSink {
+public:
+    virtual ~StepSink() = default;
+    virtual bool put(const Step& step) = 0;
+};
+
+// 只要算法结果、不要 steps 时用它。
+class DiscardStepSink : public StepSink {
+public:
+    bool put(const Step&) override { return true; }
+};
+
+// 反过来“按需要一步”的接口：算法写成可暂停的状态机，回放走到哪儿才算到哪儿，
+// 不必先把整条 trace 算完存下来（见 TarjanStepper / KahnOrderStepper）。
+class StepSource {
+public:
+    virtual ~StepSource() = default;
+    // 取下一步（note 为空，要显示时用 stepNote() 现拼）；已经没有了返回 false。
+    virtual bool next(Step& out) = 0;
+    // 预计 next() 一共会产出多少步（从构造算起；输入合法时是准数，提前结束时以 next() 返回 false 为准）。
+    virtual std::size_t sizeHint() const = 0;
+};
@@ -12,69 +12,137 @@
      * 遇到栈内点：low[u] = min(low[u], dfn[v])
    - 如果 low[u]==dfn[u]，说明 u 是 SCC 的根：一直弹栈直到 u
      每弹出一个点：记录 PopStack，然后 AssignSCC(x, sccCnt)
-3) 这些 steps 在 MainWindow::onRunSCC() 中缓存，然后通过 QTimer 逐步喂给 GraphView::applyStep()。
+3) 实现上把上面的递归改写成 TarjanStepper 的状态机（显式帧栈），一次 next() 走一步：
+   回放时时间轴按需向它要步（见 Timeline），后台求 SCC 映射时 run() 把它一口气跑完。
 */
 
 // 算法模块：强连通分量（Tarjan）
 #include "TarjanSCC.h"
+#include "StepTrace.h"
+#include "Trace.h"
 #include <algorithm>
 
-SCCResult TarjanSCC::run(const Graph& g){
-    G = &g; n = g.n;
-    timer = sccCnt = 0;
+TarjanStepper::TarjanStepper(const Graph& g)
+    : G(&g), n(g.n)
+{
     dfn.assign(n+1, 0);
     low.assign(n+1, 0);
     inStack.assign(n+1, 0);
     sccId.assign(n+1, 0);
-    st.clear();
-    steps.clear();
-
     // sccSize 下标从 1 开始，先占位
     sccSize.assign(n+1, 0);
+}
 
-    for(int i=1;i<=n;i++){
-        if(!dfn[i]) dfs(i);
-    }
+void TarjanStepper::visit(int u, Step& out){
+    dfn[u] = low[u] = ++timer;
+    frames.push_back({u, 0});
+    out = {StepType::Visit, u, -1, -1, 0, QString()};
+    phase = Phase::Push;
+}
 
-    SCCResult res;
-    res.sccCnt = sccCnt;
-    res.sccId = sccId;
-    res.sccSize.assign(sccCnt+1, 0);
-    for(int i=1;i<=sccCnt;i++) res.sccSize[i] = sccSize[i];
-    res.steps = steps;
-    return res;
+void TarjanStepper::leave(){
+    const int v = frames.back().u;
+    frames.pop_back();
+    if(frames.empty()){
+        phase = Phase::NextRoot;
+        return;
+    }
+    // 相当于递归版 dfs(v) 返回后的 low[u] = min(low[u], low[v])
+    const int u = frames.back().u;
+    low[u] = std::min(low[u], low[v]);
+    phase = Phase::Scan;
 }
 
-void TarjanSCC::dfs(int u){
-    dfn[u] = low[u] = ++timer;
-    steps.push_back({StepType::Visit, u, -1, -1, 0, QString("访问 %1").arg(u)});
+bool TarjanStepper::next(Step& out){
+    // 每个分支要么产出一步并返回，要么切换 phase 继续循环（不产出步的状态转移）。
+    for(;;){
+        switch(phase){
+        case Phase::NextRoot:
+            while(root <= n && dfn[root]) ++root;
+            if(root > n){
+                phase = Phase::Done;
+                return false;
+            }
+            visit(root, out);
+            return true;
 
-    st.push_back(u);
-    inStack[u] = 1;
-    steps.push_back({StepType::PushStack, u, -1, -1, 0, QString("入栈 %1").arg(u)});
+        case Phase::Push: {
+            const int u = frames.back().u;
+            st.push_back(u);
+            inStack[u] = 1;
+            out = {StepType::PushStack, u, -1, -1, 0, QString()};
+            phase = Phase::Scan;
+            return true;
+        }
 
-    for(int v: G->adj[u]){
-        if(!dfn[v]){
-            dfs(v);
-            low[u] = std::min(low[u], low[v]);
-        } else if(inStack[v]){
-            low[u] = std::min(low[u], dfn[v]);
+        case Phase::Scan: {
+            Frame& f = frames.back();
+            const std::vector<int>& adj = G->adj[f.u];
+            while(f.edge < adj.size()){
+                const int v = adj[f.edge++];
+                if(!dfn[v]){
+                    visit(v, out);   // “递归”：压一帧，下次从 v 继续
+                    return true;
+                }
+                if(inStack[v]) low[f.u] = std::min(low[f.u], dfn[v]);
+            }
+            if(low[f.u] == dfn[f.u]){
+                ++sccCnt;
+                phase = Phase::Pop;
+            } else {
+                leave();
+            }
+            break;
         }
-    }
 
-    if(low[u] == dfn[u]){
-        ++sccCnt;
-        while(true){
-            int x = st.back(); st.pop_back();
+        case Phase::Pop: {
+            const int x = st.back(); st.pop_back();
             inStack[x] = 0;
-            steps.push_back({StepType::PopStack, x, -1, -1, 0, QString("弹出 %1").arg(x)});
-
             sccId[x] = sccCnt;
             sccSize[sccCnt]++;
-            steps.push_back({StepType::AssignSCC, x, -1, sccCnt, 0,
-                             QString("添加节点 %1 到 SCC %2").arg(x).arg(sccCnt)});
+            popped = x;
+            out = {StepType::PopStack, x, -1, -1, 0, QString()};
+            phase = Phase::Assign;
+            return true;
+        }
+
+        case Phase::Assign:
+            out = {StepType::AssignSCC, popped, -1, sccCnt, 0, QString()};
+            if(popped == frames.back().u) leave();   // 弹到根为止
+            else phase = Phase::Pop;
+            return true;
+
+        case Phase::Done:
+            return false;
+        }
+    }
+}
+
+SCCResult TarjanStepper::result() const{
+    SCCResult res;
+    res.sccCnt = sccCnt;
+    res.sccId = sccId;
+    res.sccSize.assign(sccSize.begin(), sccSize.begin() + sccCnt + 1);
+    return res;
+}
 
-            if(x == u) break;
+SCCResult TarjanSCC::run(const Graph& g, TaskControl* ctl, StepSink* sink){
+    TRACE_SCOPE("TarjanSCC::run");
+    TarjanStepper stepper(g);
+    std::vector<Step> steps;
+    Step step;
+    while(stepper.next(step)){
+        // 每访问一个点记一次进度；被取消/超时就直接停下（结果作废）。
+        if(step.type == StepType::Visit && ctl && !ctl->tick()) break;
+        if(sink){
+            sink->put(step);
+        } else {
+            step.note = stepNote(step, TraceAlgorithm::TarjanScc);
+            steps.push_back(std::move(step));
         }
     }
+
+    SCCResult res = stepper.result();
+    res.steps = std::move(steps);
+    return res;
 }
@@ -12,6 +12,7 @@
 #pragma once
 #include "Graph.h"
 #include "Steps.h"
+#include "TaskControl.h"
 #include <vector>
 
 struct SCCResult {
@@ -21,19 +22,47 @@ struct SCCResult {
     std::vector<Step> steps;
 };
 
-class TarjanSCC {
+// Tarjan 写成可暂停的状态机：每调一次 next() 只往前推进到下一个 Step 为止。
+// 递归的 dfs 换成显式的帧栈（每帧记“点 + 扫到第几条出边”），暂停时状态全在成员里，
+// 除了算法本来就要的 dfn/low/栈 这些 O(n) 数组之外，额外内存只有帧栈（O(DFS 深度)）。
+// 回放直接从它取步，不必先把 4n 步全部算完存下来。
+class TarjanStepper : public StepSource {
 public:
-    SCCResult run(const Graph& g);
+    explicit TarjanStepper(const Graph& g);   // g 须在 stepper 用完之前保持有效
+
+    bool next(Step& out) override;
+    std::size_t sizeHint() const override { return 4 * std::size_t(n); }   // 每个点恰好 访问/入栈/弹出/归属 各一步
+
+    bool done() const { return phase == Phase::Done; }
+    // SCC 映射（steps 为空）。done() 之前调用得到的是到目前为止的部分结果。
+    SCCResult result() const;
 
 private:
+    enum class Phase { NextRoot, Push, Scan, Pop, Assign, Done };
+    struct Frame {
+        int u;
+        std::size_t edge;   // 下一条要看的出边 adj[u][edge]
+    };
+
     const Graph* G = nullptr;
     int n = 0, timer = 0, sccCnt = 0;
+    int root = 1;         // 下一个待检查的 DFS 起点
+    int popped = -1;      // 刚弹出、等着记 AssignSCC 的点
+    Phase phase = Phase::NextRoot;
 
     std::vector<int> dfn, low, st;
     std::vector<char> inStack;
     std::vector<int> sccId, sccSize;
+    std::vector<Frame> frames;
 
-    std::vector<Step> steps;
+    void visit(int u, Step& out);   // 首次访问 u：压帧并记 Visit
+    void leave();                   // u 的出边扫完（且已弹出它所在的 SCC）：退帧，把 low 交给父帧
+};
 
-    void dfs(int u);
+class TarjanSCC {
+public:
+    // ctl 非空时可被取消/限时；被中止时返回的结果不完整，调用方应看 ctl->status()。
+    // sink 非空时 steps 逐条交给它，结果里的 steps 为空。
+    // 内部就是把 TarjanStepper 一口气跑完。
+    SCCResult run(const Graph& g, TaskControl* ctl = nullptr, StepSink* sink = nullptr);
 };
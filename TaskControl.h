@@ -0,0 +1,77 @@
+/* ANNOTATED_FOR_STUDY
+@file TaskControl.h
+@brief 后台任务的“控制面板”：取消、进度计数、时间/内存预算。算法线程写，界面线程读。
+
+为什么需要它？
+- Tarjan / 缩点 / 拓扑计数原来都在界面线程里同步跑，大图或宽 DAG 会让窗口直接卡死；
+- 放到后台线程以后，界面需要知道“跑到哪了”，用户需要能“取消”，还要防止跑飞（时间/内存上限）。
+
+约定：
+- 算法模块只在热循环里调用 tick()/addFound()，返回 false 就尽快收尾退出（结果作废）；
+- 传 nullptr 表示不受控（与原来的同步调用完全一样）；
+- 所有字段都是原子量，不加锁；时钟每 kClockEvery 次 tick 才读一次，开销可以忽略。
+
+和 Graph 一样不含 Qt 类型。
+*/
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class TaskControl {
+public:
+    enum class Status { Running, Done, Cancelled, TimedOut, OutOfMemory };
+
+    // 时间上限（毫秒，<= 0 表示不限），从调用时开始计。
+    void setTimeBudget(int ms)
+    {
+        mHasDeadline = ms > 0;
+        mDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    }
+    // 内存上限（字节，0 表示由算法自己的默认值决定）。
+    void setMemoryBudget(std::size_t bytes) { mMemoryBudget = bytes; }
+    std::size_t memoryBudget(std::size_t fallback) const { return mMemoryBudget ? mMemoryBudget : fallback; }
+
+    // 界面线程调用。
+    void requestCancel() { stop(Status::Cancelled); }
+
+    // 算法线程调用：记一次（或 n 次）工作量；返回 false 表示应当停止。
+    bool tick(std::uint64_t n = 1)
+    {
+        const std::uint64_t before = mWork.fetch_add(n, std::memory_order_relaxed);
+        if (mHasDeadline && (before / kClockEvery != (before + n) / kClockEvery)
+            && std::chrono::steady_clock::now() >= mDeadline) {
+            stop(Status::TimedOut);
+        }
+        return !stopped();
+    }
+    void addFound(std::uint64_t n = 1) { mFound.fetch_add(n, std::memory_order_relaxed); }
+
+    // 算法发现自己超出内存预算等情况时主动终止。
+    void fail(Status s) { stop(s); }
+    // 后台线程正常跑完时调用；已被取消/超时的不会被改回 Done。
+    void finish() { stop(Status::Done); }
+
+    bool stopped() const { return mStatus.load(std::memory_order_relaxed) != Status::Running; }
+    Status status() const { return mStatus.load(); }
+    std::uint64_t work() const { return mWork.load(std::memory_order_relaxed); }
+    std::uint64_t found() const { return mFound.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::uint64_t kClockEvery = 4096;
+
+    std::atomic<Status> mStatus{Status::Running};
+    std::atomic<std::uint64_t> mWork{0};   // 已处理的工作量（访问的点 / 搜索状态数，含义由任务定）
+    std::atomic<std::uint64_t> mFound{0};  // 已得到的结果数（如找到的拓扑序列）
+    bool mHasDeadline = false;             // 下面两项在任务开始前设置，之后只读
+    std::chrono::steady_clock::time_point mDeadline;
+    std::size_t mMemoryBudget = 0;
+
+    void stop(Status s)
+    {
+        Status expected = Status::Running;
+        mStatus.compare_exchange_strong(expected, s);
+    }
+};
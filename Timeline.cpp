@@ -0,0 +1,131 @@
+/* ANNOTATED_FOR_STUDY
+@file Timeline.cpp
+@brief 时间轴实现：第一次走到前沿时记 undo、落关键帧；前进 apply，后退 revert，远跳还原关键帧。
+*/
+
+#include "Timeline.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+// 关键帧总预算（字节）。interval 自动选择时保证 “关键帧个数 × 单帧大小” 不超过它。
+constexpr long long kKeyframeBudget = 64LL * 1024 * 1024;
+constexpr int kMinInterval = 64;
+} // namespace
+
+void Timeline::load(StepProgram program, const VisualState& initial, int keyframeInterval)
+{
+    mProgram = std::move(program);
+    mPos = 0;
+    mBuilt = 0;
+
+    const int total = mProgram.total();
+    if (keyframeInterval > 0) {
+        mInterval = keyframeInterval;
+    } else {
+        // 单帧 ≈ 每点 sccId/indeg/order 各 4 字节 + flags 1 字节。
+        const long long frameBytes = 13LL * (initial.n + 1) + 64;
+        const long long need = (long long)total * frameBytes / kKeyframeBudget + 1;
+        mInterval = (int)std::max<long long>(kMinInterval, need);
+    }
+
+    mUndo.clear();
+    mKeys.clear();
+    mKeys.push_back({0, initial});
+}
+
+bool Timeline::extend(VisualState& state, StepEffect* fx)
+{
+    if (!mProgram.fetch(mBuilt + 1)) return false;
+    const int i = mBuilt;
+    const VisualOp& op = mProgram[i];
+    const bool reset = (op.code == VisualOp::Reset);
+    if (reset && mKeys.back().pos != i) mKeys.push_back({i, state});
+
+    mUndo.emplace_back();
+    state.apply(op, fx, &mUndo.back());
+    mPos = mBuilt = i + 1;
+
+    if (reset || mBuilt % mInterval == 0) mKeys.push_back({mBuilt, state});
+    return true;
+}
+
+void Timeline::clear()
+{
+    mProgram.clear();
+    mUndo.clear();
+    mKeys.clear();
+    mPos = 0;
+    mBuilt = 0;
+}
+
+const Timeline::Keyframe& Timeline::keyframeAtOrBefore(int pos) const
+{
+    auto it = std::upper_bound(mKeys.begin(), mKeys.end(), pos,
+                               [](int p, const Keyframe& k) { return p < k.pos; });
+    return *(it - 1); // mKeys[0].pos == 0，必然存在
+}
+
+bool Timeline::stepForward(VisualState& state, StepEffect* fx)
+{
+    if (atEnd()) return false;
+    if (mPos == mBuilt) return extend(state, fx);
+    state.apply(mProgram[mPos], fx, nullptr);
+    ++mPos;
+    return true;
+}
+
+bool Timeline::stepBackward(VisualState& state, StepEffect* fx)
+{
+    if (mPos <= 0) return false;
+    const int i = mPos - 1;
+    const VisualOp* prev = (i > 0) ? &mProgram[i - 1] : nullptr;
+
+    if (!state.revert(mProgram[i], mUndo[i], prev, fx)) {
+        // Reset：装载时已在它之前放了关键帧，直接还原。
+        state = keyframeAtOrBefore(i).state;
+        if (fx) { *fx = StepEffect(); fx->full = true; }
+    }
+    mPos = i;
+    return true;
+}
+
+bool Timeline::seek(VisualState& state, int target, const EffectSink& sink)
+{
+    target = std::max(0, std::min(target, size()));
+    if (target == mPos) return false;
+
+    // 近距离：逐步走，保持增量重绘。
+    if (std::abs(target - mPos) <= mInterval) {
+        bool full = false;
+        StepEffect fx;
+        while (mPos < target) {
+            if (!stepForward(state, &fx)) break;
+            full = full || fx.full;
+            if (sink) sink(fx);
+        }
+        while (mPos > target) {
+            stepBackward(state, &fx);
+            full = full || fx.full;
+            if (sink) sink(fx);
+        }
+        return full;
+    }
+
+    // 远距离：最近关键帧 + 不超过一个间隔的重放。目标在前沿之外时从前沿附近开始，一路建过去。
+    const Keyframe& key = keyframeAtOrBefore(std::min(target, mBuilt));
+    if (!(target > mPos && mPos >= key.pos)) {
+        state = key.state;
+        mPos = key.pos;
+    }
+    while (mPos < target && stepForward(state, nullptr)) {}
+    return true;
+}
+
+void Timeline::branch(std::shared_ptr<StepSource> source)
+{
+    mUndo.resize(std::size_t(mPos));
+    while (mKeys.size() > 1 && mKeys.back().pos > mPos) mKeys.pop_back();
+    mBuilt = mPos;
+    mProgram.branch(mPos, std::move(source));
+}
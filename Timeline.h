@@ -0,0 +1,76 @@
+/* ANNOTATED_FOR_STUDY
+@file Timeline.h
+@brief 回放时间轴：关键帧 + 可逆 VisualOp，支持任意跳转与单步后退。
+
+原来的播放器只能往前走（mStepIndex++），想回看只能重置后从第 0 步重放。
+时间轴装载的是编译好的 StepProgram（见 StepProgram.h）。装载本身不做事，第一次播到某一步时顺手：
+- 记下这一步的 StepUndo（被覆盖的旧值），于是单步后退 = VisualState::revert，O(1)；
+- 每隔 interval 步存一份 VisualState 快照（关键帧），跳转到任意位置 =
+  取不超过目标的最近关键帧 + 最多 interval 步正向重放，代价与 trace 总长无关。
+已经走到过的最远位置叫“前沿”（built）：前沿之内随意来回，往前沿之外走时才向 program 要新的 op
+（流式装载时 op 这时才由算法状态机现算出来），所以开播不必等整条 trace 编译/空跑完。
+
+两条 trace 前 keep 步相同时（例如相邻两条拓扑序列的公共前缀），不必重新装载：
+branch() 把时间轴截在当前位置，前面的 op/undo/关键帧原样保留，后面改接新的 source。
+
+ResetVisual 丢弃的信息太多，不可逆；越过它时在它前后各补一个关键帧，后退越过它时直接还原关键帧。
+
+纯逻辑模块，不含 Qt 类型，由 GraphView 持有。
+*/
+
+#pragma once
+#include "StepProgram.h"
+#include "VisualState.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Timeline {
+public:
+    using EffectSink   = std::function<void(const StepEffect&)>;
+
+    // 以 initial 作为“第 0 步之前”的状态装载 trace（不空跑，undo/关键帧边播边建）。
+    // keyframeInterval <= 0 时按 trace 长度与图规模自动选择（关键帧总内存约束在几十 MB 内）。
+    void load(StepProgram program, const VisualState& initial, int keyframeInterval = 0);
+    void clear();
+
+    bool empty() const { return size() == 0; }
+    int size() const { return mProgram.total(); }   // 流式装载、算法提前结束时会变小
+    int built() const { return mBuilt; }            // 前沿：[0, built) 的 op/undo 已就绪
+    int position() const { return mPos; }
+    bool atEnd() const { return mPos >= size(); }
+    const VisualOp& op(int i) const { return mProgram[i]; }   // i < built()
+    int keyframeInterval() const { return mInterval; }
+
+    // 下面的操作都直接改调用方的 state；约定 state 恰好是“已执行 position() 步”的状态。
+
+    // 前进/后退一步。返回 false 表示已到头（流式装载时 source 比预计的先结束也算到头）。
+    // fx->full 为 true 时表示做了整体替换（越过 ResetVisual），调用方应全量重绘。
+    bool stepForward(VisualState& state, StepEffect* fx = nullptr);
+    bool stepBackward(VisualState& state, StepEffect* fx = nullptr);
+
+    // 跳到第 target 步之后（0..size()）。
+    // 近距离（不超过一个关键帧间隔）逐步前进/后退，每步通过 sink 报告副作用，返回 false；
+    // 远距离还原关键帧再重放，返回 true，调用方应全量重绘。
+    bool seek(VisualState& state, int target, const EffectSink& sink = EffectSink());
+
+    // 在当前位置分叉：丢掉 position() 之后的一切，之后的步改从 source 取（source 从第 position() 步产出）。
+    // state 不用动（它就是 position() 处的状态）；调用方保证 [0, position()) 与新 trace 相同。
+    void branch(std::shared_ptr<StepSource> source);
+
+private:
+    struct Keyframe {
+        int pos = 0;
+        VisualState state;
+    };
+
+    StepProgram mProgram;
+    std::vector<StepUndo> mUndo;     // [i] 第 i 步覆盖掉的旧值
+    std::vector<Keyframe> mKeys;     // 按 pos 升序
+    int mInterval = 0;
+    int mPos = 0;
+    int mBuilt = 0;                  // 前沿，mPos <= mBuilt
+
+    const Keyframe& keyframeAtOrBefore(int pos) const;
+    bool extend(VisualState& state, StepEffect* fx);   // mPos == mBuilt 时往前走一步并记 undo/关键帧
+};
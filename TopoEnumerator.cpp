@@ -0,0 +1,285 @@
+/* ANNOTATED_FOR_STUDY
+@file TopoEnumerator.cpp
+@brief 拓扑序列迭代器实现：显式栈 + 有序候选集的字典序回溯。
+*/
+
+#include "TopoEnumerator.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// 检查点格式（小端）：
+//   "TOPOCKP\2" | 指纹 u64 | n u32 | 标志 u8（bit0 已开始, bit1 已结束）| changedFrom u32
+//   | emitted u64 | 固定前缀长度 u32 | 栈深 u32 | 栈 u32 * 深度 | 入度 u32 * n | 已用标记 ceil(n/8) 字节
+// 固定前缀本身就是栈底那几项。
+const char kStateMagic[8] = {'T', 'O', 'P', 'O', 'C', 'K', 'P', '\2'};
+
+void putU(std::string& buf, std::uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) buf.push_back(char((v >> (8 * i)) & 0xff));
+}
+
+bool getU(const std::uint8_t* data, std::size_t size, std::size_t& pos, int bytes, std::uint64_t& v)
+{
+    if (size - pos < std::size_t(bytes)) return false;
+    v = 0;
+    for (int i = 0; i < bytes; ++i) v |= std::uint64_t(data[pos + std::size_t(i)]) << (8 * i);
+    pos += std::size_t(bytes);
+    return true;
+}
+
+void mix(std::uint64_t& h, std::uint64_t v)
+{
+    // FNV-1a，按字节混入。
+    for (int i = 0; i < 8; ++i) {
+        h ^= (v >> (8 * i)) & 0xff;
+        h *= 1099511628211ull;
+    }
+}
+} // namespace
+
+void TopoEnumerator::reset(const Graph& dag)
+{
+    mN = dag.n;
+    mSmall = (mN <= NodeBits<4>::kMaxNodes);
+    mSucc.assign(std::size_t(mN) + 1, {});
+    mInitIndeg.assign(std::size_t(mN) + 1, 0);
+    for (int u = 1; u <= mN; ++u) {
+        for (int v : dag.adj[std::size_t(u)]) {
+            mSucc[std::size_t(u)].push_back(v);
+            mInitIndeg[std::size_t(v)]++;
+        }
+    }
+
+    mFingerprint = 14695981039346656037ull;
+    mix(mFingerprint, std::uint64_t(mN));
+    for (int u = 1; u <= mN; ++u) {
+        mix(mFingerprint, mSucc[std::size_t(u)].size());
+        for (int v : mSucc[std::size_t(u)]) mix(mFingerprint, std::uint64_t(v));
+    }
+    mFloor.clear();
+    restart();
+}
+
+bool TopoEnumerator::restrictToPrefix(const std::vector<int>& prefix)
+{
+    mFloor.clear();
+    restart();
+    for (int u : prefix) {
+        if (!isAvail(u)) {
+            restart();
+            return false;
+        }
+        choose(u);
+    }
+    mFloor = prefix;
+    return true;
+}
+
+bool TopoEnumerator::isAvail(int u) const
+{
+    if (u < 1 || u > mN) return false;
+    return mSmall ? mAvailBits.test(u) : mAvail.count(u) != 0;
+}
+
+void TopoEnumerator::addAvail(int u)
+{
+    if (mSmall) mAvailBits.set(u);
+    else mAvail.insert(u);
+}
+
+void TopoEnumerator::dropAvail(int u)
+{
+    if (mSmall) mAvailBits.reset(u);
+    else mAvail.erase(u);
+}
+
+int TopoEnumerator::firstAvail() const
+{
+    if (mSmall) return mAvailBits.first();
+    return mAvail.empty() ? 0 : *mAvail.begin();
+}
+
+int TopoEnumerator::availAfter(int u) const
+{
+    if (mSmall) return mAvailBits.firstAfter(u);
+    auto it = mAvail.upper_bound(u);
+    return it == mAvail.end() ? 0 : *it;
+}
+
+void TopoEnumerator::restart()
+{
+    mIndeg = mInitIndeg;
+    mAvail.clear();
+    mAvailBits = NodeBits<4>();
+    for (int v = 1; v <= mN; ++v) {
+        if (mIndeg[std::size_t(v)] == 0) addAvail(v);
+    }
+    mCur.clear();
+    mCur.reserve(std::size_t(mN));
+    for (int u : mFloor) choose(u);
+    mChangedFrom = 0;
+    mEmitted = 0;
+    mStarted = false;
+    mDone = false;
+}
+
+void TopoEnumerator::choose(int u)
+{
+    dropAvail(u);
+    mCur.push_back(u);
+    for (int v : mSucc[std::size_t(u)]) {
+        if (--mIndeg[std::size_t(v)] == 0) addAvail(v);
+    }
+}
+
+void TopoEnumerator::unchoose(int u)
+{
+    for (int v : mSucc[std::size_t(u)]) {
+        if (mIndeg[std::size_t(v)]++ == 0) dropAvail(v);
+    }
+    mCur.pop_back();
+    addAvail(u);
+}
+
+void TopoEnumerator::descend()
+{
+    while ((int)mCur.size() < mN) {
+        const int u = firstAvail();
+        if (u == 0) break;
+        choose(u);
+    }
+}
+
+bool TopoEnumerator::next()
+{
+    if (mDone) return false;
+
+    if (!mStarted) {
+        mStarted = true;
+        descend();
+        if ((int)mCur.size() == mN) {
+            mChangedFrom = 0;
+            ++mEmitted;
+            return true;
+        }
+    }
+
+    // 回溯：找最深的一层还有更大候选的，换成它再往下走；
+    // 走进死路（图里有环）就继续回溯。
+    int lowest = (int)mCur.size();
+    while (mCur.size() > mFloor.size()) {
+        const int u = mCur.back();
+        unchoose(u);
+        lowest = std::min(lowest, (int)mCur.size());
+
+        const int v = availAfter(u);
+        if (v == 0) continue;
+        choose(v);
+        descend();
+        if ((int)mCur.size() == mN) {
+            mChangedFrom = lowest;
+            ++mEmitted;
+            return true;
+        }
+    }
+    mDone = true;
+    return false;
+}
+
+bool TopoEnumerator::seekAfter(const std::vector<int>& order, std::uint64_t emittedBefore)
+{
+    restart();
+    if ((int)order.size() != mN || !std::equal(mFloor.begin(), mFloor.end(), order.begin())) return false;
+    for (std::size_t i = mFloor.size(); i < order.size(); ++i) {
+        const int u = order[i];
+        if (!isAvail(u)) {
+            restart();
+            return false;
+        }
+        choose(u);
+    }
+    mStarted = true;
+    mChangedFrom = 0;
+    mEmitted = emittedBefore + 1;
+    return true;
+}
+
+std::string TopoEnumerator::saveState() const
+{
+    std::string buf;
+    buf.reserve(40 + std::size_t(mN) * 8);
+    buf.append(kStateMagic, sizeof(kStateMagic));
+    putU(buf, mFingerprint, 8);
+    putU(buf, std::uint64_t(mN), 4);
+    putU(buf, (mStarted ? 1u : 0u) | (mDone ? 2u : 0u), 1);
+    putU(buf, std::uint64_t(mChangedFrom), 4);
+    putU(buf, mEmitted, 8);
+    putU(buf, mFloor.size(), 4);
+    putU(buf, mCur.size(), 4);
+    for (int u : mCur) putU(buf, std::uint64_t(u), 4);
+    for (int v = 1; v <= mN; ++v) putU(buf, std::uint64_t(mIndeg[std::size_t(v)]), 4);
+
+    std::string used(std::size_t(mN + 7) / 8, '\0');
+    for (int u : mCur) used[std::size_t(u - 1) / 8] |= char(1 << ((u - 1) % 8));
+    buf += used;
+    return buf;
+}
+
+bool TopoEnumerator::loadState(const std::uint8_t* data, std::size_t size)
+{
+    restart();
+    std::size_t pos = 0;
+    std::uint64_t fp = 0, n = 0, flags = 0, changedFrom = 0, emitted = 0, floor = 0, depth = 0;
+    if (size < sizeof(kStateMagic) || std::memcmp(data, kStateMagic, sizeof(kStateMagic)) != 0) return false;
+    pos = sizeof(kStateMagic);
+    if (!getU(data, size, pos, 8, fp) || fp != mFingerprint) return false;
+    if (!getU(data, size, pos, 4, n) || n != std::uint64_t(mN)) return false;
+    if (!getU(data, size, pos, 1, flags) || !getU(data, size, pos, 4, changedFrom)
+        || !getU(data, size, pos, 8, emitted) || !getU(data, size, pos, 4, floor)
+        || !getU(data, size, pos, 4, depth) || depth > n || changedFrom > n
+        || floor != mFloor.size() || depth < floor) {
+        return false;
+    }
+
+    // 回溯栈按原顺序重新 choose 一遍：每一步都必须是当时的候选，
+    // 这样入度和候选集自然就恢复了，再和存下来的数组逐项核对。
+    // 栈底的固定前缀 restart() 已经选好，只核对是不是同一个前缀。
+    for (std::uint64_t i = 0; i < depth; ++i) {
+        std::uint64_t u = 0;
+        const bool ok = getU(data, size, pos, 4, u) && u >= 1 && u <= n
+                        && (i < floor ? int(u) == mFloor[std::size_t(i)] : isAvail(int(u)));
+        if (!ok) {
+            restart();
+            return false;
+        }
+        if (i >= floor) choose(int(u));
+    }
+    for (int v = 1; v <= mN; ++v) {
+        std::uint64_t d = 0;
+        if (!getU(data, size, pos, 4, d) || d != std::uint64_t(mIndeg[std::size_t(v)])) {
+            restart();
+            return false;
+        }
+    }
+    std::vector<char> used(std::size_t(mN) + 1, 0);
+    for (int u : mCur) used[std::size_t(u)] = 1;
+    const std::size_t usedBytes = std::size_t(mN + 7) / 8;
+    if (size - pos != usedBytes) {
+        restart();
+        return false;
+    }
+    for (int v = 1; v <= mN; ++v) {
+        const bool bit = (data[pos + std::size_t(v - 1) / 8] >> ((v - 1) % 8)) & 1;
+        if (bit != bool(used[std::size_t(v)])) {
+            restart();
+            return false;
+        }
+    }
+
+    mStarted = flags & 1;
+    mDone = flags & 2;
+    mChangedFrom = int(changedFrom);
+    mEmitted = emitted;
+    return true;
+}
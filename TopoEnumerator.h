@@ -0,0 +1,93 @@
+/* ANNOTATED_FOR_STUDY
+@file TopoEnumerator.h
+@brief 拓扑序列的“迭代器”：按字典序一条一条往外吐，内存 O(n + m)，不递归。
+
+和 TopoKahn::enumerateAll 的回溯顺序完全一样，区别是：
+- 不把结果攒进 vector：调用方每拿到一条就处理掉（写文件 / 计数 / 显示），内存不随条数增长；
+- 不用递归：每层只记“这一层选了谁”（就是当前序列 order() 本身），回溯时在有序候选集里
+  找下一个更大的点；深度 n 再大也不会爆栈；
+- 能从任意一条已知序列之后继续（seekAfter），用于断点续写；
+- 整个枚举状态（回溯栈、入度数组、已用标记、已吐出条数）可以存成一段字节（saveState），
+  之后在同一个 DAG 上原样恢复（loadState），接着跑不重不漏；
+- 可以只枚举以某个固定前缀开头的那一段（restrictToPrefix），用于分片。
+  字典序下同一前缀的序列是连续的一段，各分片按前缀排好序首尾相接就是完整的枚举结果。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "NodeBits.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+class TopoEnumerator {
+public:
+    void reset(const Graph& dag);
+
+    // 只枚举以 prefix 开头的序列（回溯不会退到前缀以内）；前缀不合法时返回 false（不限制）。
+    // reset 会清掉限制。
+    bool restrictToPrefix(const std::vector<int>& prefix);
+    const std::vector<int>& prefix() const { return mFloor; }
+
+    // 前进到下一条拓扑序列（第一次调用得到第一条）。返回 false 表示已经没有了。
+    bool next();
+
+    // 当前序列（next() 返回 true 之后有效）。
+    const std::vector<int>& order() const { return mCur; }
+    // 当前序列与上一条从第几位开始不同（前 changedFrom() 位相同）；第一条为 0。
+    int changedFrom() const { return mChangedFrom; }
+    // 已经吐出的条数。
+    std::uint64_t emitted() const { return mEmitted; }
+    bool finished() const { return mDone; }
+    int nodeCount() const { return mN; }
+
+    // 把状态定位到 order 这一条“刚吐出”之后，emitted 记为 emittedBefore + 1；
+    // 下一次 next() 给出它的后继。order 不是合法拓扑序时返回 false（状态被重置）。
+    bool seekAfter(const std::vector<int>& order, std::uint64_t emittedBefore);
+
+    // 检查点：当前状态序列化成字节（小端，带 DAG 指纹）。
+    std::string saveState() const;
+    // 从 saveState 的结果恢复；必须先 reset 到同一个 DAG。
+    // 指纹不符、数据截断或内部不一致（入度/已用标记与回溯栈对不上）时返回 false，状态被重置。
+    bool loadState(const std::uint8_t* data, std::size_t size);
+    bool loadState(const std::string& state)
+    {
+        return loadState(reinterpret_cast<const std::uint8_t*>(state.data()), state.size());
+    }
+
+    // DAG 的指纹（n + 全部出边），用来拒绝在别的图上恢复检查点。
+    std::uint64_t fingerprint() const { return mFingerprint; }
+
+private:
+    int mN = 0;
+    std::vector<std::vector<int>> mSucc;
+    std::vector<int> mInitIndeg;
+    std::uint64_t mFingerprint = 0;
+    std::vector<int> mFloor;       // 固定前缀（分片）
+
+    std::vector<int> mIndeg;       // 当前剩余入度
+    // 当前候选（入度为 0 且未选），有序。n ≤ 256 时放在定宽位图里（取最小 / 找下一个都是 ctz，
+    // 增删不分配），否则用 std::set。
+    bool mSmall = false;
+    NodeBits<4> mAvailBits;
+    std::set<int> mAvail;
+    std::vector<int> mCur;         // 已选的点 = 回溯栈
+    int mChangedFrom = 0;
+    std::uint64_t mEmitted = 0;
+    bool mStarted = false;
+    bool mDone = false;
+
+    bool isAvail(int u) const;
+    void addAvail(int u);
+    void dropAvail(int u);
+    int firstAvail() const;        // 没有候选返回 0
+    int availAfter(int u) const;   // 编号大于 u 的最小候选，没有返回 0
+
+    void restart();                // 回到“一条都还没吐”的状态（固定前缀已选好）
+    void choose(int u);
+    void unchoose(int u);
+    void descend();                // 每层取最小候选，直到选满或无路可走
+};
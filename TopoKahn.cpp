@@ -11,6 +11,10 @@
 
 // 算法模块：拓扑排序（Kahn）
 #include "TopoKahn.h"
+#include "NodeBits.h"
+#include "StepTrace.h"
+#include "Trace.h"
+#include <algorithm>
 #include <queue>
 
 namespace {
@@ -22,13 +26,20 @@ static void dfsAllTopo(
         std::vector<int>& cur,
         std::vector<std::vector<int>>& out,
         bool& ok,
-        int maxOrders)
+        int maxOrders,
+        TaskControl* ctl)
 {
     const int n = g.n;
     if ((int)cur.size() == n) {
         out.push_back(cur);
+        if (ctl) {
+            ctl->addFound();
+            const std::size_t bytes = out.size() * (sizeof(std::vector<int>) + n * sizeof(int));
+            if (bytes > ctl->memoryBudget(SIZE_MAX)) ctl->fail(TaskControl::Status::OutOfMemory);
+        }
         return;
     }
+    if (ctl && !ctl->tick()) return;
 
     // 找所有当前可选（未使用且入度为 0）的点。
     std::vector<int> cand;
@@ -45,6 +56,7 @@ static void dfsAllTopo(
 
     for (int u : cand) {
         if (maxOrders >= 0 && (int)out.size() >= maxOrders) return;
+        if (ctl && ctl->stopped()) return;
 
         used[u] = 1;
         cur.push_back(u);
@@ -52,7 +64,7 @@ static void dfsAllTopo(
         // 移除 u 对后继入度的影响
         for (int v : g.adj[u]) indeg[v]--;
 
-        dfsAllTopo(g, indeg, used, cur, out, ok, maxOrders);
+        dfsAllTopo(g, indeg, used, cur, out, ok, maxOrders, ctl);
         if (!ok) {
             // 仍需回溯恢复 indeg
         }
@@ -63,9 +75,59 @@ static void dfsAllTopo(
         used[u] = 0;
     }
 }
+
+// 同一棵回溯树的位图版本（n ≤ 64*W）：已用集合与候选集都是 W 个字，按值传给下一层，回溯不用恢复；
+// 候选按最低位依次取，顺序与上面的 for 循环相同。
+template <int W>
+void dfsAllTopoBits(
+        const std::vector<NodeBits<W>>& pred,
+        const std::vector<NodeBits<W>>& succ,
+        int n,
+        const NodeBits<W>& used,
+        const NodeBits<W>& cand,
+        std::vector<int>& cur,
+        std::vector<std::vector<int>>& out,
+        bool& ok,
+        int maxOrders,
+        TaskControl* ctl)
+{
+    if ((int)cur.size() == n) {
+        out.push_back(cur);
+        if (ctl) {
+            ctl->addFound();
+            const std::size_t bytes = out.size() * (sizeof(std::vector<int>) + n * sizeof(int));
+            if (bytes > ctl->memoryBudget(SIZE_MAX)) ctl->fail(TaskControl::Status::OutOfMemory);
+        }
+        return;
+    }
+    if (ctl && !ctl->tick()) return;
+
+    if (!cand.any()) {
+        ok = false;
+        return;
+    }
+
+    for (int u = cand.first(); u; u = cand.firstAfter(u)) {
+        if (maxOrders >= 0 && (int)out.size() >= maxOrders) return;
+        if (ctl && ctl->stopped()) return;
+
+        NodeBits<W> nextUsed = used;
+        nextUsed.set(u);
+        NodeBits<W> nextCand = cand;
+        nextCand.reset(u);
+        // 只有 u 的后继可能因此变成候选。
+        succ[u].minus(nextUsed).forEach([&](int v) {
+            if (pred[v].coveredBy(nextUsed)) nextCand.set(v);
+        });
+
+        cur.push_back(u);
+        dfsAllTopoBits(pred, succ, n, nextUsed, nextCand, cur, out, ok, maxOrders, ctl);
+        cur.pop_back();
+    }
+}
 } // namespace
 
-TopoResult TopoKahn::run(const Graph& dag){
+TopoResult TopoKahn::run(const Graph& dag, StepSink* sink){
     int n = dag.n;
     std::vector<int> indeg(n+1, 0);
     for(int u=1;u<=n;u++){
@@ -73,17 +135,18 @@ TopoResult TopoKahn::run(const Graph& dag){
     }
 
     std::vector<Step> steps;
+    auto record = [&](Step st) { if (sink) sink->put(st); else steps.push_back(std::move(st)); };
     for(int i=1;i<=n;i++){
-        steps.push_back({StepType::TopoInitIndeg, i, -1, -1, indeg[i],
-                         QString("初始化入度 indeg[%1]=%2").arg(i).arg(indeg[i])});
+        record({StepType::TopoInitIndeg, i, -1, -1, indeg[i],
+                QString("初始化入度 indeg[%1]=%2").arg(i).arg(indeg[i])});
     }
 
     std::queue<int> q;
     for(int i=1;i<=n;i++){
         if(indeg[i]==0){
             q.push(i);
-            steps.push_back({StepType::TopoEnqueue, i, -1, -1, 0,
-                             QString("入队 %1").arg(i)});
+            record({StepType::TopoEnqueue, i, -1, -1, 0,
+                    QString("入队 %1").arg(i)});
         }
     }
 
@@ -91,17 +154,17 @@ TopoResult TopoKahn::run(const Graph& dag){
     while(!q.empty()){
         int u=q.front(); q.pop();
         order.push_back(u);
-        steps.push_back({StepType::TopoDequeue, u, -1, -1, 0,
-                         QString("出队 %1").arg(u)});
+        record({StepType::TopoDequeue, u, -1, -1, 0,
+                QString("出队 %1").arg(u)});
 
         for(int v: dag.adj[u]){
             indeg[v]--;
-            steps.push_back({StepType::TopoIndegDec, u, v, -1, indeg[v],
-                             QString("indeg[%1]-- => %2").arg(v).arg(indeg[v])});
+            record({StepType::TopoIndegDec, u, v, -1, indeg[v],
+                    QString("indeg[%1]-- => %2").arg(v).arg(indeg[v])});
             if(indeg[v]==0){
                 q.push(v);
-                steps.push_back({StepType::TopoEnqueue, v, -1, -1, 0,
-                                 QString("入队 %1").arg(v)});
+                record({StepType::TopoEnqueue, v, -1, -1, 0,
+                        QString("入队 %1").arg(v)});
             }
         }
     }
@@ -113,8 +176,9 @@ TopoResult TopoKahn::run(const Graph& dag){
     return res;
 }
 
-TopoAllResult TopoKahn::enumerateAll(const Graph& dag, int maxOrders)
+TopoAllResult TopoKahn::enumerateAll(const Graph& dag, int maxOrders, TaskControl* ctl)
 {
+    TRACE_SCOPE("TopoKahn::enumerateAll");
     const int n = dag.n;
     std::vector<int> indeg(n + 1, 0);
     for (int u = 1; u <= n; ++u) {
@@ -123,69 +187,220 @@ TopoAllResult TopoKahn::enumerateAll(const Graph& dag, int maxOrders)
 
     TopoAllResult res;
     res.ok = true;
-    std::vector<char> used(n + 1, 0);
     std::vector<int> cur;
     cur.reserve(n);
-    dfsAllTopo(dag, indeg, used, cur, res.orders, res.ok, maxOrders);
+
+    // 点数不超过 256 时走位图内核，否则走通用的入度数组版本。
+    const bool small = withNodeBits(n, [&](auto width) {
+        constexpr int W = decltype(width)::value;
+        std::vector<NodeBits<W>> pred, succ;
+        nodeBitsAdjacency(dag, pred, succ);
+        NodeBits<W> cand;
+        for (int v = 1; v <= n; ++v) {
+            if (indeg[v] == 0) cand.set(v);
+        }
+        dfsAllTopoBits<W>(pred, succ, n, NodeBits<W>(), cand, cur, res.orders, res.ok, maxOrders, ctl);
+    });
+    if (small) return res;
+
+    std::vector<char> used(n + 1, 0);
+    dfsAllTopo(dag, indeg, used, cur, res.orders, res.ok, maxOrders, ctl);
     return res;
 }
 
-TopoResult TopoKahn::runWithOrder(const Graph& dag, const std::vector<int>& order)
+std::uint64_t TopoKahn::streamFrom(TopoEnumerator& it, OrderSink& sink, TaskControl* ctl,
+                                   const CheckpointFn& checkpoint, std::chrono::milliseconds interval)
 {
-    const int n = dag.n;
-    std::vector<int> indeg(n + 1, 0);
-    for (int u = 1; u <= n; ++u) {
-        for (int v : dag.adj[u]) indeg[v]++;
+    TRACE_SCOPE("TopoKahn::streamFrom");
+    // 读时钟也要钱：每 kClockEvery 条才看一次是否到了存检查点的时间。
+    constexpr std::uint64_t kClockEvery = 1024;
+    using Clock = std::chrono::steady_clock;
+    auto due = Clock::now() + interval;
+
+    auto save = [&]() { return sink.flush() && checkpoint(it); };
+
+    std::uint64_t out = 0;
+    const std::uint64_t n = std::uint64_t(std::max(1, it.nodeCount()));
+    for (;;) {
+        // 先确认要不要停，再前进：停下时枚举器正好停在“最后一条已交出”的位置。
+        if (ctl && ctl->stopped()) break;
+        if (!it.next()) break;
+        if (!sink.put(it.order(), it.changedFrom())) {
+            // 这一条没交出去：检查点不能越过它，直接返回（上一次检查点仍然有效）。
+            return out;
+        }
+        ++out;
+        if (ctl) {
+            ctl->addFound();
+            ctl->tick(n);
+        }
+        if (checkpoint && out % kClockEvery == 0 && Clock::now() >= due) {
+            if (!save()) return out;
+            due = Clock::now() + interval;
+        }
+    }
+    if (checkpoint) save();
+    return out;
+}
+
+KahnOrderStepper::KahnOrderStepper(const Graph& dag, std::vector<int> order_, int resumeDepth)
+    : G(&dag), order(std::move(order_)), n(dag.n)
+{
+    indeg.assign(n + 1, 0);
+    for (int x = 1; x <= n; ++x) {
+        for (int v : dag.adj[x]) indeg[v]++;
     }
+    removed.assign(n + 1, 0);
+    out.reserve(n);
+    orderOk = ((int)order.size() == n);
+    if (resumeDepth < 0) return;
 
-    std::vector<char> removed(n + 1, 0);
-    std::vector<Step> steps;
-    steps.reserve(4 * (n + (int)dag.edges.size()));
+    // 直接落到“前 resumeDepth 个已输出”的状态，跳过的步数与从头跑时一致：
+    // n 个初始化 + 到此为止入过队的点（此刻入度为 0 的点，含已输出的）+ resumeDepth 个出队 + 处理过的边。
+    resumeDepth = std::min(resumeDepth, std::min(n, (int)order.size()));
+    std::size_t edges = 0;
+    for (k = 0; k < resumeDepth; ++k) {
+        const int x = order[k];
+        if (x < 1 || x > n || removed[x] || indeg[x] != 0) {
+            orderOk = false;
+            phase = Phase::Done;
+            return;
+        }
+        removed[x] = 1;
+        out.push_back(x);
+        for (int v : dag.adj[x]) {
+            if (removed[v]) continue;
+            indeg[v]--;
+            ++edges;
+        }
+    }
+    std::size_t zeros = 0;
+    for (int x = 1; x <= n; ++x) zeros += (indeg[x] == 0);
+    skipped = std::size_t(n) + zeros + std::size_t(resumeDepth) + edges;
+    phase = Phase::Select;
+}
 
-    // 1) 初始化入度
-    for (int i = 1; i <= n; ++i) {
-        steps.push_back({StepType::TopoInitIndeg, i, -1, -1, indeg[i],
-                         QString("初始化入度 indeg[%1]=%2").arg(i).arg(indeg[i])});
+std::vector<std::size_t> KahnOrderStepper::prefixSteps(const Graph& dag, const std::vector<int>& order, int depth)
+{
+    const int n = dag.n;
+    std::vector<int> indeg(n + 1, 0);
+    for (int x = 1; x <= n; ++x) {
+        for (int v : dag.adj[x]) indeg[v]++;
     }
+    std::size_t pos = std::size_t(n);   // 初始化入度
+    for (int x = 1; x <= n; ++x) pos += (indeg[x] == 0);   // 初始入队
 
-    // 2) 初始可选（入度为 0）节点
-    for (int i = 1; i <= n; ++i) {
-        if (indeg[i] == 0) {
-            steps.push_back({StepType::TopoEnqueue, i, -1, -1, 0,
-                             QString("入度为 0，加入候选 %1").arg(i)});
+    std::vector<std::size_t> res;
+    res.reserve(std::size_t(depth) + 1);
+    res.push_back(pos);
+    for (int d = 0; d < depth; ++d) {
+        // 出队一步 + 每条出边一步 + 其中入度归零的再各一步入队（合法前缀里后继都还没输出）。
+        const int x = order[d];
+        ++pos;
+        for (int v : dag.adj[x]) {
+            ++pos;
+            if (--indeg[v] == 0) ++pos;
         }
+        res.push_back(pos);
     }
+    return res;
+}
 
-    std::vector<int> out;
-    out.reserve(n);
+bool KahnOrderStepper::next(Step& step)
+{
+    for (;;) {
+        switch (phase) {
+        // 1) 初始化入度
+        case Phase::InitIndeg:
+            if (cursor <= n) {
+                step = {StepType::TopoInitIndeg, cursor, -1, -1, indeg[cursor], QString()};
+                ++cursor;
+                return true;
+            }
+            cursor = 1;
+            phase = Phase::InitQueue;
+            break;
 
-    // 3) 按给定 order 依次选择
-    bool ok = ((int)order.size() == n);
-    for (int k = 0; k < (int)order.size() && k < n; ++k) {
-        const int u = order[k];
-        if (u < 1 || u > n || removed[u]) { ok = false; break; }
-        if (indeg[u] != 0) { ok = false; break; }
+        // 2) 初始可选（入度为 0）节点
+        case Phase::InitQueue:
+            while (cursor <= n && indeg[cursor] != 0) ++cursor;
+            if (cursor <= n) {
+                step = {StepType::TopoEnqueue, cursor, -1, -1, 0, QString()};
+                ++cursor;
+                return true;
+            }
+            phase = Phase::Select;
+            break;
 
-        removed[u] = 1;
-        out.push_back(u);
-        steps.push_back({StepType::TopoDequeue, u, -1, -1, 0,
-                         QString("选择 %1 作为本序列第 %2 个输出").arg(u).arg(k + 1)});
+        // 3) 按给定 order 依次选择
+        case Phase::Select: {
+            if (k >= (int)order.size() || k >= n) {
+                phase = Phase::Done;
+                break;
+            }
+            const int x = order[k];
+            if (x < 1 || x > n || removed[x] || indeg[x] != 0) {
+                orderOk = false;
+                phase = Phase::Done;
+                break;
+            }
+            removed[x] = 1;
+            out.push_back(x);
+            ++k;
+            u = x;
+            edge = 0;
+            step = {StepType::TopoDequeue, x, -1, -1, k, QString()};
+            phase = Phase::Edges;
+            return true;
+        }
 
-        for (int v : dag.adj[u]) {
-            if (removed[v]) continue;
-            indeg[v]--;
-            steps.push_back({StepType::TopoIndegDec, u, v, -1, indeg[v],
-                             QString("处理边 %1->%2, indeg[%2]-- => %3").arg(u).arg(v).arg(indeg[v])});
-            if (indeg[v] == 0) {
-                steps.push_back({StepType::TopoEnqueue, v, -1, -1, 0,
-                                 QString("入度变为 0，加入候选 %1").arg(v)});
+        case Phase::Edges: {
+            const std::vector<int>& adj = G->adj[u];
+            while (edge < adj.size()) {
+                const int v = adj[edge++];
+                if (removed[v]) continue;
+                indeg[v]--;
+                step = {StepType::TopoIndegDec, u, v, -1, indeg[v], QString()};
+                if (indeg[v] == 0) {
+                    enqueued = v;
+                    phase = Phase::Enqueue;
+                }
+                return true;
             }
+            phase = Phase::Select;
+            break;
+        }
+
+        case Phase::Enqueue:
+            step = {StepType::TopoEnqueue, enqueued, -1, -1, 0, QString()};
+            phase = Phase::Edges;
+            return true;
+
+        case Phase::Done:
+            return false;
+        }
+    }
+}
+
+TopoResult TopoKahn::runWithOrder(const Graph& dag, const std::vector<int>& order, StepSink* sink)
+{
+    KahnOrderStepper stepper(dag, order);
+    std::vector<Step> steps;
+    if (!sink) steps.reserve(stepper.sizeHint());
+
+    Step step;
+    while (stepper.next(step)) {
+        if (sink) {
+            sink->put(step);
+        } else {
+            step.note = stepNote(step, TraceAlgorithm::KahnOrder);
+            steps.push_back(std::move(step));
         }
     }
 
     TopoResult res;
-    res.ok = ok && ((int)out.size() == n);
-    res.order = out;
-    res.steps = steps;
+    res.ok = stepper.ok();
+    res.order = stepper.output();
+    res.steps = std::move(steps);
     return res;
 }
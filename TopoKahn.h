@@ -10,6 +10,12 @@
 #pragma once
 #include "Graph.h"
 #include "Steps.h"
+#include "TaskControl.h"
+#include "OrderStream.h"
+#include "TopoEnumerator.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 struct TopoResult{
@@ -24,15 +30,75 @@ struct TopoAllResult{
     std::vector<std::vector<int>> orders;
 };
 
+// 按给定拓扑序列演示 Kahn 的可暂停版本：每调一次 next() 只推进到下一个 Step。
+// 除了 Kahn 本来就要的入度/已输出数组，暂停时只记几个游标（第几条输出、扫到哪条出边）。
+// 产出的步与 TopoKahn::runWithOrder 完全相同（后者就是把它一口气跑完）。
+//
+// 两条序列前 d 个输出相同时，它们的 trace 在“第 d+1 个输出”之前一步不差。
+// resumeDepth = d 时直接从那里开始：前 d 个输出对入度的影响在构造时一次算好（O(n + m)），
+// 之前的 skipped() 步不再产出，由调用方沿用上一条序列已经播过的部分（见 Timeline::branch）。
+class KahnOrderStepper : public StepSource {
+public:
+    // dag 须在 stepper 用完之前保持有效；resumeDepth < 0 表示从头开始。
+    KahnOrderStepper(const Graph& dag, std::vector<int> order, int resumeDepth = -1);
+
+    bool next(Step& out) override;
+    // 序列合法时整条 trace：n 个初始化入度 + n 个入队 + n 个出队 + m 条边各一次入度减一，再减去跳过的。
+    std::size_t sizeHint() const override { return 3 * std::size_t(n) + G->edges.size() - skipped; }
+    std::size_t skippedSteps() const { return skipped; }
+
+    // 整条 trace 里第 d+1 个输出（出队）那一步的下标，d = 0..depth；order 的前 depth 个须是合法前缀。
+    static std::vector<std::size_t> prefixSteps(const Graph& dag, const std::vector<int>& order, int depth);
+
+    bool done() const { return phase == Phase::Done; }
+    bool ok() const { return orderOk && (int)out.size() == n; }   // done() 之后有效
+    const std::vector<int>& output() const { return out; }
+
+private:
+    enum class Phase { InitIndeg, InitQueue, Select, Edges, Enqueue, Done };
+
+    const Graph* G = nullptr;
+    std::vector<int> order;
+    int n = 0;
+    std::vector<int> indeg;
+    std::vector<char> removed;
+    std::vector<int> out;
+    bool orderOk = false;
+    std::size_t skipped = 0;
+
+    Phase phase = Phase::InitIndeg;
+    int cursor = 1;          // 初始化阶段扫到的点
+    int k = 0;               // 下一个要输出的是 order[k]
+    int u = -1;              // 正在处理出边的点
+    std::size_t edge = 0;    // 下一条要处理的出边 adj[u][edge]
+    int enqueued = -1;       // 入度刚变成 0、等着记入队的点
+};
+
 class TopoKahn{
 public:
-    TopoResult run(const Graph& dag);
+    // sink 非空时 steps 逐条交给它（结果里的 steps 为空），下同。
+    TopoResult run(const Graph& dag, StepSink* sink = nullptr);
 
     // 生成所有拓扑序列（回溯枚举）。
     // maxOrders < 0 表示不设上限；仅用于防止极端情况下卡死。
-    TopoAllResult enumerateAll(const Graph& dag, int maxOrders = -1);
+    // ctl 非空时可被取消/限时，结果占用超过 ctl 的内存预算时以 OutOfMemory 终止。
+    TopoAllResult enumerateAll(const Graph& dag, int maxOrders = -1, TaskControl* ctl = nullptr);
+
+    // 检查点回调：拿到的枚举器状态与 sink 里已落盘的内容一致（刚 flush 过）。返回 false 则停止。
+    using CheckpointFn = std::function<bool(const TopoEnumerator& it)>;
+
+    // 把全部拓扑序列按同样的顺序流式交给 sink（边枚举边写，内存与条数无关，不递归）：
+    // 从枚举器当前位置（刚 reset / seekAfter / loadState 过）继续往 sink 交，
+    // 每隔 interval 存一次检查点；因取消、超时提前停下时也会再存一次，
+    // 下次 loadState 之后接着跑，不重不漏。sink 写失败时不存检查点，直接返回：
+    // 以上一次存下的检查点为准（失败那条可能只写了一半，续写时从检查点记录的文件长度截断重来）。
+    // 返回本次交出的条数。
+    std::uint64_t streamFrom(TopoEnumerator& it, OrderSink& sink, TaskControl* ctl = nullptr,
+                             const CheckpointFn& checkpoint = nullptr,
+                             std::chrono::milliseconds interval = std::chrono::seconds(10));
 
     // 给定一个拓扑序列 order，用它“驱动”Kahn 过程生成可视化 steps。
     // 这用于“每次播放只演示一个拓扑序”。
-    TopoResult runWithOrder(const Graph& dag, const std::vector<int>& order);
+    // 出队步的 val 记“本序列第几个输出”（1 起），日志文字丢掉之后（见 StepTrace）还能复原。
+    TopoResult runWithOrder(const Graph& dag, const std::vector<int>& order, StepSink* sink = nullptr);
 };
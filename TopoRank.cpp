@@ -0,0 +1,838 @@
+/* ANNOTATED_FOR_STUDY
+@file TopoRank.cpp
+@brief 拓扑序列计数（记忆化 DFS，显式栈）与按下标解码。
+*/
+
+#include "TopoRank.h"
+#include "Condense.h"
+#include "NodeBits.h"
+#include "Trace.h"
+#include "TopoEnumerator.h"
+#include "TwinClasses.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+std::uint64_t addSat(std::uint64_t a, std::uint64_t b)
+{
+    return (a > TopoRank::kSaturated - b) ? TopoRank::kSaturated : a + b;
+}
+
+std::uint64_t mulSat(std::uint64_t a, std::uint64_t b)
+{
+    if (a == 0 || b == 0) return 0;
+    return (a > TopoRank::kSaturated / b) ? TopoRank::kSaturated : a * b;
+}
+
+// C(n, k)，饱和。逐项乘 C(n-k+i, i) = C(n-k+i-1, i-1) * (n-k+i) / i，先约掉公因子再乘，中间值不溢出。
+std::uint64_t binomSat(std::uint64_t n, std::uint64_t k)
+{
+    k = std::min(k, n - k);
+    std::uint64_t c = 1;
+    for (std::uint64_t i = 1; i <= k; ++i) {
+        const std::uint64_t g = std::gcd(c, i);
+        const std::uint64_t t = (n - k + i) / (i / g);
+        c /= g;
+        if (c > TopoRank::kSaturated / t) return TopoRank::kSaturated;
+        c *= t;
+    }
+    return c;
+}
+
+// Π r_i!，饱和（21! 就超过 2^64 了，循环很短）。
+std::uint64_t factorialProductSat(const std::vector<int>& r)
+{
+    std::uint64_t res = 1;
+    for (int x : r) {
+        for (int i = 2; i <= x; ++i) {
+            res = mulSat(res, std::uint64_t(i));
+            if (res == TopoRank::kSaturated) return res;
+        }
+    }
+    return res;
+}
+
+// 多项式系数 (Σr; r1, r2, ...) = 各分量剩余的点交错排列的方式数，饱和。
+std::uint64_t multinomialSat(const std::vector<int>& r)
+{
+    std::uint64_t res = 1, sum = 0;
+    for (int x : r) {
+        sum += std::uint64_t(x);
+        res = mulSat(res, binomSat(sum, std::uint64_t(x)));
+        if (res == TopoRank::kSaturated) break;
+    }
+    return res;
+}
+
+// 定宽位图内核的计数表：开放寻址（线性探测），键值就地存放，不像 unordered_map 每个状态分配一个节点。
+// 装载因子不超过 1/2；只插不删。
+template <int W>
+class BitsMemo {
+public:
+    // 每个状态的内存（粗估）：槽位 + 占用标记，装载在 1/4 ~ 1/2 之间，平均按每个状态 3 个槽算。
+    static constexpr std::size_t kBytesPerState = 3 * (sizeof(NodeBits<W>) + sizeof(std::uint64_t) + 1);
+
+    std::size_t size() const { return mSize; }
+
+    const std::uint64_t* find(const NodeBits<W>& key) const
+    {
+        if (mSize == 0) return nullptr;
+        for (std::size_t i = NodeBitsHash<W>()(key) & mMask;; i = (i + 1) & mMask) {
+            if (!mUsed[i]) return nullptr;
+            if (mSlots[i].key == key) return &mSlots[i].value;
+        }
+    }
+
+    // key 必须还不在表里。
+    void insert(const NodeBits<W>& key, std::uint64_t value)
+    {
+        if (2 * (mSize + 1) > mSlots.size()) grow();
+        place(key, value);
+        ++mSize;
+    }
+
+private:
+    struct Slot {
+        NodeBits<W> key;
+        std::uint64_t value;
+    };
+    std::vector<Slot> mSlots;
+    std::vector<std::uint8_t> mUsed;
+    std::size_t mMask = 0;
+    std::size_t mSize = 0;
+
+    void place(const NodeBits<W>& key, std::uint64_t value)
+    {
+        std::size_t i = NodeBitsHash<W>()(key) & mMask;
+        while (mUsed[i]) i = (i + 1) & mMask;
+        mUsed[i] = 1;
+        mSlots[i] = {key, value};
+    }
+
+    void grow()
+    {
+        std::vector<Slot> slots(std::max<std::size_t>(64, mSlots.size() * 2));
+        std::vector<std::uint8_t> used(slots.size(), 0);
+        slots.swap(mSlots);
+        used.swap(mUsed);
+        mMask = mSlots.size() - 1;
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            if (used[i]) place(slots[i].key, slots[i].value);
+        }
+    }
+};
+} // namespace
+
+// ---------------- 定宽位图内核（n ≤ 64*W） ----------------
+// 与下面的通用实现是同一套记忆化计数与逐位解码，区别只在位图的表示。
+
+template <int W>
+class TopoRank::BitsKernel final : public TopoRank::Kernel {
+public:
+    using Bits = NodeBits<W>;
+
+    explicit BitsKernel(const Graph& dag)
+        : mN(dag.n)
+    {
+        nodeBitsAdjacency(dag, mPred, mSucc);
+        for (int v = 1; v <= mN; ++v) {
+            if (!mPred[v].any()) mRoot.set(v);
+        }
+    }
+
+    bool count(std::size_t memoryBudget, TaskControl* ctl, std::uint64_t& total) override
+    {
+        // 显式栈；next 是这一层已经试过的最大候选，下一个候选就是 cand.firstAfter(next)。
+        struct Frame {
+            Bits used;
+            Bits cand;
+            int next = 0;
+            std::uint64_t sum = 0;
+        };
+        const std::size_t maxStates = memoryBudget / BitsMemo<W>::kBytesPerState;
+
+        std::vector<Frame> stack;
+        stack.reserve(std::size_t(mN) + 1);
+        stack.push_back({Bits(), mRoot, 0, 0});
+        while (!stack.empty()) {
+            const std::size_t top = stack.size() - 1;
+            const int u = stack[top].cand.firstAfter(stack[top].next);
+            if (u) {
+                stack[top].next = u;
+                Bits child = stack[top].used;
+                child.set(u);
+
+                if (const std::uint64_t* c = mMemo.find(child)) {
+                    stack[top].sum = addSat(stack[top].sum, *c);
+                    continue;
+                }
+                if (mMemo.size() + stack.size() >= maxStates) return false;
+                if (ctl && !ctl->tick()) return false;
+
+                Bits cand = nextCandidates(stack[top].cand, u, child);
+                stack.push_back({child, cand, 0, 0});
+                continue;
+            }
+
+            const Frame& f = stack[top];
+            const std::uint64_t value = f.cand.any() ? f.sum : (int(top) == mN ? 1 : 0);
+            mMemo.insert(f.used, value);
+            stack.pop_back();
+            if (!stack.empty()) stack.back().sum = addSat(stack.back().sum, value);
+        }
+        total = *mMemo.find(Bits());
+        return true;
+    }
+
+    std::vector<int> orderAt(std::uint64_t index) const override
+    {
+        std::vector<int> out;
+        out.reserve(std::size_t(mN));
+        Bits used;
+        Bits cand = mRoot;
+        for (int k = 0; k < mN; ++k) {
+            int picked = 0;
+            for (int u = cand.first(); u; u = cand.firstAfter(u)) {
+                Bits child = used;
+                child.set(u);
+                const std::uint64_t* c = mMemo.find(child);
+                if (!c) return {};
+                if (index < *c) {
+                    picked = u;
+                    used = child;
+                    break;
+                }
+                index -= *c;
+            }
+            if (!picked) return {};
+            out.push_back(picked);
+            cand = nextCandidates(cand, picked, used);
+        }
+        return out;
+    }
+
+    std::uint64_t countWithPrefix(const std::vector<int>& prefix) const override
+    {
+        Bits used;
+        for (int u : prefix) {
+            if (u < 1 || u > mN || used.test(u) || !mPred[u].coveredBy(used)) return 0;
+            used.set(u);
+        }
+        const std::uint64_t* c = mMemo.find(used);
+        return c ? *c : 0;
+    }
+
+    std::size_t states() const override { return mMemo.size(); }
+    std::size_t bytes() const override { return mMemo.size() * BitsMemo<W>::kBytesPerState; }
+
+    class BitsWalker final : public Walker {
+    public:
+        explicit BitsWalker(const BitsKernel& k) : mK(k), mCand(k.mRoot) {}
+        void candidates(std::vector<int>& out) const override
+        {
+            mCand.forEach([&out](int v) { out.push_back(v); });
+        }
+        std::uint64_t countAfter(int u) const override
+        {
+            Bits child = mUsed;
+            child.set(u);
+            const std::uint64_t* c = mK.mMemo.find(child);
+            return c ? *c : 0;
+        }
+        void choose(int u) override
+        {
+            mUsed.set(u);
+            mCand = mK.nextCandidates(mCand, u, mUsed);
+        }
+
+    private:
+        const BitsKernel& mK;
+        Bits mUsed;
+        Bits mCand;
+    };
+    std::unique_ptr<Walker> walk() const override { return std::make_unique<BitsWalker>(*this); }
+
+private:
+    int mN = 0;
+    std::vector<Bits> mPred;
+    std::vector<Bits> mSucc;
+    Bits mRoot;                                 // 没有前驱的点 = 初始候选
+    BitsMemo<W> mMemo;
+
+    // 输出 u（used 已包含 u）之后的候选：去掉 u，再看 u 的后继里哪些前驱已经全部输出。
+    Bits nextCandidates(const Bits& cand, int u, const Bits& used) const
+    {
+        Bits next = cand;
+        next.reset(u);
+        mSucc[u].minus(used).forEach([&](int v) {
+            if (mPred[v].coveredBy(used)) next.set(v);
+        });
+        return next;
+    }
+};
+
+// ---------------- 通用内核（vector 位图，点数不限） ----------------
+
+class TopoRank::VectorKernel final : public TopoRank::Kernel {
+    using Mask = std::vector<std::uint64_t>;   // 已输出点集合的位图，第 i 位 = 节点 i
+    struct MaskHash {
+        std::size_t operator()(const Mask& m) const
+        {
+            std::uint64_t h = 0x9e3779b97f4a7c15ULL;
+            for (std::uint64_t w : m) {
+                h ^= w + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            }
+            return std::size_t(h);
+        }
+    };
+
+public:
+    explicit VectorKernel(const Graph& dag)
+        : mN(dag.n), mWords((dag.n + 1 + 63) / 64)
+    {
+        mPred.assign(mN + 1, {});
+        mSucc.assign(mN + 1, {});
+        for (int u = 1; u <= mN; ++u) {
+            for (int v : dag.adj[u]) {
+                mPred[v].push_back(u);
+                mSucc[u].push_back(v);
+            }
+        }
+    }
+
+    bool count(std::size_t memoryBudget, TaskControl* ctl, std::uint64_t& total) override;
+    std::vector<int> orderAt(std::uint64_t index) const override;
+    std::uint64_t countWithPrefix(const std::vector<int>& prefix) const override;
+    std::size_t states() const override { return mMemo.size(); }
+    std::size_t bytes() const override { return mMemo.size() * stateBytes(); }
+
+    class VectorWalker final : public Walker {
+    public:
+        explicit VectorWalker(const VectorKernel& k)
+            : mK(k), mUsed(std::size_t(k.mWords), 0), mCand(k.rootCandidates()) {}
+        void candidates(std::vector<int>& out) const override { out.insert(out.end(), mCand.begin(), mCand.end()); }
+        std::uint64_t countAfter(int u) const override
+        {
+            Mask child = mUsed;
+            set(child, u);
+            auto it = mK.mMemo.find(child);
+            return it == mK.mMemo.end() ? 0 : it->second;
+        }
+        void choose(int u) override
+        {
+            set(mUsed, u);
+            mCand = mK.nextCandidates(mCand, u, mUsed);
+        }
+
+    private:
+        const VectorKernel& mK;
+        Mask mUsed;
+        std::vector<int> mCand;
+    };
+    std::unique_ptr<Walker> walk() const override { return std::make_unique<VectorWalker>(*this); }
+
+private:
+    int mN = 0;
+    int mWords = 0;
+    std::vector<std::vector<int>> mPred;       // [v] = v 的所有前驱
+    std::vector<std::vector<int>> mSucc;       // [u] = u 的所有后继
+    std::unordered_map<Mask, std::uint64_t, MaskHash> mMemo;
+
+    static bool test(const Mask& m, int i) { return (m[std::size_t(i >> 6)] >> (i & 63)) & 1u; }
+    static void set(Mask& m, int i) { m[std::size_t(i >> 6)] |= std::uint64_t(1) << (i & 63); }
+    // 每个状态：位图本身 + 哈希表节点的额外开销（粗估）。
+    std::size_t stateBytes() const { return std::size_t(mWords) * sizeof(std::uint64_t) + 64; }
+
+    std::vector<int> rootCandidates() const;
+    // 已知 parent 状态的候选集 cand，输出 u（used 已包含 u）之后的候选集，保持升序。
+    std::vector<int> nextCandidates(const std::vector<int>& cand, int u, const Mask& used) const;
+};
+
+std::vector<int> TopoRank::VectorKernel::rootCandidates() const
+{
+    std::vector<int> cand;
+    for (int v = 1; v <= mN; ++v) {
+        if (mPred[v].empty()) cand.push_back(v);
+    }
+    return cand;
+}
+
+std::vector<int> TopoRank::VectorKernel::nextCandidates(const std::vector<int>& cand, int u, const Mask& used) const
+{
+    // 输出 u 只可能让 u 的后继变成新候选，不用每次把 n 个点都扫一遍。
+    std::vector<int> next;
+    next.reserve(cand.size() + mSucc[u].size());
+    for (int c : cand) {
+        if (c != u) next.push_back(c);
+    }
+    const std::size_t old = next.size();
+    for (int v : mSucc[u]) {
+        if (test(used, v)) continue;
+        bool ready = true;
+        for (int p : mPred[v]) {
+            if (!test(used, p)) { ready = false; break; }
+        }
+        if (ready) next.push_back(v);
+    }
+    if (next.size() != old) {
+        // 重边会让同一个后继被加两次。
+        std::sort(next.begin() + std::ptrdiff_t(old), next.end());
+        next.erase(std::unique(next.begin() + std::ptrdiff_t(old), next.end()), next.end());
+        std::inplace_merge(next.begin(), next.begin() + std::ptrdiff_t(old), next.end());
+    }
+    return next;
+}
+
+bool TopoRank::VectorKernel::count(std::size_t memoryBudget, TaskControl* ctl, std::uint64_t& total)
+{
+    // 和 dfsAllTopo 一样的搜索树，只是每个点集合只算一次；
+    // 用显式栈代替递归（深度 = n，链状大图递归会爆栈）。
+    struct Frame {
+        Mask used;
+        std::vector<int> cand;
+        std::size_t next = 0;
+        std::uint64_t sum = 0;
+    };
+    const std::size_t maxStates = memoryBudget / stateBytes();
+
+    const Mask root(std::size_t(mWords), 0);
+    std::vector<Frame> stack;
+    stack.push_back({root, rootCandidates(), 0, 0});
+
+    while (!stack.empty()) {
+        const std::size_t top = stack.size() - 1;
+        if (stack[top].next < stack[top].cand.size()) {
+            const int u = stack[top].cand[stack[top].next];
+            Mask child = stack[top].used;
+            set(child, u);
+
+            auto it = mMemo.find(child);
+            if (it != mMemo.end()) {
+                stack[top].sum = addSat(stack[top].sum, it->second);
+                ++stack[top].next;
+                continue;
+            }
+            if (mMemo.size() + stack.size() >= maxStates) return false; // 栈上的帧也各持一份位图
+            if (ctl && !ctl->tick()) return false;
+
+            std::vector<int> cand = nextCandidates(stack[top].cand, u, child);
+            stack.push_back({std::move(child), std::move(cand), 0, 0});
+            continue;
+        }
+
+        // 所有候选都算完了：叶子（候选为空）要么是全集（1 条），要么卡在环上（0 条）。
+        // 第 top 层的状态恰好输出了 top 个点。
+        Frame& f = stack[top];
+        std::uint64_t value = f.sum;
+        if (f.cand.empty()) value = (int(top) == mN) ? 1 : 0;
+        mMemo.emplace(std::move(f.used), value);
+        stack.pop_back();
+        if (!stack.empty()) {
+            Frame& parent = stack.back();
+            parent.sum = addSat(parent.sum, value);
+            ++parent.next;
+        }
+    }
+
+    total = mMemo.at(root);
+    return true;
+}
+
+std::vector<int> TopoRank::VectorKernel::orderAt(std::uint64_t index) const
+{
+    // 逐位解码：候选按编号升序，依次跳过整棵子树的序列数。
+    std::vector<int> out;
+    out.reserve(std::size_t(mN));
+    Mask used(std::size_t(mWords), 0);
+    std::vector<int> cand = rootCandidates();
+    for (int k = 0; k < mN; ++k) {
+        int picked = -1;
+        for (int u : cand) {
+            Mask child = used;
+            set(child, u);
+            const std::uint64_t c = mMemo.at(child);
+            if (index < c) {
+                picked = u;
+                used = std::move(child);
+                break;
+            }
+            index -= c;
+        }
+        if (picked < 0) return {};
+        out.push_back(picked);
+        cand = nextCandidates(cand, picked, used);
+    }
+    return out;
+}
+
+std::uint64_t TopoRank::VectorKernel::countWithPrefix(const std::vector<int>& prefix) const
+{
+    Mask used(std::size_t(mWords), 0);
+    for (int u : prefix) {
+        if (u < 1 || u > mN || test(used, u)) return 0;
+        for (int p : mPred[u]) {
+            if (!test(used, p)) return 0;
+        }
+        set(used, u);
+    }
+    auto it = mMemo.find(used);
+    return it == mMemo.end() ? 0 : it->second;
+}
+
+// ---------------- 孪生点压缩（见 TwinClasses.h） ----------------
+// 内层内核在“类内串链”的图上计数：用掉某类的第几个就对应链上的第几个点。
+// 原图状态的条数 = 内层典范状态的条数 × Π（每类剩余个数）!。
+
+class TopoRank::TwinKernel final : public TopoRank::Kernel {
+public:
+    TwinKernel(const Graph& dag, TwinClasses twins)
+        : mN(dag.n), mTwins(std::move(twins)), mInner(makePlainKernel(twinCanonicalDag(dag, mTwins)))
+    {
+        for (const auto& m : mTwins.members) mSizes.push_back(int(m.size()));
+    }
+
+    bool count(std::size_t memoryBudget, TaskControl* ctl, std::uint64_t& total) override
+    {
+        std::uint64_t canonical = 0;
+        if (!mInner->count(memoryBudget, ctl, canonical)) return false;
+        total = mulSat(canonical, factorialProductSat(mSizes));
+        return true;
+    }
+
+    std::vector<int> orderAt(std::uint64_t index) const override
+    {
+        std::unique_ptr<Walker> w = walk();
+        std::vector<int> out, cand;
+        out.reserve(std::size_t(mN));
+        for (int k = 0; k < mN; ++k) {
+            cand.clear();
+            w->candidates(cand);
+            int picked = 0;
+            for (int u : cand) {
+                const std::uint64_t c = w->countAfter(u);
+                if (index < c) {
+                    picked = u;
+                    break;
+                }
+                index -= c;
+            }
+            if (!picked) return {};
+            out.push_back(picked);
+            w->choose(picked);
+        }
+        return out;
+    }
+
+    std::uint64_t countWithPrefix(const std::vector<int>& prefix) const override
+    {
+        // 前缀里每类第 j 个出现的点换成该类的第 j 个点，就是内层图上的典范前缀。
+        std::vector<int> left = mSizes;
+        std::vector<char> seen(std::size_t(mN) + 1, 0);
+        std::vector<int> canonical;
+        canonical.reserve(prefix.size());
+        for (int u : prefix) {
+            if (u < 1 || u > mN || seen[std::size_t(u)]) return 0;
+            seen[std::size_t(u)] = 1;
+            const int c = mTwins.classOf[std::size_t(u)];
+            const auto& m = mTwins.members[std::size_t(c)];
+            canonical.push_back(m[m.size() - std::size_t(left[std::size_t(c)]--)]);
+        }
+        return mulSat(mInner->countWithPrefix(canonical), factorialProductSat(left));
+    }
+
+    std::size_t states() const override { return mInner->states(); }
+    std::size_t bytes() const override { return mInner->bytes(); }
+
+    class TwinWalker final : public Walker {
+    public:
+        explicit TwinWalker(const TwinKernel& k)
+            : mK(k), mInner(k.mInner->walk()), mLeft(k.mSizes), mSeen(std::size_t(k.mN) + 1, 0)
+        {
+            mPerms = factorialProductSat(mLeft);
+            for (int x : mLeft) mLogPerms += std::lgamma(double(x) + 1.0) / std::log(2.0);
+        }
+
+        void candidates(std::vector<int>& out) const override
+        {
+            // 内层的候选是各类链上的下一个点；原图上这一类还没用的点都是候选。
+            mInnerCand.clear();
+            mInner->candidates(mInnerCand);
+            const std::size_t old = out.size();
+            for (int x : mInnerCand) {
+                const auto& m = mK.mTwins.members[std::size_t(mK.mTwins.classOf[std::size_t(x)])];
+                for (int v : m) {
+                    if (!mSeen[std::size_t(v)]) out.push_back(v);
+                }
+            }
+            std::sort(out.begin() + std::ptrdiff_t(old), out.end());
+        }
+
+        std::uint64_t countAfter(int u) const override
+        {
+            const std::size_t c = std::size_t(mK.mTwins.classOf[std::size_t(u)]);
+            return mulSat(mInner->countAfter(next(c)), permsAfter(c));
+        }
+
+        void choose(int u) override
+        {
+            const std::size_t c = std::size_t(mK.mTwins.classOf[std::size_t(u)]);
+            mPerms = permsAfter(c);
+            mLogPerms -= std::log2(double(mLeft[c]));
+            mInner->choose(next(c));
+            --mLeft[c];
+            mSeen[std::size_t(u)] = 1;
+        }
+
+    private:
+        const TwinKernel& mK;
+        std::unique_ptr<Walker> mInner;
+        std::vector<int> mLeft;          // 每类还剩几个
+        std::vector<char> mSeen;
+        std::uint64_t mPerms = 1;        // Π mLeft!，饱和
+        double mLogPerms = 0.0;          // 它的 log2：饱和以后靠它判断少一个还是不是饱和
+        mutable std::vector<int> mInnerCand;
+
+        int next(std::size_t c) const
+        {
+            const auto& m = mK.mTwins.members[c];
+            return m[m.size() - std::size_t(mLeft[c])];
+        }
+        // 第 c 类少一个之后的 Π mLeft!。
+        std::uint64_t permsAfter(std::size_t c) const
+        {
+            if (mPerms != kSaturated) return mPerms / std::uint64_t(mLeft[c]);
+            if (mLogPerms - std::log2(double(mLeft[c])) > 65.0) return kSaturated;
+            std::vector<int> left = mLeft;
+            --left[c];
+            return factorialProductSat(left);
+        }
+    };
+    std::unique_ptr<Walker> walk() const override { return std::make_unique<TwinWalker>(*this); }
+
+private:
+    int mN = 0;
+    TwinClasses mTwins;
+    std::vector<int> mSizes;             // 每类的大小
+    std::unique_ptr<Kernel> mInner;
+};
+
+// ---------------- TopoRank ----------------
+
+std::unique_ptr<TopoRank::Kernel> TopoRank::makePlainKernel(const Graph& g)
+{
+    std::unique_ptr<Kernel> k;
+    withNodeBits(g.n, [&](auto width) { k = std::make_unique<BitsKernel<decltype(width)::value>>(g); });
+    if (!k) k = std::make_unique<VectorKernel>(g);
+    return k;
+}
+
+std::unique_ptr<TopoRank::Kernel> TopoRank::makeKernel(const Graph& g)
+{
+    // 有孪生点时套一层孪生压缩：k 个孪生点的状态从 2^k 个降到 k+1 个。
+    TwinClasses twins = findTwins(g);
+    if (twins.any()) return std::make_unique<TwinKernel>(g, std::move(twins));
+    return makePlainKernel(g);
+}
+
+void TopoRank::clear()
+{
+    mN = 0;
+    mParts.clear();
+    mPartOf.clear();
+    mLocal.clear();
+    mTotal = 0;
+    mCounted = false;
+    mPrefix.clear();
+}
+
+std::size_t TopoRank::states() const
+{
+    std::size_t n = 0;
+    for (const Part& p : mParts) n += p.kernel->states();
+    return n;
+}
+
+bool TopoRank::build(const Graph& dag, std::size_t memoryBudget, TaskControl* ctl)
+{
+    TRACE_SCOPE("TopoRank::build");
+    clear();
+    mN = dag.n;
+
+    // 按弱连通分量拆开，各自建计数表（共用内存预算）；只有一个分量时直接用原图。
+    const DagComponents comps = weakComponents(dag);
+    mPartOf = comps.id;
+    mLocal.assign(std::size_t(mN) + 1, 0);
+    mParts.resize(std::size_t(comps.count));
+    for (int v = 1; v <= mN; ++v) {
+        Part& p = mParts[std::size_t(mPartOf[v])];
+        p.nodes.push_back(v);
+        mLocal[v] = int(p.nodes.size());
+    }
+
+    mCounted = true;
+    mTotal = 1;
+    std::uint64_t placed = 0;
+    std::size_t budgetLeft = memoryBudget;
+    for (Part& p : mParts) {
+        if (comps.count == 1) {
+            p.kernel = makeKernel(dag);
+        } else {
+            Graph sub(int(p.nodes.size()));
+            for (int v : p.nodes) {
+                for (int w : dag.adj[v]) sub.addEdge(mLocal[v], mLocal[w]);
+            }
+            p.kernel = makeKernel(sub);
+        }
+        if (!p.kernel->count(budgetLeft, ctl, p.total)) {
+            mCounted = false;
+            break;
+        }
+        budgetLeft -= std::min(budgetLeft, p.kernel->bytes());
+
+        // 新分量的点与前面已有的点任意交错：再乘 C(总点数, 新分量点数)。
+        placed += p.nodes.size();
+        mTotal = mulSat(mTotal, mulSat(p.total, binomSat(placed, p.nodes.size())));
+    }
+    if (mCounted) return true;
+    mParts.clear();
+    mPartOf.clear();
+    mLocal.clear();
+    mTotal = 0;
+    if (ctl && ctl->stopped()) return false;
+
+    // 状态太多：放弃计数，退回“只列出前若干条”（条数同样受内存预算约束）。
+    const std::size_t perOrder = std::size_t(std::max(1, mN)) * sizeof(int);
+    enumeratePrefix(dag, std::max<std::size_t>(1, std::min<std::size_t>(kFallbackOrders, memoryBudget / perOrder)), ctl);
+    return false;
+}
+
+void TopoRank::enumeratePrefix(const Graph& dag, std::size_t limit, TaskControl* ctl)
+{
+    TopoEnumerator it;
+    it.reset(dag);
+    while (mPrefix.size() < limit && it.next()) {
+        mPrefix.push_back(it.order());
+        if (ctl) ctl->addFound();
+        if (ctl && !ctl->tick()) break;
+    }
+}
+
+std::vector<int> TopoRank::orderAt(std::uint64_t index) const
+{
+    if (index >= count()) return {};
+    if (!mCounted) return mPrefix[std::size_t(index)];
+    if (mParts.size() == 1) return mParts[0].kernel->orderAt(index);   // 单分量：分量内编号就是全图编号
+    return interleavedOrderAt(index);
+}
+
+std::vector<int> TopoRank::interleavedOrderAt(std::uint64_t index) const
+{
+    // 每个分量一个解码游标。每一位在所有分量的候选里按全图编号从小到大试：
+    // 选分量 c 的 u 之后的条数 = ways(c 少一个点) × c 选 u 之后的条数 × 其它分量当前的条数。
+    const std::size_t k = mParts.size();
+    std::vector<std::unique_ptr<Kernel::Walker>> walkers(k);
+    std::vector<std::uint64_t> cnt(k);
+    std::vector<int> left(k);
+    for (std::size_t i = 0; i < k; ++i) {
+        walkers[i] = mParts[i].kernel->walk();
+        cnt[i] = mParts[i].total;
+        left[i] = int(mParts[i].nodes.size());
+    }
+
+    // ways = 剩下的点在各分量之间的交错方式数。它通常远超 2^64（饱和），饱和后没法按比例缩，
+    // 另外记一份 log2：明显超出 2^64 的直接当饱和，只有接近边界时才精确重算。
+    std::vector<double> logFact(std::size_t(mN) + 1, 0.0);
+    for (int x = 2; x <= mN; ++x) logFact[std::size_t(x)] = logFact[std::size_t(x - 1)] + std::log2(double(x));
+    std::uint64_t ways = multinomialSat(left);
+    double logWays = logFact[std::size_t(mN)];
+    for (int x : left) logWays -= logFact[std::size_t(x)];
+
+    // 所有分量的当前候选，按全图编号排好；每一位只有选中的那个分量的候选会变。
+    struct Cand {
+        int node;
+        int part;
+        int local;
+        bool operator<(const Cand& o) const { return node < o.node; }
+    };
+    std::vector<Cand> cand;
+    std::vector<int> local;
+    auto refresh = [&](std::size_t i) {
+        cand.erase(std::remove_if(cand.begin(), cand.end(), [i](const Cand& c) { return c.part == int(i); }),
+                   cand.end());
+        local.clear();
+        walkers[i]->candidates(local);
+        const std::size_t old = cand.size();
+        for (int u : local) cand.push_back({mParts[i].nodes[std::size_t(u - 1)], int(i), u});
+        std::inplace_merge(cand.begin(), cand.begin() + std::ptrdiff_t(old), cand.end());
+    };
+    for (std::size_t i = 0; i < k; ++i) refresh(i);
+
+    std::vector<std::uint64_t> before(k + 1), after(k + 1);   // cnt 的前缀积 / 后缀积
+    std::vector<int> out;
+    out.reserve(std::size_t(mN));
+    for (int remaining = mN; remaining > 0; --remaining) {
+        before[0] = 1;
+        for (std::size_t i = 0; i < k; ++i) before[i + 1] = mulSat(before[i], cnt[i]);
+        after[k] = 1;
+        for (std::size_t i = k; i-- > 0;) after[i] = mulSat(after[i + 1], cnt[i]);
+
+        int picked = -1;
+        for (const Cand& c : cand) {
+            const std::size_t i = std::size_t(c.part);
+            // ways(c 少一个点) = ways × left[i] / remaining，是整数。
+            const double logW = logWays + std::log2(double(left[i])) - std::log2(double(remaining));
+            std::uint64_t w;
+            if (ways != kSaturated) {
+                const std::uint64_t g = std::gcd(ways, std::uint64_t(remaining));
+                w = (ways / g) * (std::uint64_t(left[i]) / (std::uint64_t(remaining) / g));
+            } else if (logW > 65.0) {
+                w = kSaturated;
+            } else {
+                --left[i];
+                w = multinomialSat(left);
+                ++left[i];
+            }
+            const std::uint64_t child = walkers[i]->countAfter(c.local);
+            const std::uint64_t n = mulSat(mulSat(w, child), mulSat(before[i], after[i + 1]));
+            if (index < n) {
+                picked = int(i);
+                out.push_back(c.node);
+                ways = w;
+                logWays = logW;
+                cnt[i] = child;
+                --left[i];
+                walkers[i]->choose(c.local);
+                break;
+            }
+            index -= n;
+        }
+        if (picked < 0) return {};
+        refresh(std::size_t(picked));
+    }
+    return out;
+}
+
+std::uint64_t TopoRank::countWithPrefix(const std::vector<int>& prefix) const
+{
+    if (!mCounted || (int)prefix.size() > mN) return 0;
+    if (prefix.empty()) return mTotal;
+    if (mParts.size() == 1) return mParts[0].kernel->countWithPrefix(prefix);
+
+    // 前缀按分量拆开：各分量的那一段各自合法即可（分量之间没有约束），剩下的点再任意交错。
+    std::vector<std::vector<int>> sub(mParts.size());
+    for (int u : prefix) {
+        if (u < 1 || u > mN) return 0;
+        sub[std::size_t(mPartOf[u])].push_back(mLocal[u]);
+    }
+    std::uint64_t res = 1;
+    std::vector<int> left(mParts.size());
+    for (std::size_t i = 0; i < mParts.size(); ++i) {
+        const std::uint64_t c = sub[i].empty() ? mParts[i].total : mParts[i].kernel->countWithPrefix(sub[i]);
+        if (c == 0) return 0;
+        res = mulSat(res, c);
+        left[i] = int(mParts[i].nodes.size() - sub[i].size());
+    }
+    return mulSat(res, multinomialSat(left));
+}
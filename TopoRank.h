@@ -0,0 +1,119 @@
+/* ANNOTATED_FOR_STUDY
+@file TopoRank.h
+@brief 拓扑序列的“计数 + 按下标取序列”（count / unrank），不需要把全部序列枚举出来。
+
+原来的做法是 enumerateAll() 把所有拓扑序列存进 vector，再往 QTextEdit 里写前 200 条：
+序列数随图规模指数增长（10 个互不相连的点就有 3628800 条），既存不下也显示不完。
+
+思路（按“已输出的点集合”做记忆化计数）：
+- 状态 S = 已经输出的点集合（必然是一个“下闭集”：点在 S 里，它的前驱都在 S 里）；
+- cnt(S) = 从 S 出发还能排出多少种不同的后缀 = Σ cnt(S ∪ {u})，u 取当前入度为 0 的候选点；
+- cnt(全集) = 1。
+有了 cnt，就能把第 index 条序列“解码”出来：每一位按编号从小到大试候选点，
+index 落在哪个候选的 cnt 区间里就选谁——和 enumerateAll 的回溯顺序完全一致。
+
+计数用 uint64 饱和加法：超过 2^64-1 的总数记作 kSaturated（只影响“共多少条”的显示，
+前 2^64-1 条依然可以正确解码）。
+
+状态数在最坏情况下是 2^n，这里按内存设了预算；超预算时退化为“只枚举前若干条”。
+
+DAG 分成几个互不相连的部分（弱连通分量）时，拓扑序就是各分量拓扑序的任意交错：
+总数 = 多项式系数 (n; n1, n2, ...) × Π 各分量的条数。每个分量单独建计数表（状态数是各分量之和，
+不再是乘积），解码时每一位照样按编号从小到大试候选，选分量 c 的 u 之后的条数 =
+剩余长度的多项式系数 × c 选 u 之后的条数 × 其它分量当前的条数，顺序与整图回溯完全一致。
+
+n ≤ 256 时状态位图换成定宽的 NodeBits<W>（1/2/4 个字，见 NodeBits.h）：计数表改成开放寻址、键值就地存放，
+候选就绪判断是几次按字与运算，按编号遍历候选用 ctz。每个分量按自己的点数选宽度，更大的分量走通用的 vector 位图。
+
+分量里有孪生点（前驱、后继集都相同的点，见 TwinClasses.h）时，在“类内串链”的图上计数，
+原图状态的条数 = 典范状态的条数 × Π（每类剩余个数）!：k 个孪生点的状态从 2^k 个降到 k+1 个，
+解码顺序不变。
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include "TaskControl.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class TopoRank {
+public:
+    static constexpr std::uint64_t kSaturated = UINT64_MAX;
+    static constexpr std::size_t kDefaultMemoryBudget = std::size_t(256) << 20;
+    static constexpr int kFallbackOrders = 100000;
+
+    // 预处理 dag。返回 true 表示计数成功（count() 是精确值或饱和值）；
+    // 返回 false 表示记忆化表超出 memoryBudget 字节，已退化为只枚举前 kFallbackOrders 条。
+    // ctl 非空时可被取消/限时（每个搜索状态记一次进度）；被中止时结果作废。
+    bool build(const Graph& dag, std::size_t memoryBudget = kDefaultMemoryBudget, TaskControl* ctl = nullptr);
+    void clear();
+
+    // 是否通过计数得到了总数（否则 count() 只是退化枚举到的条数）。
+    bool counted() const { return mCounted; }
+    // 可以按下标访问的序列条数。计数成功时可能为 kSaturated。
+    std::uint64_t count() const { return mCounted ? mTotal : mPrefix.size(); }
+    bool saturated() const { return mCounted && mTotal == kSaturated; }
+    bool empty() const { return count() == 0; }
+
+    // 第 index 条拓扑序列（0 起，顺序与 TopoKahn::enumerateAll 相同）；越界返回空。
+    std::vector<int> orderAt(std::uint64_t index) const;
+
+    // 以 prefix 开头的序列条数（计数成功时才有意义，否则返回 0）；prefix 不是合法前缀也返回 0。
+    // 分片时用它精确地估算每片大小。
+    std::uint64_t countWithPrefix(const std::vector<int>& prefix) const;
+
+    // 记忆化的状态数（调试/统计用），各分量之和。
+    std::size_t states() const;
+    // 计数时把 DAG 拆成了几个分量（退化模式下为 0）。
+    int components() const { return int(mParts.size()); }
+
+private:
+    // 一个分量上的计数表与解码（实现在 TopoRank.cpp）：点数 ≤ 256 的用定宽位图内核 BitsKernel<W>，
+    // 更大的用 VectorKernel。点编号是分量内的 1..size。
+    class Kernel {
+    public:
+        // 解码游标：从空状态出发，一次选一个点往下走。
+        class Walker {
+        public:
+            virtual ~Walker() = default;
+            virtual void candidates(std::vector<int>& out) const = 0;   // 当前候选，升序
+            virtual std::uint64_t countAfter(int u) const = 0;          // 选 u 之后还剩多少条
+            virtual void choose(int u) = 0;
+        };
+
+        virtual ~Kernel() = default;
+        virtual bool count(std::size_t memoryBudget, TaskControl* ctl, std::uint64_t& total) = 0;
+        virtual std::vector<int> orderAt(std::uint64_t index) const = 0;
+        virtual std::uint64_t countWithPrefix(const std::vector<int>& prefix) const = 0;
+        virtual std::size_t states() const = 0;
+        virtual std::size_t bytes() const = 0;   // 计数表占用（粗估），各分量共用内存预算
+        virtual std::unique_ptr<Walker> walk() const = 0;
+    };
+    template <int W>
+    class BitsKernel;
+    class VectorKernel;
+    class TwinKernel;                          // 孪生点压缩，套在上面两种之外（见 TwinClasses.h）
+
+    struct Part {
+        std::unique_ptr<Kernel> kernel;
+        std::vector<int> nodes;                // 分量内编号 - 1 -> 全图编号（升序，分量内的先后就是全图的先后）
+        std::uint64_t total = 0;
+    };
+
+    int mN = 0;
+    std::vector<Part> mParts;
+    std::vector<int> mPartOf;                  // [v] = 全图点 v 所在分量
+    std::vector<int> mLocal;                   // [v] = 全图点 v 在分量内的编号
+    std::uint64_t mTotal = 0;
+    bool mCounted = false;
+
+    std::vector<std::vector<int>> mPrefix;     // 退化模式：前若干条序列
+
+    static std::unique_ptr<Kernel> makeKernel(const Graph& g);        // 有孪生点时是 TwinKernel
+    static std::unique_ptr<Kernel> makePlainKernel(const Graph& g);
+    std::vector<int> interleavedOrderAt(std::uint64_t index) const;
+    void enumeratePrefix(const Graph& dag, std::size_t limit, TaskControl* ctl);
+};
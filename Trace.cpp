@@ -0,0 +1,141 @@
+/* ANNOTATED_FOR_STUDY
+@file Trace.cpp
+@brief 计时埋点的记录、汇总与 Chrome trace-event JSON 导出。
+*/
+
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace trace {
+
+namespace {
+// 线程编号：第一次记录时按出现顺序分配（1, 2, ...），导出时作 tid。
+std::uint32_t threadIndex()
+{
+    static std::atomic<std::uint32_t> next{1};
+    thread_local const std::uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void writeJsonString(std::ostream& out, const char* s)
+{
+    out << '"';
+    for (; *s; ++s) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') out << '\\' << char(c);
+        else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out << buf;
+        } else out << char(c);
+    }
+    out << '"';
+}
+
+void writeMicros(std::ostream& out, std::int64_t ns)
+{
+    // 微秒，保留到纳秒（3 位小数），避免浮点格式化受 locale 影响。
+    const std::int64_t us = ns / 1000;
+    const std::int64_t frac = ns % 1000;
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%lld.%03lld", (long long)us, (long long)(frac < 0 ? -frac : frac));
+    out << buf;
+}
+} // namespace
+
+Recorder& Recorder::instance()
+{
+    static Recorder r;
+    return r;
+}
+
+std::int64_t Recorder::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Recorder::record(const char* name, std::int64_t startNs, std::int64_t durNs)
+{
+    const std::uint32_t tid = threadIndex();
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = std::find_if(mAcc.begin(), mAcc.end(), [name](const Acc& a) { return a.name == name; });
+    if (it == mAcc.end()) {
+        mAcc.push_back({name, 0, 0, 0});
+        it = mAcc.end() - 1;
+    }
+    it->count++;
+    it->totalNs += durNs;
+    it->maxNs = std::max(it->maxNs, durNs);
+
+    if (mEvents.size() < kMaxEvents) mEvents.push_back({name, tid, startNs, durNs});
+    else ++mDropped;
+}
+
+void Recorder::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.clear();
+    mEvents.shrink_to_fit();
+    mAcc.clear();
+    mDropped = 0;
+}
+
+std::vector<Stat> Recorder::stats() const
+{
+    std::vector<Stat> out;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        out.reserve(mAcc.size());
+        for (const Acc& a : mAcc) out.push_back({a.name, a.count, a.totalNs / 1e6, a.maxNs / 1e6});
+    }
+    std::sort(out.begin(), out.end(), [](const Stat& a, const Stat& b) { return a.totalMs > b.totalMs; });
+    return out;
+}
+
+std::size_t Recorder::eventCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEvents.size();
+}
+
+std::uint64_t Recorder::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDropped;
+}
+
+bool Recorder::writeChromeJson(std::ostream& out) const
+{
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        events = mEvents;
+    }
+    // 时间从第一条事件开始算，查看器里不会出现一大段空白。
+    std::int64_t origin = 0;
+    if (!events.empty()) {
+        origin = std::min_element(events.begin(), events.end(), [](const Event& a, const Event& b) {
+                     return a.startNs < b.startNs;
+                 })->startNs;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"TopoSortVisualizer\"}}";
+    for (const Event& e : events) {
+        out << ",\n{\"name\":";
+        writeJsonString(out, e.name);
+        out << ",\"cat\":\"topo\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid << ",\"ts\":";
+        writeMicros(out, e.startNs - origin);
+        out << ",\"dur\":";
+        writeMicros(out, e.durNs);
+        out << '}';
+    }
+    out << "\n]}\n";
+    return bool(out);
+}
+
+} // namespace trace
@@ -0,0 +1,107 @@
+/* ANNOTATED_FOR_STUDY
+@file Trace.h
+@brief 热点阶段的计时埋点：TRACE_SCOPE("名字") 记下这一段的耗时，汇总成统计表，也能导出 Chrome trace-event JSON。
+
+为什么要它？
+- 大图上“慢”可能慢在 Tarjan、缩点去重、枚举、重建场景、力导 tick、整体重绘……光凭感觉分不清；
+- 在这些阶段的入口放一个 TRACE_SCOPE，打开记录后跑一遍，统计面板里就能看到每段的次数/总计/最大，
+  导出的 JSON 拖进 chrome://tracing 或 Perfetto 还能看到时间线（哪个线程、先后顺序、有没有重叠）。
+
+开销：
+- 关闭时（默认）：构造函数里读一次原子布尔量就返回，析构什么都不做；
+- 打开时：两次读时钟 + 析构时加锁追加一条记录；只埋在“阶段”级别的入口上，不埋在内层循环里；
+- 编译时定义 TOPO_NO_TRACE 则 TRACE_SCOPE 展开为空。
+
+事件最多保留 kMaxEvents 条（超出只计数、不再保存，统计表照常累加）；名字必须是字符串字面量
+（按指针保存，不拷贝）。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+struct Stat {
+    std::string name;
+    std::uint64_t count = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+};
+
+class Recorder {
+public:
+    static constexpr std::size_t kMaxEvents = std::size_t(1) << 20;
+
+    static Recorder& instance();
+    static std::int64_t nowNs();
+
+    void setEnabled(bool on) { mEnabled.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    void record(const char* name, std::int64_t startNs, std::int64_t durNs);
+    void clear();
+
+    // 按总耗时从大到小排好。
+    std::vector<Stat> stats() const;
+    std::size_t eventCount() const;
+    std::uint64_t dropped() const;
+
+    // Chrome trace-event 格式（"X" 完整事件，时间单位微秒）。
+    bool writeChromeJson(std::ostream& out) const;
+
+private:
+    struct Event {
+        const char* name;
+        std::uint32_t tid;
+        std::int64_t startNs;
+        std::int64_t durNs;
+    };
+    struct Acc {
+        const char* name;
+        std::uint64_t count;
+        std::int64_t totalNs;
+        std::int64_t maxNs;
+    };
+
+    std::atomic<bool> mEnabled{false};
+    mutable std::mutex mMutex;
+    std::vector<Event> mEvents;
+    std::vector<Acc> mAcc;         // 阶段数很少，线性查找即可
+    std::uint64_t mDropped = 0;
+};
+
+class Scope {
+public:
+    explicit Scope(const char* name)
+        : mName(Recorder::instance().enabled() ? name : nullptr)
+    {
+        if (mName) mStart = Recorder::nowNs();
+    }
+    ~Scope()
+    {
+        if (mName) Recorder::instance().record(mName, mStart, Recorder::nowNs() - mStart);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* mName;
+    std::int64_t mStart = 0;
+};
+
+} // namespace trace
+
+#define TRACE_CAT_IMPL(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT_IMPL(a, b)
+#ifdef TOPO_NO_TRACE
+#define TRACE_SCOPE(name) ((void)0)
+#else
+#define TRACE_SCOPE(name) ::trace::Scope TRACE_CAT(traceScope_, __LINE__)(name)
+#endif
@@ -0,0 +1,111 @@
+/* ANNOTATED_FOR_STUDY
+@file TraceCapture.cpp
+@brief 无界面录制：读图 -> 跑算法（steps 直接交给 StepTraceWriter 落盘）-> 退出。
+*/
+
+#include "TraceCapture.h"
+#include "Condense.h"
+#include "ShardWorker.h"
+#include "StepTrace.h"
+#include "TarjanSCC.h"
+#include "TopoKahn.h"
+#include "TopoRank.h"
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+namespace {
+// 与界面后台任务用同样大小的栈（见 MainWindow::kTaskStackSize）。
+constexpr uint kCaptureStackSize = 64u << 20;
+} // namespace
+
+int runTraceCapture(int argc, char* argv[])
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (argc != 5 && argc != 6) {
+        err << "usage: " << argv[0] << " --capture-trace <graph file> <scc|topo> <output> [order index]\n";
+        return 2;
+    }
+
+    Graph g;
+    if (!readDagFile(QString::fromLocal8Bit(argv[2]), g)) {
+        err << "cannot read graph file " << argv[2] << '\n';
+        return 2;
+    }
+    const QString mode = QString::fromLatin1(argv[3]);
+    if (mode != "scc" && mode != "topo") {
+        err << "unknown mode " << argv[3] << " (expected scc or topo)\n";
+        return 2;
+    }
+    bool hasIndex = false;
+    quint64 orderIndex = 0;
+    if (argc == 6) {
+        orderIndex = QString::fromLatin1(argv[5]).toULongLong(&hasIndex);
+        if (!hasIndex || mode != "topo") {
+            err << "order index is only valid for topo mode\n";
+            return 2;
+        }
+    }
+
+    QFile file(QString::fromLocal8Bit(argv[4]));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "cannot open " << argv[4] << ": " << file.errorString() << '\n';
+        return 1;
+    }
+    StepTraceWriter writer([&file](const char* data, std::size_t len) {
+        return file.write(data, qint64(len)) == qint64(len);
+    });
+
+    QString error;
+    QThread* worker = QThread::create([&]() {
+        StepTraceHeader header;
+        if (mode == "scc") {
+            header.algorithm = TraceAlgorithm::TarjanScc;
+            header.n = g.n;
+            header.fingerprint = graphFingerprint(g);
+            writer.begin(header);
+            TarjanSCC().run(g, nullptr, &writer);
+            return;
+        }
+
+        // 只要 SCC 映射、不要 steps，steps 不会攒在内存里。
+        DiscardStepSink discard;
+        const SCCResult scc = TarjanSCC().run(g, nullptr, &discard);
+        const Graph dag = Condense().run(g, scc.sccId, scc.sccCnt).dag;
+        header.n = dag.n;
+        header.fingerprint = graphFingerprint(dag);
+
+        if (!hasIndex) {
+            header.algorithm = TraceAlgorithm::Kahn;
+            writer.begin(header);
+            TopoKahn().run(dag, &writer);
+            return;
+        }
+        TopoRank rank;
+        rank.build(dag);
+        if (orderIndex >= rank.count()) {
+            error = QString("order index %1 out of range (%2 orders)").arg(orderIndex).arg(rank.count());
+            return;
+        }
+        header.algorithm = TraceAlgorithm::KahnOrder;
+        header.orderIndex = orderIndex;
+        writer.begin(header);
+        TopoKahn().runWithOrder(dag, rank.orderAt(orderIndex), &writer);
+    });
+    worker->setStackSize(kCaptureStackSize);
+    worker->start();
+    worker->wait();
+    delete worker;
+
+    if (!error.isEmpty()) {
+        err << error << '\n';
+        return 2;
+    }
+    if (!writer.flush() || !file.flush()) {
+        err << "write failed: " << file.errorString() << '\n';
+        return 1;
+    }
+    out << "done " << writer.written() << '\n';
+    return 0;
+}
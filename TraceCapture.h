@@ -0,0 +1,17 @@
+/* ANNOTATED_FOR_STUDY
+@file TraceCapture.h
+@brief 无界面录制 Step trace：main() 看到 --capture-trace 时转到这里，跑完算法、把 steps 流式写成 StepTrace 文件后退出。
+
+用法：
+    <本程序> --capture-trace <图文件> <scc|topo> <输出文件> [序列下标]
+- 图文件与分片导出的 DAG 临时文件同一格式（见 ShardWorker.h 的 readDagFile）：第一行 “n m”，之后 m 行 “u v”；
+- scc  ：在原图上录 Tarjan；
+- topo ：先 Tarjan + 缩点（与界面里的 DAG 完全一致），再在 DAG 上录 Kahn；
+         给了序列下标时录“按第 k 条拓扑序列演示”的版本（界面播放拓扑序列时用的就是它）。
+结束时往 stdout 打 “done <步数>”。录好的文件在界面里用“打开步骤文件…”回放。
+*/
+
+#pragma once
+
+// 返回值就是进程退出码。
+int runTraceCapture(int argc, char* argv[]);
@@ -0,0 +1,57 @@
+/* ANNOTATED_FOR_STUDY
+@file TwinClasses.cpp
+@brief 孪生点识别：按（前驱集, 后继集）分组；典范 DAG：类内串链。
+*/
+
+#include "TwinClasses.h"
+#include "Trace.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+TwinClasses findTwins(const Graph& dag)
+{
+    TRACE_SCOPE("findTwins");
+    const int n = dag.n;
+    std::vector<std::vector<int>> pred(n + 1), succ(n + 1);
+    for (int u = 1; u <= n; ++u) {
+        for (int v : dag.adj[u]) {
+            pred[v].push_back(u);
+            succ[u].push_back(v);
+        }
+    }
+    // 重边不影响“集合”是否相同。
+    auto normalize = [](std::vector<int>& a) {
+        std::sort(a.begin(), a.end());
+        a.erase(std::unique(a.begin(), a.end()), a.end());
+    };
+
+    TwinClasses res;
+    res.classOf.assign(n + 1, -1);
+    std::map<std::pair<std::vector<int>, std::vector<int>>, int> seen;
+    for (int v = 1; v <= n; ++v) {
+        normalize(pred[v]);
+        normalize(succ[v]);
+        auto key = std::make_pair(std::move(pred[v]), std::move(succ[v]));
+        auto it = seen.find(key);
+        if (it == seen.end()) {
+            it = seen.emplace(std::move(key), int(res.members.size())).first;
+            res.members.emplace_back();
+        }
+        res.classOf[v] = it->second;
+        res.members[it->second].push_back(v);
+    }
+    for (const auto& m : res.members) {
+        if (m.size() > 1) res.twins += int(m.size());
+    }
+    return res;
+}
+
+Graph twinCanonicalDag(const Graph& dag, const TwinClasses& twins)
+{
+    Graph g = dag;
+    for (const auto& m : twins.members) {
+        for (std::size_t i = 1; i < m.size(); ++i) g.addEdge(m[i - 1], m[i]);
+    }
+    return g;
+}
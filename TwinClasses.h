@@ -0,0 +1,33 @@
+/* ANNOTATED_FOR_STUDY
+@file TwinClasses.h
+@brief 孪生点（前驱集、后继集都完全相同的点）的识别，以及“只保留典范序列”的 DAG 变换。
+
+一组孪生点（比如同一个任务扇出的几个子任务）彼此之间没有边、约束完全一样，
+在任何拓扑序里两两交换位置还是合法的拓扑序：k 个孪生点让序列数乘上 k!。
+
+两种用法：
+- 计数 / 解码（TopoRank）：状态只需记“每类用掉了几个”，不必记用掉的是哪几个。
+  做法是在每类内部按编号串一条链（twinCanonicalDag），在新图上计数；
+  原图上某个状态的条数 = 新图上对应典范状态的条数 × Π（每类剩余个数）!，按需展开，不枚举排列；
+- “按孪生对称去重”：新图的拓扑序恰好是原图中“每类孪生点按编号先后出现”的那些序列，
+  每个对称等价类正好一条（典范序列）。直接在新图上计数 / 枚举 / 导出即可。
+
+纯逻辑模块，不含 Qt 类型。
+*/
+
+#pragma once
+#include "Graph.h"
+#include <vector>
+
+struct TwinClasses {
+    std::vector<int> classOf;               // [v] = v 所在的类，0..members.size()-1
+    std::vector<std::vector<int>> members;  // 每类的点（升序）；类按最小点编号排
+    int twins = 0;                          // 落在大小 ≥ 2 的类里的点数
+
+    bool any() const { return twins > 0; }
+};
+
+TwinClasses findTwins(const Graph& dag);
+
+// 每类孪生点按编号串成链 a1->a2->...（点编号不变）。
+Graph twinCanonicalDag(const Graph& dag, const TwinClasses& twins);
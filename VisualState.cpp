@@ -0,0 +1,128 @@
+/* ANNOTATED_FOR_STUDY
+@file VisualState.cpp
+@brief VisualOp -> 可视化状态表 的执行逻辑（Step 的解释在 StepProgram 编译时已经做完）。
+
+只改数组，不碰任何 QGraphicsItem；是否重绘、重绘哪些由 GraphView 根据 StepEffect 决定。
+*/
+
+#include "VisualState.h"
+#include <algorithm>
+
+void VisualState::reset(int nodeCount)
+{
+    n = nodeCount;
+    sccId.assign(n + 1, 0);
+    flags.assign(n + 1, 0);
+    indeg.assign(n + 1, 0);
+    order.assign(n + 1, 0);
+    topoOrderIndex = 0;
+    activeNodes[0] = activeNodes[1] = -1;
+    activeEdge = -1;
+}
+
+void VisualState::resetVisual(bool clearScc)
+{
+    std::fill(flags.begin(), flags.end(), 0);
+    std::fill(indeg.begin(), indeg.end(), 0);
+    std::fill(order.begin(), order.end(), 0);
+    if (clearScc) std::fill(sccId.begin(), sccId.end(), 0);
+    topoOrderIndex = 0;
+    activeNodes[0] = activeNodes[1] = -1;
+    activeEdge = -1;
+}
+
+void VisualState::apply(const VisualOp& op, StepEffect* effect, StepUndo* undo)
+{
+    StepEffect fx;
+
+    // 1) 撤销上一步的瞬时高亮（记入副作用，让这些 item 重绘一次）。
+    fx.nodes[0] = activeNodes[0];
+    fx.nodes[1] = activeNodes[1];
+    fx.edges[0] = activeEdge;
+
+    // 2) Reset 是阶段切换，整体重置。
+    if (op.code == VisualOp::Reset) {
+        resetVisual(op.value != 0);
+        fx.full = true;
+        if (effect) *effect = fx;
+        return;
+    }
+
+    // 3) 持久改动：编译时已经确定改哪个点、哪一列。
+    StepUndo rec;
+    const int u = op.node;
+    if (u >= 0) {
+        rec.oldFlags = flags[u];
+        flags[u] = std::uint8_t((flags[u] & ~op.clearMask) | op.setMask);
+        switch (op.code) {
+        case VisualOp::SetScc:
+            rec.oldValue = sccId[u];
+            sccId[u] = op.value;
+            break;
+        case VisualOp::SetIndeg:
+            rec.oldValue = indeg[u];
+            indeg[u] = op.value;
+            break;
+        case VisualOp::Dequeue:
+            rec.oldValue = order[u];
+            // 给节点分配输出序号（从 1 开始）。
+            order[u] = ++topoOrderIndex;
+            fx.doneNode = u;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 4) 本步的瞬时高亮。
+    activeNodes[0] = op.hi0;
+    activeNodes[1] = op.hi1;
+    activeEdge = op.edge;
+
+    fx.nodes[2] = activeNodes[0];
+    fx.nodes[3] = activeNodes[1];
+    fx.edges[1] = activeEdge;
+    if (effect) *effect = fx;
+    if (undo) *undo = rec;
+}
+
+bool VisualState::revert(const VisualOp& op, const StepUndo& undo, const VisualOp* prev, StepEffect* effect)
+{
+    if (op.code == VisualOp::Reset) return false;
+
+    StepEffect fx;
+    fx.nodes[0] = activeNodes[0];
+    fx.nodes[1] = activeNodes[1];
+    fx.edges[0] = activeEdge;
+
+    const int u = op.node;
+    if (u >= 0) {
+        flags[u] = undo.oldFlags;
+        switch (op.code) {
+        case VisualOp::SetScc:
+            sccId[u] = undo.oldValue;
+            break;
+        case VisualOp::SetIndeg:
+            indeg[u] = undo.oldValue;
+            break;
+        case VisualOp::Dequeue:
+            order[u] = undo.oldValue;
+            --topoOrderIndex;
+            fx.doneNode = u; // done 撤销后，出边也要恢复颜色
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 瞬时高亮回到“上一步刚执行完”的样子（Reset 编译出的高亮本来就是空的）。
+    activeNodes[0] = prev ? prev->hi0 : -1;
+    activeNodes[1] = prev ? prev->hi1 : -1;
+    activeEdge = prev ? prev->edge : -1;
+
+    fx.nodes[2] = activeNodes[0];
+    fx.nodes[3] = activeNodes[1];
+    fx.edges[1] = activeEdge;
+    if (effect) *effect = fx;
+    return true;
+}
@@ -0,0 +1,100 @@
+/* ANNOTATED_FOR_STUDY
+@file VisualState.h
+@brief 回放时的可视化状态表（struct-of-arrays），由 GraphView 持有，NodeItem/EdgeItem 在 paint() 时直接读取。
+
+为什么不用 QGraphicsItem::setData()？
+- 每次 setData/data 都要装箱/拆箱 QVariant，回放热路径上每个点每次重绘要读 5 个。
+- 状态散落在 item 上，无法整体拷贝/比较（后续做时间轴关键帧时需要整体快照）。
+
+这里改成几列紧凑数组（下标 = 节点编号 1..n），和 Graph 一样不含 Qt 容器：
+- sccId   : 所属 SCC，0 表示未分配
+- flags   : 位掩码（InStack / Queued / Done / IndegShown）
+- indeg   : 当前显示的入度
+- order   : 拓扑输出序号（1..k），0 表示还没输出
+- 瞬时高亮只记“当前 step 高亮了谁”（最多 2 点 + 1 边），不按 item 存标记。
+
+状态表不直接解释 Step：Step 先由 StepProgram 编译成 VisualOp（点已校验、边已解析、
+要改哪一列/哪些位都写好了），apply/revert 只是照着 op 改数组。
+*/
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// apply() 的副作用清单：哪些点/边的外观可能变了，GraphView 据此做增量重绘。
+struct StepEffect {
+    int nodes[4] = {-1, -1, -1, -1}; // 上一步高亮的 2 点 + 本步涉及的 2 点
+    int edges[2] = {-1, -1};         // 上一步高亮边 + 本步高亮边
+    int doneNode = -1;               // 本步变为 done 的点（其出边需要重绘）
+    bool full = false;               // ResetVisual：需要整体重绘
+};
+
+// 编译好的一步：对某一个点的一次持久改动 + 本步的瞬时高亮。
+// 一个 Step 至多改一个点（TopoIndegDec 改的是 v），所以 node 一个就够。
+struct VisualOp {
+    enum Code : std::uint8_t {
+        Reset,      // 阶段切换；value != 0 时连 SCC 着色一起清
+        Flags,      // 只改标志位（node < 0 时只有高亮）
+        SetScc,     // sccId[node] = value
+        SetIndeg,   // indeg[node] = value
+        Dequeue,    // order[node] = ++topoOrderIndex，出边需要重绘
+    };
+    std::uint8_t code = Flags;
+    std::uint8_t setMask = 0;     // flags[node] = (flags[node] & ~clearMask) | setMask
+    std::uint8_t clearMask = 0;
+    int node = -1;                // 已校验过的点编号，-1 表示没有持久改动
+    int value = 0;
+    int hi0 = -1, hi1 = -1;       // 本步高亮的点
+    int edge = -1;                // 本步高亮的边（已解析的 edgeId）
+};
+
+// apply() 覆盖掉的旧值，revert() 靠它把一步“倒回去”。oldValue 的含义随 op.code 而定：
+// SetScc -> 旧 sccId；SetIndeg -> 旧入度；Dequeue -> 旧输出序号。
+struct StepUndo {
+    int oldValue = 0;
+    std::uint8_t oldFlags = 0;
+};
+
+struct VisualState {
+    enum NodeFlag : std::uint8_t {
+        InStack    = 1u << 0,  // Tarjan 栈成员
+        Queued     = 1u << 1,  // Kahn 候选（入度为 0，尚未输出）
+        Done       = 1u << 2,  // 已输出
+        IndegShown = 1u << 3,  // 已初始化过入度（显示入度文字）
+    };
+
+    int n = 0;
+    std::vector<int> sccId;           // [1..n]
+    std::vector<std::uint8_t> flags;  // [1..n]
+    std::vector<int> indeg;           // [1..n]
+    std::vector<int> order;           // [1..n]
+    int topoOrderIndex = 0;           // 已输出的点数
+
+    // 当前 step 的瞬时高亮。
+    int activeNodes[2] = {-1, -1};
+    int activeEdge = -1;
+
+    // 按图规模重置为“全白”状态。
+    void reset(int nodeCount);
+
+    // 对应 StepType::ResetVisual：清理拓扑/栈状态，clearScc 时连 SCC 着色一起清掉。
+    void resetVisual(bool clearScc);
+
+    // 把一条编译好的 op 落到状态表上。undo 非空时记下被覆盖的旧值。
+    void apply(const VisualOp& op, StepEffect* effect = nullptr, StepUndo* undo = nullptr);
+
+    // apply 的逆操作：把 op 的持久改动按 undo 还原，瞬时高亮恢复成 prev（上一步）的样子。
+    // Reset 不可逆（丢掉的信息太多），返回 false，由调用方改用关键帧。
+    bool revert(const VisualOp& op, const StepUndo& undo, const VisualOp* prev, StepEffect* effect = nullptr);
+
+    bool operator==(const VisualState& o) const {
+        return n == o.n && sccId == o.sccId && flags == o.flags && indeg == o.indeg
+            && order == o.order && topoOrderIndex == o.topoOrderIndex
+            && activeNodes[0] == o.activeNodes[0] && activeNodes[1] == o.activeNodes[1]
+            && activeEdge == o.activeEdge;
+    }
+
+    bool has(int id, NodeFlag f) const { return (flags[id] & f) != 0; }
+    bool isActive(int id) const { return id == activeNodes[0] || id == activeNodes[1]; }
+    bool valid(int id) const { return id >= 1 && id <= n; }
+};
@@ -1,11 +1,18 @@
 
 
 #include "mainwindow.h"
+#include "ShardWorker.h"
+#include "TraceCapture.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // 分片导出的子进程：不建窗口，跑完自己那一片就退出。
+    if (argc > 1 && qstrcmp(argv[1], "--shard-worker") == 0) return runShardWorker(argc, argv);
+    // 无界面录制 Step trace，录好的文件在界面里打开回放。
+    if (argc > 1 && qstrcmp(argv[1], "--capture-trace") == 0) return runTraceCapture(argc, argv);
+
     QApplication a(argc, argv);
     // 设置窗口显示名：a.setApplicationDisplayName("TopoSortVisualizer-拓扑排序可视化");
     // QCoreApplication::setApplicationName("TopoSortVisualizer-拓扑排序可视化");
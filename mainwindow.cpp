@@ -12,6 +12,8 @@ QT一般规范：
 #include "ui_mainwindow.h"
 #include "TarjanSCC.h"
 #include "Condense.h"
+#include "ShardWorker.h"
+#include "Trace.h"
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QMenuBar>
@@ -27,6 +29,21 @@ QT一般规范：
 #include <QCheckBox>
 #include <QFile>
 #include <QApplication>
+#include <QSignalBlocker>
+#include <QLineEdit>
+#include <QScrollBar>
+#include <QRegularExpressionValidator>
+#include <QThread>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QInputDialog>
+#include <QHeaderView>
+#include <sstream>
+#include <memory>
+#include <limits>
 
 static QVector<QPointF> makeCirclePos(int n, double radius = 250.0)
 {
@@ -38,7 +55,66 @@ static QVector<QPointF> makeCirclePos(int n, double radius = 250.0)
     return pos;
 }
 
+// 内存映射打开的 step trace。时间轴边播边读、日志模型按下标回来取步骤，所以由 shared_ptr 共享，
+// 随最后一个引用（时间轴的 source / 日志模型的取数函数）一起释放；映射期间 QFile 必须保持打开。
+struct MappedStepTrace {
+    QFile file;
+    uchar* map = nullptr;
+    StepTraceReader reader;
+
+    ~MappedStepTrace() { if (map) file.unmap(map); }
+
+    bool open(const QString& path, QString& error)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = file.errorString();
+            return false;
+        }
+        const qint64 size = file.size();
+        map = (size > 0) ? file.map(0, size) : nullptr;
+        if (!map) {
+            error = QObject::tr("文件为空或无法映射到内存。");
+            return false;
+        }
+        if (!reader.open(map, std::size_t(size))) {
+            error = QObject::tr("不是步骤文件（文件头不对）。");
+            return false;
+        }
+        return true;
+    }
+};
+
+namespace {
+// 按顺序读映射文件里的记录交给时间轴：播到哪里才解码到哪里，打开时不把整份文件先编译一遍。
+class MappedTraceSource : public StepSource {
+public:
+    explicit MappedTraceSource(std::shared_ptr<MappedStepTrace> trace) : mTrace(std::move(trace)) {}
+
+    bool next(Step& out) override
+    {
+        if (mNext >= mTrace->reader.count()) return false;
+        out = mTrace->reader.stepAt(mNext++);
+        return true;
+    }
+    std::size_t sizeHint() const override { return std::size_t(mTrace->reader.count() - mNext); }
+
+private:
+    std::shared_ptr<MappedStepTrace> mTrace;
+    std::uint64_t mNext = 0;
+};
+} // namespace
 
+// 批量加边一次加了这么多条以上，就自动跑一次多级布局。
+static constexpr int kAutoMultilevelEdges = 50;
+
+// DAG 上每个 SCC 点用自己的编号作颜色分组，颜色与原图里该 SCC 的颜色一致。
+static QVector<int> sccPaletteIds(int sccCnt)
+{
+    QVector<int> ids(sccCnt + 1, 0);
+    for (int cid = 1; cid <= sccCnt; ++cid) ids[cid] = cid;
+    return ids;
+}
 
 void MainWindow::setupPanelsMenu()
 {
@@ -47,13 +123,171 @@ void MainWindow::setupPanelsMenu()
     QMenu* panelsMenu = menuBar()->addMenu(tr("Panels"));
     mGraphDockAction = mGraphDock->toggleViewAction();
     mAlgoDockAction  = mAlgoDock->toggleViewAction();
+    mPerfDockAction  = mPerfDock->toggleViewAction();
 
     // 易用性快捷设置。
     mGraphDockAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_1));
     mAlgoDockAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_2));
+    mPerfDockAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_3));
 
     panelsMenu->addAction(mGraphDockAction);
     panelsMenu->addAction(mAlgoDockAction);
+    panelsMenu->addAction(mPerfDockAction);
+}
+
+void MainWindow::setupPerfDock()
+{
+    // ----------------------
+    // Dock 3：性能 / Trace（默认隐藏，Panels 菜单或 Ctrl+3 打开）
+    // ----------------------
+    mPerfDock = new QDockWidget(tr("性能"), this);
+    mPerfDock->setObjectName("PerfDock");
+    mPerfDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea | Qt::BottomDockWidgetArea);
+
+    auto* perfPanel = new QWidget(mPerfDock);
+    auto* pLay = new QVBoxLayout(perfPanel);
+    pLay->setContentsMargins(12, 12, 12, 12);
+    pLay->setSpacing(8);
+
+    perfEnableBox = new QCheckBox(tr("记录各阶段耗时（关闭时几乎没有开销）"), perfPanel);
+    pLay->addWidget(perfEnableBox);
+
+    perfTable = new QTableWidget(0, 5, perfPanel);
+    perfTable->setHorizontalHeaderLabels({tr("阶段"), tr("次数"), tr("总计 ms"), tr("平均 ms"), tr("最大 ms")});
+    perfTable->verticalHeader()->setVisible(false);
+    perfTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    perfTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    perfTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    perfTable->setMinimumHeight(160);
+    pLay->addWidget(perfTable, 1);
+
+    perfInfoLabel = new QLabel(perfPanel);
+    perfInfoLabel->setObjectName("SubtleLabel");
+    pLay->addWidget(perfInfoLabel);
+
+    auto* btnRow = new QHBoxLayout();
+    btnRow->setSpacing(8);
+    auto* clearBtn = new QPushButton(tr("清空"), perfPanel);
+    auto* exportBtn = new QPushButton(tr("导出 Chrome trace…"), perfPanel);
+    btnRow->addWidget(clearBtn);
+    btnRow->addWidget(exportBtn, 1);
+    pLay->addLayout(btnRow);
+
+    // 画布帧时间：浮层直接画在 GraphView 左上角，直方图可导出 CSV。
+    overlayBox = new QCheckBox(tr("画布帧时间浮层"), perfPanel);
+    pLay->addWidget(overlayBox);
+    auto* frameRow = new QHBoxLayout();
+    frameRow->setSpacing(8);
+    auto* frameClearBtn = new QPushButton(tr("清空帧统计"), perfPanel);
+    auto* frameCsvBtn = new QPushButton(tr("导出帧时间直方图 CSV…"), perfPanel);
+    frameRow->addWidget(frameClearBtn);
+    frameRow->addWidget(frameCsvBtn, 1);
+    pLay->addLayout(frameRow);
+
+    mPerfDock->setWidget(perfPanel);
+    addDockWidget(Qt::RightDockWidgetArea, mPerfDock);
+    mPerfDock->hide();
+
+    mPerfTimer.setInterval(500);
+    connect(&mPerfTimer, &QTimer::timeout, this, &MainWindow::refreshPerfStats);
+    connect(perfEnableBox, &QCheckBox::toggled, this, [this](bool on) {
+        trace::Recorder::instance().setEnabled(on);
+        if (on) mPerfTimer.start();
+        else mPerfTimer.stop();
+        refreshPerfStats();
+    });
+    connect(clearBtn, &QPushButton::clicked, this, [this]() {
+        trace::Recorder::instance().clear();
+        refreshPerfStats();
+    });
+    connect(exportBtn, &QPushButton::clicked, this, &MainWindow::onExportTrace);
+    connect(overlayBox, &QCheckBox::toggled, view, &GraphView::setOverlayEnabled);
+    connect(frameClearBtn, &QPushButton::clicked, view, &GraphView::clearFrameStats);
+    connect(frameCsvBtn, &QPushButton::clicked, this, &MainWindow::onExportFrameCsv);
+    connect(mPerfDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) refreshPerfStats();
+    });
+}
+
+void MainWindow::refreshPerfStats()
+{
+    // 面板被收起时不刷新；重新打开时由 visibilityChanged 补一次。
+    if (!perfTable || !mPerfDock->isVisible()) return;
+
+    const trace::Recorder& rec = trace::Recorder::instance();
+    const std::vector<trace::Stat> stats = rec.stats();
+    perfTable->setRowCount(int(stats.size()));
+    for (int r = 0; r < (int)stats.size(); ++r) {
+        const trace::Stat& st = stats[std::size_t(r)];
+        const QString cells[5] = {
+            QString::fromStdString(st.name),
+            QString::number(st.count),
+            QString::number(st.totalMs, 'f', 2),
+            QString::number(st.count ? st.totalMs / double(st.count) : 0.0, 'f', 3),
+            QString::number(st.maxMs, 'f', 2),
+        };
+        for (int c = 0; c < 5; ++c) {
+            QTableWidgetItem* item = perfTable->item(r, c);
+            if (!item) {
+                item = new QTableWidgetItem;
+                if (c > 0) item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                perfTable->setItem(r, c, item);
+            }
+            item->setText(cells[c]);
+        }
+    }
+
+    QString info = tr("已记录 %1 条事件").arg(rec.eventCount());
+    if (rec.dropped() > 0) info += tr("（另有 %1 条超出上限未保存，统计照常累加）").arg(rec.dropped());
+    if (!rec.enabled()) info += tr("；记录已关闭");
+    perfInfoLabel->setText(info);
+}
+
+void MainWindow::onExportTrace()
+{
+    const trace::Recorder& rec = trace::Recorder::instance();
+    if (rec.eventCount() == 0) {
+        statusBar()->showMessage(tr("还没有记录到事件：先勾选“记录各阶段耗时”再操作一遍"), 3000);
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, tr("导出 Chrome trace"), QString("trace.json"),
+                                                      tr("Trace JSON (*.json)"));
+    if (path.isEmpty()) return;
+
+    std::ostringstream json;
+    rec.writeChromeJson(json);
+    const std::string data = json.str();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data.data(), qint64(data.size())) != qint64(data.size())
+        || !file.commit()) {
+        QMessageBox::warning(this, tr("导出失败"), file.errorString());
+        return;
+    }
+    statusBar()->showMessage(tr("已导出 %1 条事件到 %2（可在 chrome://tracing 或 Perfetto 中打开）")
+                                 .arg(rec.eventCount()).arg(path), 4000);
+}
+
+void MainWindow::onExportFrameCsv()
+{
+    const FrameStats& fs = view->frameStats();
+    if (fs.size() == 0) {
+        statusBar()->showMessage(tr("还没有帧统计：先勾选“画布帧时间浮层”再操作一遍"), 3000);
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, tr("导出帧时间直方图"), QString("frame_times.csv"),
+                                                      tr("CSV (*.csv)"));
+    if (path.isEmpty()) return;
+
+    std::ostringstream csv;
+    fs.writeCsv(csv);
+    const std::string data = csv.str();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data.data(), qint64(data.size())) != qint64(data.size())
+        || !file.commit()) {
+        QMessageBox::warning(this, tr("导出失败"), file.errorString());
+        return;
+    }
+    statusBar()->showMessage(tr("已导出最近 %1 帧的直方图到 %2").arg(fs.size()).arg(path), 4000);
 }
 
 void MainWindow::updateEdgeCountUI()
@@ -163,6 +397,10 @@ void MainWindow::setupDocks()
     auto* btnAddBatch = new QPushButton(tr("从文本中加边"), gbBatch);
     batchLay->addWidget(btnAddBatch);
 
+    auto* btnMultilevel = new QPushButton(tr("多级布局整理"), gbBatch);
+    btnMultilevel->setToolTip(tr("先按 SCC 缩点、再两两合并把图缩小，排好粗图后逐层展开（大图比力导收敛快得多）"));
+    batchLay->addWidget(btnMultilevel);
+
     gLay->addWidget(gbBatch);
 
     // Tips
@@ -170,7 +408,8 @@ void MainWindow::setupDocks()
 - 拖动节点可手动调整布局
 - 双击节点可固定/解除固定
 - 按住 Shift 依次点击两个节点也可加边
-- 图很乱时，等一会儿力导布局会自动舒展)"), graphPanel);
+- 图很乱时，等一会儿力导布局会自动舒展
+- 一次加了很多边时会自动做一次多级布局)"), graphPanel);
     tips->setObjectName("HintText");
     tips->setWordWrap(true);
     gLay->addWidget(tips);
@@ -184,6 +423,7 @@ gLay->addStretch(1);
     connect(btnCreate, &QPushButton::clicked, this, &MainWindow::onCreateGraph);
     connect(btnAddEdge, &QPushButton::clicked, this, &MainWindow::onAddEdge);
     connect(btnAddBatch, &QPushButton::clicked, this, &MainWindow::onAddEdgesFromText);
+    connect(btnMultilevel, &QPushButton::clicked, this, &MainWindow::onMultilevelLayout);
     connect(cbEdgeMode, &QCheckBox::toggled, this, [this](bool on){
         if (view) view->setEdgeEditMode(on);
     });
@@ -216,6 +456,15 @@ gLay->addStretch(1);
     showDagBtn->setEnabled(false);
     sccLay->addWidget(showDagBtn);
 
+    auto* dagLayoutRow = new QHBoxLayout();
+    dagLayoutRow->setSpacing(8);
+    dagLayoutRow->addWidget(new QLabel(tr("DAG 布局"), gbScc));
+    dagLayoutBox = new QComboBox(gbScc);
+    dagLayoutBox->addItem(tr("分层（按拓扑层次，边朝下）"));
+    dagLayoutBox->addItem(tr("力导（从 SCC 质心出发）"));
+    dagLayoutRow->addWidget(dagLayoutBox, 1);
+    sccLay->addLayout(dagLayoutRow);
+
     showOriBtn = new QPushButton(tr("回到原图"), gbScc);
     showOriBtn->setEnabled(false);
     sccLay->addWidget(showOriBtn);
@@ -233,15 +482,44 @@ gLay->addStretch(1);
     runTopoBtn->setObjectName("PrimaryButton");
     topoLay->addWidget(runTopoBtn);
 
+    // 可互换的点（前驱、后继都相同的“孪生点”）在序列里的相对次序只是对称的重复，勾选后每组只保留按编号升序的排法。
+    topoTwinBox = new QCheckBox(tr("孪生点只列一种排法（按编号先后）"), gbTopo);
+    topoTwinBox->setToolTip(tr("前驱、后继完全相同的点互换位置得到的序列视为同一条，只保留这些点按编号升序出现的那条。"));
+    topoLay->addWidget(topoTwinBox);
+
     topoInfoLabel = new QLabel(tr("拓扑序列：未生成"), gbTopo);
     topoInfoLabel->setObjectName("SubtleLabel");
     topoLay->addWidget(topoInfoLabel);
 
-    topoAllEdit = new QTextEdit(gbTopo);
-    topoAllEdit->setReadOnly(true);
-    topoAllEdit->setMinimumHeight(130);
-    topoAllEdit->setPlaceholderText(tr("点击“开始拓扑排序”后，会在这里列出全部拓扑序列（数量过大时仅展示前若干条）。"));
-    topoLay->addWidget(topoAllEdit);
+    // 全部拓扑序列：虚拟列表，每行在滚到可见时才按下标解码，条数再多也不卡。
+    topoList = new OrderListView(gbTopo);
+    topoList->setMinimumHeight(130);
+    topoList->setPlaceholderText(tr("点击“开始拓扑排序”后，会在这里列出全部拓扑序列（可滚动浏览任意一条，双击演示）。"));
+    topoLay->addWidget(topoList);
+
+    auto* jumpRow = new QHBoxLayout();
+    jumpRow->setSpacing(8);
+    topoJumpEdit = new QLineEdit(gbTopo);
+    topoJumpEdit->setPlaceholderText(tr("序号，如 1000000"));
+    topoJumpEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9]{1,20}"), topoJumpEdit));
+    jumpRow->addWidget(topoJumpEdit, 1);
+    topoJumpBtn = new QPushButton(tr("跳转"), gbTopo);
+    topoJumpBtn->setEnabled(false);
+    jumpRow->addWidget(topoJumpBtn);
+    topoLay->addLayout(jumpRow);
+
+    // 导出到文件（边枚举边写，可续写）/ 打开导出过的文件分页浏览（内存映射）。
+    auto* fileRow = new QHBoxLayout();
+    fileRow->setSpacing(8);
+    topoExportBtn = new QPushButton(tr("导出全部序列…"), gbTopo);
+    topoExportBtn->setEnabled(false);
+    fileRow->addWidget(topoExportBtn, 1);
+    topoShardBtn = new QPushButton(tr("多进程分片导出…"), gbTopo);
+    topoShardBtn->setEnabled(false);
+    fileRow->addWidget(topoShardBtn, 1);
+    topoOpenFileBtn = new QPushButton(tr("浏览导出文件…"), gbTopo);
+    fileRow->addWidget(topoOpenFileBtn, 1);
+    topoLay->addLayout(fileRow);
 
     aLay->addWidget(gbTopo);
 
@@ -258,6 +536,10 @@ gLay->addStretch(1);
     playBtn->setEnabled(false);
     playRow->addWidget(playBtn, 1);
 
+    prevBtn = new QPushButton(tr("上一步"), gbPlay);
+    prevBtn->setEnabled(false);
+    playRow->addWidget(prevBtn, 1);
+
     nextBtn = new QPushButton(tr("下一步"), gbPlay);
     nextBtn->setEnabled(false);
     playRow->addWidget(nextBtn, 1);
@@ -268,23 +550,125 @@ gLay->addStretch(1);
 
     playLay->addLayout(playRow);
 
-    auto* playHint = new QLabel(tr("提示：按“播放/暂停”可自动演示；按“下一步”逐步查看。"), gbPlay);
+    // 进度条：可拖到任意一步（时间轴按关键帧跳转，不需要从头重放）。
+    auto* seekRow = new QHBoxLayout();
+    seekRow->setSpacing(8);
+    stepSlider = new QSlider(Qt::Horizontal, gbPlay);
+    stepSlider->setRange(0, 0);
+    stepSlider->setEnabled(false);
+    seekRow->addWidget(stepSlider, 1);
+    stepLabel = new QLabel(tr("0 / 0"), gbPlay);
+    stepLabel->setObjectName("SubtleLabel");
+    seekRow->addWidget(stepLabel);
+    playLay->addLayout(seekRow);
+
+    // 播放速度：低速逐步看清过程；高速时每帧合并多步，只重绘一次。
+    auto* speedRow = new QHBoxLayout();
+    speedRow->setSpacing(8);
+    auto* speedLabel = new QLabel(tr("速度"), gbPlay);
+    speedLabel->setObjectName("FormLabel");
+    speedRow->addWidget(speedLabel);
+    speedBox = new QComboBox(gbPlay);
+    const int speeds[] = {1, 2, 4, 10, 30, 100, 1000, 10000, 100000};
+    for (int sps : speeds) speedBox->addItem(tr("%1 步/秒").arg(sps), sps);
+    speedBox->addItem(tr("尽可能快"), 0);
+    speedBox->setCurrentIndex(speedBox->findData(mStepsPerSecond));
+    speedRow->addWidget(speedBox, 1);
+    playLay->addLayout(speedRow);
+
+    // 步骤文件：把当前步骤存成紧凑的二进制 trace，或打开（命令行录好的）trace 直接回放。
+    auto* traceRow = new QHBoxLayout();
+    traceRow->setSpacing(8);
+    auto* saveTraceBtn = new QPushButton(tr("保存步骤…"), gbPlay);
+    auto* openTraceBtn = new QPushButton(tr("打开步骤文件…"), gbPlay);
+    traceRow->addWidget(saveTraceBtn, 1);
+    traceRow->addWidget(openTraceBtn, 1);
+    playLay->addLayout(traceRow);
+    connect(saveTraceBtn, &QPushButton::clicked, this, &MainWindow::onSaveStepTrace);
+    connect(openTraceBtn, &QPushButton::clicked, this, &MainWindow::onOpenStepTrace);
+
+    auto* playHint = new QLabel(tr("提示：按“播放/暂停”可自动演示；按“上一步/下一步”逐步查看，或拖动进度条跳转。"), gbPlay);
     playHint->setObjectName("HintText");
     playHint->setWordWrap(true);
     playLay->addWidget(playHint);
 
     aLay->addWidget(gbPlay);
 
+    // 后台任务：进度、取消、预算。
+    auto* gbTask = new QGroupBox(tr("后台任务"), algoPanel);
+    auto* taskLay = new QVBoxLayout(gbTask);
+    taskLay->setContentsMargins(12, 14, 12, 12);
+    taskLay->setSpacing(10);
+
+    auto* taskRow = new QHBoxLayout();
+    taskRow->setSpacing(8);
+    taskLabel = new QLabel(tr("空闲"), gbTask);
+    taskLabel->setObjectName("SubtleLabel");
+    taskLabel->setWordWrap(true);
+    taskRow->addWidget(taskLabel, 1);
+    taskCancelBtn = new QPushButton(tr("取消"), gbTask);
+    taskCancelBtn->setEnabled(false);
+    taskRow->addWidget(taskCancelBtn);
+    taskLay->addLayout(taskRow);
+
+    auto* budgetForm = new QFormLayout();
+    budgetForm->setSpacing(8);
+    taskTimeSpin = new QSpinBox(gbTask);
+    taskTimeSpin->setRange(0, 24 * 3600);
+    taskTimeSpin->setSuffix(tr(" 秒"));
+    taskTimeSpin->setSpecialValueText(tr("不限"));
+    taskTimeSpin->setValue(0);
+    budgetForm->addRow(tr("时间上限"), taskTimeSpin);
+    taskMemSpin = new QSpinBox(gbTask);
+    taskMemSpin->setRange(16, 64 * 1024);
+    taskMemSpin->setSuffix(tr(" MB"));
+    taskMemSpin->setValue(256);
+    budgetForm->addRow(tr("内存上限"), taskMemSpin);
+    taskLay->addLayout(budgetForm);
+
+    aLay->addWidget(gbTask);
+
+    // 任务运行期间锁住的面板（结果回来之前不允许再改图/播放）。
+    mTaskLockedPanels = {gbScc, gbTopo, gbPlay};
+
     // Log group
     auto* gbLog = new QGroupBox(tr("步骤日志"), algoPanel);
     auto* logLay = new QVBoxLayout(gbLog);
     logLay->setContentsMargins(12, 14, 12, 12);
     logLay->setSpacing(10);
 
-    logEdit = new QTextEdit(gbLog);
-    logEdit->setReadOnly(true);
-    logEdit->setMinimumHeight(160);
-    logLay->addWidget(logEdit);
+    // 过滤行：按 Step 类型筛选 + 文字搜索。
+    auto* filterRow = new QHBoxLayout();
+    filterRow->setSpacing(8);
+    logTypeBox = new QComboBox(gbLog);
+    logTypeBox->addItem(tr("全部"), StepLogModel::kAllTypes);
+    logTypeBox->addItem(tr("说明文字"), StepLogModel::kTextBit);
+    auto bit = [](StepType t) { return 1u << int(t); };
+    logTypeBox->addItem(tr("Tarjan 步骤"),
+                        bit(StepType::Visit) | bit(StepType::PushStack) | bit(StepType::PopStack)
+                        | bit(StepType::AssignSCC));
+    logTypeBox->addItem(tr("拓扑步骤"),
+                        bit(StepType::TopoInitIndeg) | bit(StepType::TopoEnqueue)
+                        | bit(StepType::TopoDequeue) | bit(StepType::TopoIndegDec));
+    for (int t = int(StepType::ResetVisual); t <= int(StepType::TopoIndegDec); ++t) {
+        logTypeBox->addItem(tr("仅：%1").arg(StepLogModel::typeName(StepType(t))), 1u << t);
+    }
+    filterRow->addWidget(logTypeBox);
+    logSearchEdit = new QLineEdit(gbLog);
+    logSearchEdit->setPlaceholderText(tr("搜索日志…"));
+    logSearchEdit->setClearButtonEnabled(true);
+    filterRow->addWidget(logSearchEdit, 1);
+    logLay->addLayout(filterRow);
+
+    // 日志本体：行高一致，视图只对可见行取数据，trace 再长也不会越播越卡。
+    mLog = new StepLogModel(this);
+    logView = new QListView(gbLog);
+    logView->setModel(mLog);
+    logView->setUniformItemSizes(true);
+    logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    logView->setMinimumHeight(160);
+    logLay->addWidget(logView);
 
     aLay->addWidget(gbLog);
 
@@ -299,10 +683,53 @@ gLay->addStretch(1);
     connect(runSccBtn, &QPushButton::clicked, this, &MainWindow::onRunSCC);
     connect(runTopoBtn, &QPushButton::clicked, this, &MainWindow::onRunTopo);
     connect(showDagBtn, &QPushButton::clicked, this, &MainWindow::onShowDAG);
+    connect(dagLayoutBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) {
+        onDagLayoutChanged();
+    });
     connect(showOriBtn, &QPushButton::clicked, this, &MainWindow::onShowOriginal);
     connect(playBtn, &QPushButton::clicked, this, &MainWindow::onPlayPause);
     connect(nextBtn, &QPushButton::clicked, this, &MainWindow::onNextStep);
+    connect(prevBtn, &QPushButton::clicked, this, &MainWindow::onPrevStep);
+    connect(stepSlider, &QSlider::valueChanged, this, &MainWindow::onSeekStep);
+    connect(speedBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) {
+        mStepsPerSecond = speedBox->itemData(idx).toInt();
+        mStepCarry = 0.0;
+    });
     connect(resetAlgoBtn, &QPushButton::clicked, this, &MainWindow::onResetAlgo);
+    connect(taskCancelBtn, &QPushButton::clicked, this, [this]() {
+        if (mTask) mTask->requestCancel();
+    });
+    connect(topoJumpBtn, &QPushButton::clicked, this, &MainWindow::onJumpToOrder);
+    connect(topoJumpEdit, &QLineEdit::returnPressed, this, &MainWindow::onJumpToOrder);
+    connect(topoList, &OrderListView::rowActivated, this, &MainWindow::onPlayOrder);
+    connect(topoExportBtn, &QPushButton::clicked, this, &MainWindow::onExportOrders);
+    connect(topoOpenFileBtn, &QPushButton::clicked, this, &MainWindow::onOpenOrderFile);
+    connect(topoShardBtn, &QPushButton::clicked, this, &MainWindow::onShardExport);
+    connect(topoTwinBox, &QCheckBox::toggled, this, [this](bool) {
+        if (!mTopoOrdersReady) return;
+        clearTopoOrders();
+        statusBar()->showMessage(tr("序列去重方式已改变，请重新开始拓扑排序"), 3000);
+    });
+    connect(logTypeBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) {
+        mLog->setTypeFilter(logTypeBox->itemData(idx).toUInt());
+    });
+    connect(logSearchEdit, &QLineEdit::textChanged, mLog, &StepLogModel::setSearchText);
+
+    // 视图停在底部时，新日志进来自动跟随；用户往上翻时不打扰。
+    connect(mLog, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar* bar = logView->verticalScrollBar();
+        mLogFollow = (bar->value() >= bar->maximum());
+    });
+    connect(mLog, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (mLogFollow) logView->scrollToBottom();
+    });
+    // 双击某一步的日志：跳到那一步之后。
+    connect(logView, &QListView::doubleClicked, this, [this](const QModelIndex& idx) {
+        const int step = mLog->stepIndexAt(idx.row());
+        if (step >= 0 && stepTotal() > 0) onSeekStep(step + 1);
+    });
+
+    setupPerfDock();
 
     // 菜单开关：Dock 被关闭后可通过菜单重新打开。
     setupPanelsMenu();
@@ -333,18 +760,28 @@ MainWindow::MainWindow(QWidget *parent)
 setupDocks();
 
     // 播放计时器（用于 播放/暂停）。
-    // 间隔不要太小，保证用户能看清算法过程。
-    mPlayTimer.setInterval(260);
+    // 固定按帧（约 60FPS）触发；每帧走几步由速度档位决定（见 onPlayTick）。
+    mPlayTimer.setInterval(16);
     connect(&mPlayTimer, &QTimer::timeout, this, &MainWindow::onPlayTick);
 
 connect(view, &GraphView::edgeRequested, this, &MainWindow::onEdgeRequested);
 
+    // 后台任务进度：界面线程定时读 TaskControl 的原子计数。
+    mTaskPoll.setInterval(100);
+    connect(&mTaskPoll, &QTimer::timeout, this, &MainWindow::updateTaskProgress);
+
     // 默认先创建一个
     onCreateGraph();
 }
 
 bool MainWindow::addEdgeImpl(int u, int v)
 {
+    // 后台任务正在用这张图：不允许修改。
+    if (mTaskThread) {
+        statusBar()->showMessage(tr("后台任务运行中，暂不能修改图"), 2000);
+        return false;
+    }
+
     // 当显示的是 DAG 时继续修改原图会让用户认知混乱。
     // 因此强制切回原图视图，保持“所见即所算”。
     if (mShowingDag) onShowOriginal();
@@ -360,6 +797,8 @@ bool MainWindow::addEdgeImpl(int u, int v)
 
     mGraph.addEdge(u, v);
     view->addEdge(u, v);
+    view->setSceneKey(++mGraphVersion);      // 原图场景是增量改的，仍然有效
+    view->dropScene(GraphView::SceneSlot::Dag);
     updateEdgeCountUI();
 
     // 图结构发生变化：已有 SCC / DAG 缓存不再有效。
@@ -370,12 +809,7 @@ bool MainWindow::addEdgeImpl(int u, int v)
     mPosOriginalSnapshot.clear();
 
     // 拓扑序列缓存失效。
-    mAllTopoOrders.clear();
-    mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
-    mTopoOrdersReady = false;
-    if (topoInfoLabel) topoInfoLabel->setText(tr("拓扑序列：未生成"));
-    if (topoAllEdit) topoAllEdit->clear();
+    clearTopoOrders();
     if (showDagBtn) showDagBtn->setEnabled(false);
     if (showOriBtn) showOriBtn->setEnabled(false);
     if (runTopoBtn) runTopoBtn->setEnabled(false);
@@ -403,12 +837,7 @@ void MainWindow::onCreateGraph()
     mPosOriginalSnapshot.clear();
 
     // 拓扑序列缓存失效。
-    mAllTopoOrders.clear();
-    mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
-    mTopoOrdersReady = false;
-    if (topoInfoLabel) topoInfoLabel->setText(tr("拓扑序列：未生成"));
-    if (topoAllEdit) topoAllEdit->clear();
+    clearTopoOrders();
 
     // 禁用控件，屏蔽交互
     if (showDagBtn) showDagBtn->setEnabled(false);
@@ -419,7 +848,8 @@ void MainWindow::onCreateGraph()
     uSpin->setRange(1, n);
     vSpin->setRange(1, n);
 
-    view->showGraph(mGraph, mPos);
+    view->showGraph(mGraph, mPos, ++mGraphVersion);
+    view->dropScene(GraphView::SceneSlot::Dag);
     updateEdgeCountUI();
 
     // 图变化时重置算法播放状态。
@@ -447,6 +877,42 @@ void MainWindow::onAddEdgesFromText()
         if (a && b && addEdgeImpl(u, v)) ok++;
     }
     statusBar()->showMessage(QString("Added %1 edges (total %2)").arg(ok).arg(mGraph.edges.size()), 2000);
+
+    // 一次加很多边时，从当前（多半是圆形）坐标跑力导要很久才能解开：直接整理一次。
+    if (ok >= kAutoMultilevelEdges && !mShowingDag && !mTaskThread) onMultilevelLayout();
+}
+
+void MainWindow::onMultilevelLayout()
+{
+    if (!view) return;
+    if (mShowingDag && dagLayered()) {
+        statusBar()->showMessage(tr("分层布局下不需要整理；切到力导布局后再试"), 2000);
+        return;
+    }
+    if (mTaskThread) {
+        statusBar()->showMessage(tr("后台任务运行中，稍后再整理布局"), 2000);
+        return;
+    }
+    const bool onDag = mShowingDag;
+    auto graph = std::make_shared<Graph>(onDag ? mDag : mGraph);
+    auto layout = std::make_shared<std::vector<LayoutPoint>>();
+    auto levels = std::make_shared<std::vector<int>>();
+    runTask(tr("多级布局"), [graph, layout, levels](TaskControl& ctl) {
+        MultilevelLayout ml;
+        *layout = ml.run(*graph, &ctl);
+        *levels = ml.levelSizes();
+    }, [this, graph, layout, levels, onDag]() {
+        // 期间切换了视图或改了点数：结果作废。
+        const Graph& cur = onDag ? mDag : mGraph;
+        if (mShowingDag != onDag || cur.n != graph->n || (int)layout->size() != cur.n + 1) return;
+        view->applyPositions(toScenePoints(*layout), 0.1);
+
+        if (mLog) {
+            QStringList sizes;
+            for (int s : *levels) sizes << QString::number(s);
+            mLog->appendText(QString("多级布局：%1 层（%2）").arg(levels->size()).arg(sizes.join(" → ")));
+        }
+    });
 }
 
 void MainWindow::onEdgeRequested(int u, int v)
@@ -461,49 +927,61 @@ void MainWindow::onRunSCC()
     // 先切回原图，保证“可视化对象”与“算法输入”一致。
     if (mShowingDag) onShowOriginal();
 
+    // 对当前有向图运行 Tarjan SCC（后台线程），结果回到界面线程后缓存步骤用于回放。
+    // 后台只拿图的一份拷贝；算法本身保持纯净，可视化在 GraphView::applyStep() 中完成。
+    // 这里只要 SCC 映射；回放用的步骤不在这里攒，播放时由 TarjanStepper 现算（见 finishRunSCC）。
+    auto graph = std::make_shared<Graph>(mGraph);
+    auto res = std::make_shared<SCCResult>();
+    runTask(tr("Tarjan SCC"), [graph, res](TaskControl& ctl) {
+        TarjanSCC tarjan;
+        DiscardStepSink discard;
+        *res = tarjan.run(*graph, &ctl, &discard);
+    }, [this, res]() {
+        finishRunSCC(std::move(*res));
+    });
+}
+
+void MainWindow::finishRunSCC(SCCResult res)
+{
     // 从干净的可视化状态开始播放，这样 SCC 着色能按步骤逐步出现。
     if (view) view->applyStep({StepType::ResetVisual, -1, -1, -1, 1, QString("重置可视化状态")});
-    // 对当前有向图运行 Tarjan SCC，并缓存步骤用于回放。
-    // 算法本身保持纯净；可视化在 GraphView::applyStep() 中完成。
-    TarjanSCC tarjan;
-    SCCResult res = tarjan.run(mGraph);
 
     mAlgoMode = AlgoMode::TarjanSCC;
     mTopoRes = TopoResult();
+    mTopoTape.reset();
 
     // SCC 变化后，DAG 以及所有拓扑序列都应重新计算。
-    mAllTopoOrders.clear();
-    mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
-    mTopoOrdersReady = false;
-    if (topoInfoLabel) topoInfoLabel->setText(tr("拓扑序列：未生成"));
-    if (topoAllEdit) topoAllEdit->clear();
+    clearTopoOrders();
 
     // 缓存 SCC 映射：供第 5 步缩点建 DAG，以及第 6 步拓扑回放使用。
-    mSccRes = res;
+    mSccRes = std::move(res);
     mHasScc = true;
+    ++mSccVersion;
     mShowingDag = false;
     if (showDagBtn) showDagBtn->setEnabled(true);
     if (showOriBtn) showOriBtn->setEnabled(false);
 
-    mSteps.clear();
-    mSteps.reserve((int)res.steps.size());
-    for (const Step& s : res.steps) mSteps.push_back(s);
+    // 回放时再跑一遍 Tarjan：状态机播到哪儿算到哪儿，走过的步录进 tape 供日志显示。
     mStepIndex = 0;
-
-    if (logEdit) {
-        logEdit->clear();
-        logEdit->append(QString("SCC count = %1").arg(res.sccCnt));
-        logEdit->append("----");
+    auto tape = std::make_shared<StepTape>(std::make_unique<TarjanStepper>(mGraph));
+    view->loadTimeline(tape);
+
+    if (mLog) {
+        mLog->resetTrace(stepTotal(), [tape](int i) {
+            Step s = tape->stepAt(std::size_t(i));
+            s.note = stepNote(s, TraceAlgorithm::TarjanScc);
+            return s;
+        });
+        mLog->appendText(QString("SCC count = %1").arg(mSccRes.sccCnt));
+        mLog->appendText("----");
     }
 
     // 启用播放控制按钮。
-    playBtn->setEnabled(!mSteps.isEmpty());
-    nextBtn->setEnabled(!mSteps.isEmpty());
+    playBtn->setEnabled(stepTotal() > 0);
     resetAlgoBtn->setEnabled(true);
+    updateStepUI();
 
-    statusBar()->showMessage(QString("Tarjan SCC 产生了 %1 个步骤").arg(mSteps.size()), 2500);
-
+    statusBar()->showMessage(QString("Tarjan SCC 共 %1 个步骤").arg(stepTotal()), 2500);
 }
 
 void MainWindow::onRunTopo()
@@ -514,69 +992,90 @@ void MainWindow::onRunTopo()
     }
 
     // 拓扑排序在缩点后的 DAG 上进行。
-    // 若当前不是 DAG 视图，则先切换到 DAG（阶段切换需要确定性）。
-    if (!mShowingDag) onShowDAG();
-    if (!mShowingDag) return; // onShowDAG 可能因为 SCC 未就绪而失败。
+    // 若当前不是 DAG 视图，则先切换到 DAG（阶段切换需要确定性），切换完成后再回到这里。
+    if (!mShowingDag) {
+        showDagThen([this]() { if (mShowingDag) onRunTopo(); });
+        return;
+    }
+
+    // 只做计数（记忆化），不枚举；具体某一条序列在需要时按下标解码。宽 DAG 计数也可能很慢，放到后台。
+    // 只列规范序列时，在每组孪生点之间按编号补链再计数：新 DAG 的序列恰好是孪生点按编号升序出现的那些。
+    auto dag = std::make_shared<Graph>(mDag);
+    auto rank = std::make_shared<TopoRank>();
+    const bool canonical = topoTwinBox && topoTwinBox->isChecked();
+    runTask(tr("拓扑序列计数"), [dag, rank, canonical](TaskControl& ctl) {
+        if (canonical) *dag = twinCanonicalDag(*dag, findTwins(*dag));
+        rank->build(*dag, ctl.memoryBudget(TopoRank::kDefaultMemoryBudget), &ctl);
+    }, [this, dag, rank]() {
+        mOrderDag = std::move(*dag);
+        finishRunTopo(std::move(*rank));
+    });
+}
 
+void MainWindow::finishRunTopo(TopoRank rank)
+{
     // 清理瞬态高亮（保留 DAG 节点的 SCC 调色板颜色）。
     if (view) view->applyStep({StepType::ResetVisual, -1, -1, -1, 0, QString("为拓扑排序重置")});
 
-    // 先枚举全部拓扑序列。
-    TopoKahn topo;
-    TopoAllResult all = topo.enumerateAll(mDag);
-    mAllTopoOrders = all.orders;
-    mTopoOrdersReady = all.ok;
+    // 预取线程读着旧的计数表，换表之前先停下。
+    mOrderPrefetch.stop();
+    mPrefetchDag.reset();
+    mTopoRank = std::move(rank);
+    mTopoOrdersReady = !mTopoRank.empty();
     mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
+    mTopoOrderPlaying = kNoOrder;
 
     // 注意：此处不立即生成 steps；由“播放”按钮每次加载并演示一条序列。
-    mSteps.clear();
     mStepIndex = 0;
     mAlgoMode = AlgoMode::TopoKahn;
     mTopoRes = TopoResult();
-
-    if (logEdit) {
-        logEdit->clear();
-        logEdit->append(QString("Topo (总) DAG；统计: n=%1, m=%2").arg(mDag.n).arg(mDag.edges.size()));
-        logEdit->append(QString("所有点处理完毕 = %1").arg(all.ok ? "true" : "false"));
-        logEdit->append(QString("总拓扑数量 = %1").arg((int)mAllTopoOrders.size()));
-        logEdit->append("----");
-        logEdit->append(tr("点击“播放”：每次生成并动态演示 1 条拓扑序列；播完后再点“播放”会演示下一条。"));
+    mTopoTape.reset();
+
+    if (mLog) {
+        mLog->clear();
+        mLog->appendText(QString("Topo (总) DAG；统计: n=%1, m=%2").arg(mDag.n).arg(mDag.edges.size()));
+        mLog->appendText(QString("所有点处理完毕 = %1").arg(mTopoOrdersReady ? "true" : "false"));
+        mLog->appendText(QString("总拓扑数量 = %1").arg(topoCountText()));
+        if (mTopoRank.components() > 1) {
+            mLog->appendText(QString("DAG 分成 %1 个互不相连的部分：各自计数，序列按交错方式合并").arg(mTopoRank.components()));
+        }
+        if (mOrderDag.edges.size() != mDag.edges.size()) {
+            mLog->appendText(QString("孪生点只列一种排法：补了 %1 条链边，孪生点按编号先后出现")
+                                 .arg(mOrderDag.edges.size() - mDag.edges.size()));
+        }
+        mLog->appendText("----");
+        mLog->appendText(tr("点击“播放”：每次生成并动态演示 1 条拓扑序列；播完后再点“播放”会演示下一条。"));
     }
 
-    if (topoInfoLabel) {
-        topoInfoLabel->setText(QString("拓扑序列：共 %1 条，当前 0/%1（未播放）")
-                               .arg((int)mAllTopoOrders.size()));
-    }
+    updateTopoInfo();
 
-    // 默认仅展示前若干条，避免序列过多导致界面卡顿。
-    if (topoAllEdit) {
-        topoAllEdit->clear();
-        const int total = (int)mAllTopoOrders.size();
-        const int showK = std::min(total, 200);
-        for (int i = 0; i < showK; ++i) {
-            QStringList seq;
-            for (int x : mAllTopoOrders[i]) seq << QString::number(x);
-            topoAllEdit->append(QString("%1) %2").arg(i + 1).arg(seq.join(" ")));
-        }
-        if (total > showK) {
-            topoAllEdit->append(QString("...（共 %1 条，仅展示前 %2 条；其余可通过逐次播放/日志查看）")
-                                .arg(total).arg(showK));
-        }
+    closeOrderFile();
+    if (topoList) {
+        topoList->setSource(mTopoRank.count(), [this](quint64 i) {
+            return formatOrderRow(i, mTopoRank.orderAt(i));
+        });
     }
+    if (topoJumpBtn) topoJumpBtn->setEnabled(mTopoOrdersReady);
+    if (topoExportBtn) topoExportBtn->setEnabled(mTopoOrdersReady);
+    if (topoShardBtn) topoShardBtn->setEnabled(mTopoOrdersReady);
 
     // 允许播放（即使序列为空也给出提示）。
-    playBtn->setEnabled(!mAllTopoOrders.empty() && mTopoOrdersReady);
-    nextBtn->setEnabled(false);
+    playBtn->setEnabled(mTopoOrdersReady);
     resetAlgoBtn->setEnabled(true);
+    updateStepUI();
     playBtn->setText("播放");
     mPlaying = false;
     mPlayTimer.stop();
 
-    statusBar()->showMessage(QString("已生成 %1 条拓扑序列（播放将逐条演示）").arg((int)mAllTopoOrders.size()), 2500);
+    statusBar()->showMessage(QString("拓扑序列共 %1 条（播放将逐条演示）").arg(topoCountText()), 2500);
 }
 
 void MainWindow::onShowDAG()
+{
+    showDagThen(nullptr);
+}
+
+void MainWindow::showDagThen(std::function<void()> then)
 {
     if (!mHasScc) {
         statusBar()->showMessage(tr("请先运行 SCC (Tarjan)"), 2000);
@@ -588,14 +1087,14 @@ void MainWindow::onShowDAG()
     // （否则会出现错误高亮甚至越界）。
     mPlayTimer.stop();
     mPlaying = false;
-    mSteps.clear();
     mStepIndex = 0;
+    view->clearTimeline();
     mAlgoMode = AlgoMode::None;
     mTopoRes = TopoResult();
+    mTopoTape.reset();
     mAlgoMode = AlgoMode::None;
     mTopoRes = TopoResult();
     if (playBtn) { playBtn->setEnabled(false); playBtn->setText("播放"); }
-    if (nextBtn) nextBtn->setEnabled(false);
     if (resetAlgoBtn) resetAlgoBtn->setEnabled(false);
 
     // 1) 抓取当前原图节点坐标快照。
@@ -603,18 +1102,38 @@ void MainWindow::onShowDAG()
     // 这样每个 SCC 的质心会成为缩点 DAG 的自然初始位置。
     mPosOriginalSnapshot = view->snapshotPositions(mGraph.n);
 
-    // 2) 构建缩点图（SCC 图 / DAG）。
-    Condense cond;
-    CondenseResult cRes = cond.run(mGraph, mSccRes.sccId, mSccRes.sccCnt);
-    mDag = cRes.dag;
+    // SCC 结果没变过：DAG 和它的场景都还在，直接换回来（坐标保持上次的样子），不再缩点、不再重建 item。
+    // 分层 / 力导与上次不同也没关系：缓存是分层而现在要力导，就从分层坐标接着跑力导
+    // （反过来的情况在 onDagLayoutChanged 里已经丢掉了缓存）。
+    if (view->restoreScene(GraphView::SceneSlot::Dag, mSccVersion, sccPaletteIds(mSccRes.sccCnt))) {
+        view->setLayoutMode(dagLayered() ? GraphView::LayoutMode::Static : GraphView::LayoutMode::Force);
+        enterDagView();
+        if (then) then();
+        return;
+    }
+
+    // 2) 构建缩点图（SCC 图 / DAG）：后台线程完成，结果在 finishShowDAG 里落地。
+    //    分层布局也在同一个后台任务里算好，落地时一次摆好所有点。
+    auto graph = std::make_shared<Graph>(mGraph);
+    auto dag = std::make_shared<Graph>();
+    auto layout = std::make_shared<std::vector<LayoutPoint>>();
+    runTask(tr("缩点"), [graph, dag, layout, layered = dagLayered(),
+                         sccId = mSccRes.sccId, sccCnt = mSccRes.sccCnt](TaskControl& ctl) {
+        Condense cond;
+        *dag = cond.run(*graph, sccId, sccCnt, &ctl).dag;
+        if (layered && !ctl.stopped()) *layout = LayeredLayout().run(*dag, &ctl);
+    }, [this, dag, layout, then]() {
+        finishShowDAG(std::move(*dag), std::move(*layout));
+        if (then) then();
+    });
+}
+
+void MainWindow::finishShowDAG(Graph dag, std::vector<LayoutPoint> layout)
+{
+    mDag = std::move(dag);
 
     // DAG 变化：拓扑序列缓存失效。
-    mAllTopoOrders.clear();
-    mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
-    mTopoOrdersReady = false;
-    if (topoInfoLabel) topoInfoLabel->setText(tr("拓扑序列：未生成"));
-    if (topoAllEdit) topoAllEdit->clear();
+    clearTopoOrders();
 
     // 3) 计算每个 SCC 的质心作为 DAG 节点初始位置。
     const int C = mSccRes.sccCnt;
@@ -629,43 +1148,90 @@ void MainWindow::onShowDAG()
     for (int cid = 1; cid <= C; ++cid) {
         if (cnt[cid] > 0) dagPos[cid] = dagPos[cid] / cnt[cid];
     }
+    // 分层布局算好了就直接用（不再从质心出发跑力导）。
+    const bool layered = ((int)layout.size() == C + 1);
+    if (layered) dagPos = toScenePoints(layout);
 
     // 4) 准备标签与颜色组。
     QStringList labels(C + 1);
-    QVector<int> colorId(C + 1, 0);
-    for (int cid = 1; cid <= C; ++cid) {
-        labels[cid] = QString("S%1").arg(cid);
-        colorId[cid] = cid; // 每个 SCC 使用稳定的确定性调色板颜色
-    }
+    for (int cid = 1; cid <= C; ++cid) labels[cid] = QString("S%1").arg(cid);
+
+    // 5) 切换视图显示 DAG（建在 DAG 槽位里，原图的场景留着，切回去时不用重建）。
+    //    布局模式是按槽位记的，要在切到 DAG 槽位之后再设。
+    view->showGraphEx(mDag, dagPos, labels, sccPaletteIds(C), GraphView::SceneSlot::Dag, mSccVersion);
+    view->setLayoutMode(layered ? GraphView::LayoutMode::Static : GraphView::LayoutMode::Force);
+    enterDagView();
+}
 
-    // 5) 切换视图显示 DAG。
-    view->showGraphEx(mDag, dagPos, labels, colorId);
+void MainWindow::enterDagView()
+{
+    updateStepUI();
     mShowingDag = true;
     if (showDagBtn) showDagBtn->setEnabled(false);
     if (showOriBtn) showOriBtn->setEnabled(true);
     if (runTopoBtn) runTopoBtn->setEnabled(true);
 
-    if (logEdit) {
-        logEdit->append("----");
-        logEdit->append(QString("切换到 DAG: %1 SCC 点数, %2 边数")
-                        .arg(mDag.n)
-                        .arg(mDag.edges.size()));
+    if (mLog) {
+        mLog->appendText("----");
+        mLog->appendText(QString("切换到 DAG: %1 SCC 点数, %2 边数")
+                          .arg(mDag.n)
+                          .arg(mDag.edges.size()));
     }
     statusBar()->showMessage(tr("DAG 视图"), 2000);
 }
 
+bool MainWindow::dagLayered() const
+{
+    return dagLayoutBox && dagLayoutBox->currentIndex() == 0;
+}
+
+QVector<QPointF> MainWindow::toScenePoints(const std::vector<LayoutPoint>& pts)
+{
+    QVector<QPointF> pos(int(pts.size()));
+    for (int i = 0; i < pos.size(); ++i) pos[i] = QPointF(pts[std::size_t(i)].x, pts[std::size_t(i)].y);
+    return pos;
+}
+
+void MainWindow::onDagLayoutChanged()
+{
+    // 只影响 DAG 视图；不在 DAG 视图时下次“展示 DAG”生效。
+    // 缓存的 DAG 场景若是力导坐标，换成分层就得重算：丢掉缓存，下次展示时连同分层布局一起重建。
+    if (!view) return;
+    if (!mShowingDag) {
+        if (dagLayered()) view->dropScene(GraphView::SceneSlot::Dag);
+        return;
+    }
+    if (!dagLayered()) {
+        view->setLayoutMode(GraphView::LayoutMode::Force);   // 从当前位置继续力导
+        return;
+    }
+    if (mTaskThread) {
+        statusBar()->showMessage(tr("后台任务运行中，稍后再切换布局"), 2000);
+        return;
+    }
+    auto dag = std::make_shared<Graph>(mDag);
+    auto layout = std::make_shared<std::vector<LayoutPoint>>();
+    runTask(tr("分层布局"), [dag, layout](TaskControl& ctl) {
+        *layout = LayeredLayout().run(*dag, &ctl);
+    }, [this, layout]() {
+        if (!mShowingDag || (int)layout->size() != mDag.n + 1) return;
+        view->setLayoutMode(GraphView::LayoutMode::Static);
+        view->applyPositions(toScenePoints(*layout));
+    });
+}
+
 void MainWindow::onShowOriginal()
 {
     // 视图切换会使当前播放序列失效，应当停止播放并清理状态。
     mPlayTimer.stop();
     mPlaying = false;
-    mSteps.clear();
     mStepIndex = 0;
+    view->clearTimeline();
     mAlgoMode = AlgoMode::None;
     mTopoRes = TopoResult();
+    mTopoTape.reset();
     mAlgoMode = AlgoMode::None;
     if (playBtn) { playBtn->setEnabled(false); playBtn->setText("播放"); }
-    if (nextBtn) nextBtn->setEnabled(false);
     if (resetAlgoBtn) resetAlgoBtn->setEnabled(false);
     // 恢复到原图视图。
     QVector<QPointF> pos = mPosOriginalSnapshot;
@@ -678,7 +1244,12 @@ void MainWindow::onShowOriginal()
         for (int i = 1; i <= mGraph.n; ++i) colorId[i] = mSccRes.sccId[i];
     }
 
-    view->showGraphEx(mGraph, pos, QStringList(), colorId);
+    // 原图没改过：直接换回离开时的场景；否则按快照坐标重建。
+    if (!view->restoreScene(GraphView::SceneSlot::Original, mGraphVersion, colorId)) {
+        view->showGraphEx(mGraph, pos, QStringList(), colorId, GraphView::SceneSlot::Original, mGraphVersion);
+    }
+    view->setLayoutMode(GraphView::LayoutMode::Force);
+    updateStepUI();
     mShowingDag = false;
     if (showDagBtn) showDagBtn->setEnabled(mHasScc);
     if (showOriBtn) showOriBtn->setEnabled(false);
@@ -686,114 +1257,280 @@ void MainWindow::onShowOriginal()
     statusBar()->showMessage(tr("Back to original graph"), 1500);
 }
 
-void MainWindow::onPlayPause()
+bool MainWindow::loadTopoOrder()
 {
-    // Topo 模式：每次“开始播放”（非播放状态下）若当前没有可播放步骤，则先生成 1 条拓扑序列的 steps。
-    if (mAlgoMode == AlgoMode::TopoKahn && !mPlaying) {
-        const bool needNewSeq = mSteps.isEmpty() || (mStepIndex >= mSteps.size());
-        if (needNewSeq) {
-            if (!mTopoOrdersReady || mAllTopoOrders.empty()) {
-                statusBar()->showMessage(tr("当前没有可用的拓扑序列"), 2000);
-                return;
-            }
+    if (!mTopoOrdersReady) {
+        statusBar()->showMessage(tr("当前没有可用的拓扑序列"), 2000);
+        return false;
+    }
 
-            // 若已播放完，循环回到第一条（避免“点了没反应”）。
-            if (mTopoOrderCursor >= (int)mAllTopoOrders.size()) {
-                mTopoOrderCursor = 0;
-            }
-            mTopoOrderPlaying = mTopoOrderCursor;
-
-            // 每条序列开始前：清理上一次的 Topo 状态（保留 SCC 颜色）。
-            if (view) view->applyStep({StepType::ResetVisual, -1, -1, -1, 0, QString("开始新的拓扑序列")});
-
-            TopoKahn topo;
-            mTopoRes = topo.runWithOrder(mDag, mAllTopoOrders[mTopoOrderCursor]);
-
-            // 缓存 steps
-            mSteps.clear();
-            mSteps.reserve((int)mTopoRes.steps.size());
-            for (const Step& s : mTopoRes.steps) mSteps.push_back(s);
-            mStepIndex = 0;
-
-            // 日志：显示正在播放的拓扑序列
-            if (logEdit) {
-                logEdit->clear();
-                logEdit->append(QString("Topo 演示：DAG n=%1, m=%2")
-                                .arg(mDag.n).arg(mDag.edges.size()));
-                logEdit->append(QString("当前演示：第 %1/%2 条拓扑序列")
-                                .arg(mTopoOrderPlaying + 1)
-                                .arg((int)mAllTopoOrders.size()));
-                if (mTopoRes.ok) {
-                    QStringList seq;
-                    for (int x : mTopoRes.order) seq << QString::number(x);
-                    logEdit->append(QString("本次序列：%1").arg(seq.join(" ")));
+    // 若已播放完，循环回到第一条（避免“点了没反应”）。
+    if (mTopoOrderCursor >= mTopoRank.count()) {
+        mTopoOrderCursor = 0;
+    }
+    const quint64 prevIndex = mTopoOrderPlaying;
+    mTopoOrderPlaying = mTopoOrderCursor;
+    const bool onTimeline = mTopoTape && !view->timeline().empty();
+
+    // 后台预取（见 OrderPrefetcher）已经准备好这一条，且它的公共前缀正是相对时间轴上这一条求的：
+    // 解码、求前缀、生成后缀都已做完，这里只把现成的后缀接上。
+    OrderPrefetcher::Prepared pre;
+    bool prefetched = mOrderPrefetch.take(mTopoOrderCursor, pre);
+    if (prefetched && pre.depth >= 0 && !(onTimeline && pre.baseIndex == prevIndex)) prefetched = false;
+
+    // 不预先生成 steps：KahnOrderStepper 随播放一步步产出，开播不等整条序列演示完。
+    // 序列来自 TopoRank，本身就是合法拓扑序。
+    std::vector<int> prevOrder = std::move(mTopoRes.order);
+    mTopoRes = TopoResult();
+    mTopoRes.order = prefetched ? std::move(pre.order) : mTopoRank.orderAt(mTopoOrderCursor);
+    mTopoRes.ok = ((int)mTopoRes.order.size() == mDag.n);
+
+    // 与时间轴上的上一条序列前 d 个输出相同（相邻序列通常共享很长的前缀）时，
+    // 它们的 trace 在第 d+1 个输出之前完全一样：时间轴截在那里接着演示分歧的后缀，
+    // 前缀不重算也不重放。没有预取时 d 取“上一条已经播到过”的最长公共前缀。
+    int shared = -1;
+    std::size_t sharedSteps = 0;
+    if (prefetched) {
+        // 上一条可能还没播到分歧点：先往前走到那里（前缀的步由上一条的状态机补出），再截断。
+        if (pre.depth >= 0 && int(pre.skipped) > view->timeline().built()) view->timelineSeek(int(pre.skipped));
+        if (pre.depth < 0 || mTopoTape->count() >= pre.skipped) {
+            shared = pre.depth;
+            sharedSteps = pre.skipped;
+        } else {
+            prefetched = false;   // 时间轴没有那么长（不该发生），按没有预取处理
+        }
+    } else if (onTimeline && (int)prevOrder.size() == mDag.n) {
+        int d = 0;
+        while (d < mDag.n && prevOrder[d] == mTopoRes.order[d]) ++d;
+        if (d < mDag.n) {   // 同一条序列重播时从头演示
+            const std::vector<std::size_t> bounds = KahnOrderStepper::prefixSteps(mDag, mTopoRes.order, d);
+            for (; d >= 0; --d) {
+                if (bounds[d] <= std::size_t(view->timeline().built())) {
+                    shared = d;
+                    sharedSteps = bounds[d];
+                    break;
                 }
-                logEdit->append("----");
-            }
-
-            if (topoInfoLabel) {
-                topoInfoLabel->setText(QString("拓扑序列：共 %1 条，当前 %2/%1")
-                                       .arg((int)mAllTopoOrders.size())
-                                       .arg(mTopoOrderPlaying + 1));
             }
+        }
+    }
 
-            // 下一次播放 -> 下一条序列
-            mTopoOrderCursor++;
+    // 第 sharedSteps 步往后的步：预取好的直接重放，否则由状态机边播边算。
+    std::unique_ptr<StepSource> source;
+    if (prefetched) source = std::make_unique<StepTapeReplay>(pre.suffix);
+    else source = std::make_unique<KahnOrderStepper>(mDag, mTopoRes.order, shared);
+
+    std::shared_ptr<StepTape> tape;
+    if (shared >= 0) {
+        tape = std::make_shared<StepTape>(std::move(source), *mTopoTape, sharedSteps);
+        view->branchTimeline(int(sharedSteps), tape);
+    } else {
+        // 每条序列开始前：清理上一次的 Topo 状态（保留 SCC 颜色）。
+        view->applyStep({StepType::ResetVisual, -1, -1, -1, 0, QString("开始新的拓扑序列")});
+        tape = std::make_shared<StepTape>(std::move(source));
+        view->loadTimeline(tape);
+    }
+    mTopoTape = tape;
 
-            // 有了 steps 才允许单步。
-            if (nextBtn) nextBtn->setEnabled(!mSteps.isEmpty());
+    // 让后台接着准备后面几条：用上了预取结果时工作线程本来就在往后做，否则从这一条之后重新开始。
+    if (!prefetched) {
+        if (!mPrefetchDag) mPrefetchDag = std::make_shared<const Graph>(mDag);
+        mOrderPrefetch.start(mPrefetchDag, &mTopoRank, mTopoOrderCursor + 1, mTopoRes.order, mTopoOrderCursor,
+                             kPrefetchAhead);
+    }
+    mStepIndex = view->timeline().position();
+
+    // 日志：显示正在播放的拓扑序列
+    if (mLog) {
+        mLog->resetTrace(stepTotal(), [tape](int i) {
+            Step s = tape->stepAt(std::size_t(i));
+            s.note = stepNote(s, TraceAlgorithm::KahnOrder);
+            return s;
+        });
+        mLog->appendText(QString("Topo 演示：DAG n=%1, m=%2")
+                          .arg(mDag.n).arg(mDag.edges.size()));
+        mLog->appendText(QString("当前演示：第 %1/%2 条拓扑序列")
+                          .arg(mTopoOrderPlaying + 1)
+                          .arg(topoCountText()));
+        if (mTopoRes.ok) {
+            QStringList seq;
+            for (int x : mTopoRes.order) seq << QString::number(x);
+            mLog->appendText(QString("本次序列：%1").arg(seq.join(" ")));
+        }
+        if (shared >= 0) {
+            mLog->appendText(tr("与上一条共享前 %1 个输出：直接从第 %2 步接着演示（可往回拖动查看前缀）")
+                                 .arg(shared).arg(mStepIndex));
         }
+        mLog->appendText("----");
     }
 
-    if (mSteps.isEmpty()) return;
+    updateTopoInfo();
+    if (topoList) topoList->setCurrentRow(mTopoOrderPlaying);
+
+    // 下一次播放 -> 下一条序列
+    mTopoOrderCursor++;
+
+    // 有了 steps 才允许单步/拖动。
+    updateStepUI();
+    return true;
+}
+
+void MainWindow::onPlayPause()
+{
+    // Topo 模式：每次“开始播放”（非播放状态下）若当前没有可播放步骤，则先生成 1 条拓扑序列的 steps。
+    if (mAlgoMode == AlgoMode::TopoKahn && !mPlaying) {
+        const bool needNewSeq = stepTotal() == 0 || (mStepIndex >= stepTotal());
+        if (needNewSeq && !loadTopoOrder()) return;
+    }
+
+    if (stepTotal() == 0) return;
 
     mPlaying = !mPlaying;
     playBtn->setText(mPlaying ? "暂停" : "播放");
 
-    if (mPlaying) mPlayTimer.start();
-    else mPlayTimer.stop();
+    if (mPlaying) {
+        mStepCarry = 0.0;
+        mPlayClock.start();
+        mPlayTimer.start();
+    } else {
+        mPlayTimer.stop();
+    }
 }
 
 void MainWindow::onNextStep()
 {
-    if (mSteps.isEmpty()) return;
-    if (mStepIndex >= mSteps.size()) return;
+    advanceSteps(1);
+}
+
+void MainWindow::advanceSteps(int count, int timeBudgetMs)
+{
+    const int total = stepTotal();
+    if (total == 0 || count <= 0) return;
+    if (mStepIndex >= total) return;
+    TRACE_SCOPE("MainWindow::advanceSteps");
+
+    const int from = mStepIndex;
+
+    if (timeBudgetMs > 0) {
+        // “尽可能快”：按块推进直到用完本帧的时间预算。
+        constexpr int kChunk = 4096;
+        QElapsedTimer budget;
+        budget.start();
+        int pos = from;
+        while (pos < total && pos - from < count && budget.elapsed() < timeBudgetMs) {
+            pos = std::min(total, pos + std::min(kChunk, count - (pos - from)));
+            view->timelineSeek(pos);
+        }
+    } else {
+        view->timelineSeek(static_cast<int>(std::min<qint64>(total, qint64(from) + count)));
+    }
 
-    const Step& st = mSteps[mStepIndex++];
-    view->applyStep(st);
+    mStepIndex = view->timeline().position();
+    if (mLog) mLog->appendSteps(from, mStepIndex);
+    updateStepUI();
 
-    if (logEdit && !st.note.isEmpty()) logEdit->append(st.note);
+    // 结束条件（边播边算时，算法若比预计的先结束，总步数会在这里缩到实际值）。
+    if (mStepIndex >= stepTotal()) onStepsFinished();
+}
+
+void MainWindow::onPrevStep()
+{
+    if (stepTotal() == 0) return;
 
-    // 结束条件。
-    if (mStepIndex >= mSteps.size()) {
+    // 回退时暂停自动播放，否则下一 tick 又会往前走。
+    if (mPlaying) {
         mPlaying = false;
         mPlayTimer.stop();
-        playBtn->setText(mAlgoMode == AlgoMode::TopoKahn ? tr("播放下一条") : tr("播放"));
-
-        if (mAlgoMode == AlgoMode::TopoKahn) {
-            // 汇总输出最终拓扑序。
-            if (logEdit) {
-                logEdit->append("----");
-                if (mTopoRes.ok) {
-                    QStringList seq;
-                    for (int x : mTopoRes.order) seq << QString::number(x);
-                    logEdit->append(QString("本次拓扑序（确认）：%1").arg(seq.join(" ")));
-                } else {
-                    logEdit->append("拓扑失败：图中存在环（输出序列长度 < n）。");
-                }
-                logEdit->append(tr("提示：再次点击“播放下一条”，将生成并演示下一条拓扑序列。"));
+    }
+    if (!view->timelineBackward()) return;
+
+    mStepIndex = view->timeline().position();
+    if (mLog) mLog->appendText(QString("⟵ 回退到第 %1/%2 步").arg(mStepIndex).arg(stepTotal()));
+    playBtn->setText(tr("播放"));
+    updateStepUI();
+}
+
+void MainWindow::onSeekStep(int pos)
+{
+    const int total = stepTotal();
+    if (total == 0) return;
+
+    const bool wasAtEnd = (mStepIndex >= total);
+    view->timelineSeek(pos);
+    mStepIndex = view->timeline().position();
+
+    if (mLog) {
+        mLog->appendText(QString("⇥ 跳转到第 %1/%2 步").arg(mStepIndex).arg(total));
+        mLog->appendSteps(mStepIndex - 1, mStepIndex);
+    }
+    updateStepUI();
+
+    if (mStepIndex >= total) {
+        if (!wasAtEnd) onStepsFinished();
+    } else if (!mPlaying) {
+        playBtn->setText(tr("播放"));
+    }
+}
+
+void MainWindow::updateStepUI()
+{
+    const int total = view ? view->timeline().size() : 0;
+    const int pos = view ? view->timeline().position() : 0;
+
+    if (stepSlider) {
+        // 程序性更新不应再触发 onSeekStep。
+        QSignalBlocker block(stepSlider);
+        stepSlider->setRange(0, total);
+        stepSlider->setValue(pos);
+        stepSlider->setEnabled(total > 0);
+    }
+    if (stepLabel) stepLabel->setText(QString("%1 / %2").arg(pos).arg(total));
+    if (prevBtn) prevBtn->setEnabled(pos > 0);
+    if (nextBtn) nextBtn->setEnabled(total > 0 && pos < total);
+}
+
+void MainWindow::onStepsFinished()
+{
+    mPlaying = false;
+    mPlayTimer.stop();
+    playBtn->setText(mAlgoMode == AlgoMode::TopoKahn ? tr("播放下一条") : tr("播放"));
+
+    if (mAlgoMode == AlgoMode::TopoKahn) {
+        // 汇总输出最终拓扑序。
+        if (mLog) {
+            mLog->appendText("----");
+            if (mTopoRes.ok) {
+                QStringList seq;
+                for (int x : mTopoRes.order) seq << QString::number(x);
+                mLog->appendText(QString("本次拓扑序（确认）：%1").arg(seq.join(" ")));
+            } else {
+                mLog->appendText("拓扑失败：图中存在环（输出序列长度 < n）。");
             }
-            statusBar()->showMessage("拓扑步骤播放完成", 2000);
-        } else {
-            statusBar()->showMessage("SCC 步骤播放完成", 2000);
+            mLog->appendText(tr("提示：再次点击“播放下一条”，将生成并演示下一条拓扑序列。"));
         }
+        statusBar()->showMessage("拓扑步骤播放完成", 2000);
+    } else if (mAlgoMode == AlgoMode::Recorded) {
+        statusBar()->showMessage(tr("步骤文件回放完成"), 2000);
+    } else {
+        statusBar()->showMessage("SCC 步骤播放完成", 2000);
     }
 }
 
 void MainWindow::onPlayTick()
 {
     if (!mPlaying) return;
-    onNextStep();
+
+    const qint64 elapsedMs = mPlayClock.restart();
+    if (mStepsPerSecond <= 0) {
+        // 尽可能快：每帧给算法/重绘留出大约半帧的时间，剩下的交给事件循环去绘制。
+        advanceSteps(std::numeric_limits<int>::max(), 8);
+        return;
+    }
+
+    mStepCarry += elapsedMs * mStepsPerSecond / 1000.0;
+    const int due = static_cast<int>(std::min(mStepCarry, 1e9));
+    if (due <= 0) return;
+    mStepCarry -= due;
+    advanceSteps(due);
 }
 
 void MainWindow::onResetAlgo()
@@ -803,32 +1540,647 @@ void MainWindow::onResetAlgo()
     mPlaying = false;
     if (playBtn) playBtn->setText("播放");
 
-    mSteps.clear();
     mStepIndex = 0;
     mAlgoMode = AlgoMode::None;
     mTopoRes = TopoResult();
+    mTopoTape.reset();
 
-    // 回放层面的“当前序列指针”复位（不强制清空 mAllTopoOrders，方便用户仅重播）。
+    // 回放层面的“当前序列指针”复位（不清空 mTopoRank，方便用户仅重播）。
     mTopoOrderCursor = 0;
-    mTopoOrderPlaying = -1;
-    if (topoInfoLabel) {
-        if (mTopoOrdersReady && !mAllTopoOrders.empty()) {
-            topoInfoLabel->setText(QString("拓扑序列：共 %1 条，当前 0/%1（未播放）")
-                                   .arg((int)mAllTopoOrders.size()));
-        } else {
-            topoInfoLabel->setText(tr("拓扑序列：未生成"));
-        }
-    }
+    mTopoOrderPlaying = kNoOrder;
+    updateTopoInfo();
+    if (topoList) topoList->setCurrentRow(OrderListView::kNoRow);
 
-    if (logEdit) logEdit->clear();
+    if (mLog) mLog->clear();
     if (view) view->applyStep({StepType::ResetVisual, -1, -1, -1, 0, QString()});
 
     if (playBtn) playBtn->setEnabled(false);
-    if (nextBtn) nextBtn->setEnabled(false);
     if (resetAlgoBtn) resetAlgoBtn->setEnabled(false);
+    updateStepUI();
+}
+
+void MainWindow::onSaveStepTrace()
+{
+    // 只有现算出来的步骤可存（回放文件时不必再存一遍）。
+    const bool onDag = (mAlgoMode == AlgoMode::TopoKahn);
+    if (stepTotal() == 0 || (mAlgoMode != AlgoMode::TarjanSCC && !(onDag && mTopoOrderPlaying != kNoOrder))) {
+        statusBar()->showMessage(tr("当前没有可保存的步骤：先运行 SCC，或播放一条拓扑序列"), 3000);
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, tr("保存步骤"), QString("steps.topostep"),
+                                                      tr("步骤文件 (*.topostep)"));
+    if (path.isEmpty()) return;
+
+    StepTraceHeader header;
+    header.algorithm = onDag ? TraceAlgorithm::KahnOrder : TraceAlgorithm::TarjanScc;
+    const Graph& g = onDag ? mDag : mGraph;
+    header.n = g.n;
+    header.fingerprint = graphFingerprint(g);
+    if (onDag) header.orderIndex = mTopoOrderPlaying;
+
+    QSaveFile file(path);
+    std::uint64_t written = 0;
+    bool ok = file.open(QIODevice::WriteOnly);
+    if (ok) {
+        StepTraceWriter writer([&file](const char* data, std::size_t len) {
+            return file.write(data, qint64(len)) == qint64(len);
+        });
+        writer.begin(header);
+        // 回放是边播边算的，这里把同一个算法从头跑一遍直接写进文件，与播到哪里无关。
+        if (onDag) TopoKahn().runWithOrder(mDag, mTopoRes.order, &writer);
+        else TarjanSCC().run(mGraph, nullptr, &writer);
+        written = writer.written();
+        ok = writer.flush() && file.commit();
+    }
+    if (!ok) {
+        QMessageBox::warning(this, tr("导出失败"), file.errorString());
+        return;
+    }
+    statusBar()->showMessage(tr("已保存 %1 步到 %2").arg(written).arg(path), 4000);
+}
+
+void MainWindow::onOpenStepTrace()
+{
+    if (mTaskThread) {
+        statusBar()->showMessage(tr("后台任务进行中，请稍候"), 2000);
+        return;
+    }
+    const QString path = QFileDialog::getOpenFileName(this, tr("打开步骤文件"), QString(),
+                                                      tr("步骤文件 (*.topostep);;所有文件 (*)"));
+    if (path.isEmpty()) return;
+
+    auto trace = std::make_shared<MappedStepTrace>();
+    QString error;
+    if (!trace->open(path, error)) {
+        QMessageBox::warning(this, tr("打开失败"), error);
+        return;
+    }
+
+    // Tarjan 的 trace 放在原图上回放，Kahn 的放在缩点 DAG 上（需要先有 SCC 结果）。
+    if (trace->reader.header().algorithm == TraceAlgorithm::TarjanScc) {
+        if (mShowingDag) onShowOriginal();
+        playStepTrace(trace, path);
+        return;
+    }
+    if (!mHasScc) {
+        statusBar()->showMessage(tr("这是 DAG 上的拓扑排序步骤：请先运行 SCC (Tarjan)"), 3000);
+        return;
+    }
+    if (mShowingDag) {
+        playStepTrace(trace, path);
+    } else {
+        showDagThen([this, trace, path]() { if (mShowingDag) playStepTrace(trace, path); });
+    }
+}
+
+void MainWindow::playStepTrace(const std::shared_ptr<MappedStepTrace>& trace, const QString& path)
+{
+    const StepTraceHeader& header = trace->reader.header();
+    const bool onDag = (header.algorithm != TraceAlgorithm::TarjanScc);
+    const Graph& g = onDag ? mDag : mGraph;
+
+    // trace 只记点编号，换一张图回放会着错色甚至越界：节点数和指纹都对上才放。
+    if (header.n != g.n || header.fingerprint != graphFingerprint(g)) {
+        QMessageBox::warning(this, tr("打开失败"),
+                             tr("步骤文件录制时的%1与当前显示的不一致（文件 n=%2，当前 n=%3）。")
+                                 .arg(onDag ? tr("缩点 DAG") : tr("图")).arg(header.n).arg(g.n));
+        return;
+    }
+    const std::uint64_t count = trace->reader.count();
+    if (count > std::uint64_t(std::numeric_limits<int>::max())) {
+        QMessageBox::warning(this, tr("打开失败"), tr("步骤数超出进度条能表示的范围（%1 步）。").arg(count));
+        return;
+    }
+
+    mPlayTimer.stop();
+    mPlaying = false;
+    mStepIndex = 0;
+    mTopoRes = TopoResult();
+    mTopoTape.reset();
+    mTopoOrderPlaying = kNoOrder;
+    mAlgoMode = AlgoMode::Recorded;
+
+    // 与现算时一样从干净的状态开始：原图上连 SCC 着色一起清掉，DAG 上保留调色板。
+    view->applyStep({StepType::ResetVisual, -1, -1, -1, onDag ? 0 : 1, QString()});
+    view->loadTimeline(std::make_shared<MappedTraceSource>(trace));
+
+    if (mLog) {
+        const TraceAlgorithm algo = header.algorithm;
+        mLog->resetTrace(int(count), [trace, algo](int i) {
+            Step s = trace->reader.stepAt(std::uint64_t(i));
+            s.note = stepNote(s, algo);
+            return s;
+        });
+        mLog->appendText(tr("步骤文件 %1：%2，n=%3，共 %4 步")
+                             .arg(QFileInfo(path).fileName())
+                             .arg(onDag ? tr("拓扑排序 (Kahn)") : tr("Tarjan SCC"))
+                             .arg(header.n).arg(count));
+        if (header.orderIndex != StepTraceHeader::kNoOrderIndex)
+            mLog->appendText(tr("录制的是第 %1 条拓扑序列").arg(header.orderIndex + 1));
+        mLog->appendText("----");
+    }
+
+    playBtn->setEnabled(count > 0);
+    playBtn->setText(tr("播放"));
+    resetAlgoBtn->setEnabled(true);
+    updateStepUI();
+    statusBar()->showMessage(tr("已打开步骤文件，共 %1 步").arg(count), 2500);
+}
+
+void MainWindow::clearTopoOrders()
+{
+    mOrderPrefetch.stop();
+    mPrefetchDag.reset();
+    mTopoRank.clear();
+    mOrderDag = Graph();
+    mTopoOrderCursor = 0;
+    mTopoOrderPlaying = kNoOrder;
+    mTopoOrdersReady = false;
+    if (topoInfoLabel) topoInfoLabel->setText(tr("拓扑序列：未生成"));
+    closeOrderFile();
+    if (topoList) topoList->clear();
+    if (topoJumpBtn) topoJumpBtn->setEnabled(false);
+    if (topoExportBtn) topoExportBtn->setEnabled(false);
+    if (topoShardBtn) topoShardBtn->setEnabled(false);
+}
+
+QString MainWindow::formatOrderRow(quint64 index, const std::vector<int>& order)
+{
+    QStringList seq;
+    for (int x : order) seq << QString::number(x);
+    return QString("%1) %2").arg(index + 1).arg(seq.join(" "));
+}
+
+void MainWindow::onExportOrders()
+{
+    if (!mTopoOrdersReady) return;
+
+    QString path;
+    OrderFormat format = OrderFormat::Text;
+    if (!askExportTarget(tr("导出全部拓扑序列"), path, format)) return;
+
+    // 已有文件：默认续写（从文件里最后一条完整记录之后接着枚举），也可以覆盖。
+    bool resume = false;
+    if (QFile::exists(path)) {
+        QMessageBox box(QMessageBox::Question, tr("文件已存在"),
+                        tr("“%1”已存在。\n续写：从文件中最后一条完整序列之后继续；覆盖：从头重新导出。").arg(path),
+                        QMessageBox::NoButton, this);
+        QPushButton* resumeBtn = box.addButton(tr("续写"), QMessageBox::AcceptRole);
+        QPushButton* overwriteBtn = box.addButton(tr("覆盖"), QMessageBox::DestructiveRole);
+        box.addButton(QMessageBox::Cancel);
+        box.exec();
+        if (box.clickedButton() == resumeBtn) resume = true;
+        else if (box.clickedButton() != overwriteBtn) return;
+    }
+
+    // 浏览中的文件就是要写的文件：先解除映射。
+    if (mOrderFile && QFileInfo(mOrderFile->fileName()) == QFileInfo(path)) {
+        closeOrderFile();
+        if (topoList) topoList->clear();
+    }
+
+    struct ExportStats {
+        QString error;
+        quint64 total = 0;      // 文件里的总条数
+        quint64 added = 0;      // 本次新写的条数
+        quint64 bytes = 0;      // 本次写出的字节数
+        qint64 ms = 0;
+    };
+    auto dag = std::make_shared<Graph>(mOrderDag);
+    auto stats = std::make_shared<ExportStats>();
+
+    auto report = [this, stats, path](bool complete) {
+        if (!stats->error.isEmpty()) {
+            QMessageBox::warning(this, tr("导出失败"), stats->error);
+            return;
+        }
+        const double sec = std::max<qint64>(1, stats->ms) / 1000.0;
+        const QString msg = tr("%1：共 %2 条（本次 %3 条），写出 %4 MB，%5 条/秒，%6 MB/秒%7")
+                                .arg(complete ? tr("导出完成") : tr("导出已中止"))
+                                .arg(stats->total).arg(stats->added)
+                                .arg(stats->bytes / 1048576.0, 0, 'f', 1)
+                                .arg(stats->added / sec, 0, 'f', 0)
+                                .arg(stats->bytes / 1048576.0 / sec, 0, 'f', 1)
+                                .arg(complete ? QString() : tr("（已存检查点，可再次导出到同一文件续写）"));
+        if (mLog) mLog->appendText(QString("%1 -> %2").arg(msg, path));
+        statusBar()->showMessage(msg, 5000);
+    };
+
+    runTask(tr("导出拓扑序列"), [dag, stats, path, format, resume](TaskControl& ctl) {
+        QFile file(path);
+        if (!file.open(resume ? QIODevice::ReadWrite : (QIODevice::WriteOnly | QIODevice::Truncate))) {
+            stats->error = QObject::tr("无法打开文件：%1").arg(file.errorString());
+            return;
+        }
+
+        // 续写优先用检查点：它记着枚举器的完整状态和当时文件的长度，截断到那里直接接着跑，
+        // 不必把可能很大的文件再扫一遍；没有检查点（或和当前 DAG 对不上）才退回扫文件。
+        const QString ckptPath = path + ".ckpt";
+        TopoEnumerator it;
+        it.reset(*dag);
+        std::vector<int> last;
+        quint64 already = 0;
+        bool positioned = false;
+        if (resume) {
+            qint64 fileBytes = 0;
+            if (loadExportCheckpoint(ckptPath, format, it, fileBytes) && fileBytes <= file.size()) {
+                already = it.emitted();
+                file.resize(already > 0 ? fileBytes : 0);   // 一条都没有时连文件头一起重写
+                last = it.order();
+                positioned = true;
+            } else {
+                it.reset(*dag);
+            }
+        } else {
+            QFile::remove(ckptPath);
+        }
+
+        // 扫文件：读出已有的完整记录数与最后一条，截掉尾部不完整的半条。
+        if (resume && !positioned && file.size() > 0) {
+            const qint64 size = file.size();
+            uchar* data = file.map(0, size);
+            OrderReader reader;
+            const bool ok = data && reader.open(data, std::size_t(size), &ctl);
+            if (ok && reader.count() > 0) {
+                if (reader.format() != format || reader.nodeCount() != dag->n) {
+                    stats->error = QObject::tr("已有文件的格式或节点数与当前 DAG 不一致，不能续写。");
+                } else {
+                    already = reader.count();
+                    reader.orderAt(already - 1, last);
+                }
+            }
+            const qint64 valid = qint64(already > 0 ? reader.validBytes() : 0);
+            if (data) file.unmap(data);
+            if (!ok || !stats->error.isEmpty()) {
+                if (stats->error.isEmpty()) stats->error = QObject::tr("无法读取已有文件。");
+                return;
+            }
+            if (already > 0 && !it.seekAfter(last, already - 1)) {
+                stats->error = QObject::tr("已有文件的最后一条不是当前 DAG 的拓扑序列，不能续写。");
+                return;
+            }
+            file.resize(valid);
+        }
+        file.seek(file.size());
+
+        OrderWriter writer(format, dag->n, [&file](const char* data, std::size_t len) {
+            return file.write(data, qint64(len)) == qint64(len);
+        });
+        if (already == 0) writer.begin();
+        else writer.resume(already, last);
+
+        // 定期存检查点：回调前 writer 已 flush，这里再把 QFile 的缓冲刷下去，文件长度才作数。
+        auto checkpoint = [&file, ckptPath, format](const TopoEnumerator& e) {
+            return file.flush() && saveExportCheckpoint(ckptPath, format, e, file.size());
+        };
+
+        QElapsedTimer clock;
+        clock.start();
+        TopoKahn topo;
+        stats->added = topo.streamFrom(it, writer, &ctl, checkpoint, std::chrono::seconds(10));
+        writer.flush();
+        file.flush();
+        stats->ms = clock.elapsed();
+        stats->total = writer.written();
+        stats->bytes = writer.bytesOut();
+        if (it.finished() && !writer.failed()) QFile::remove(ckptPath);
+        if (writer.failed()) stats->error = QObject::tr("写文件失败：%1").arg(file.errorString());
+    }, [report]() {
+        report(true);
+    }, [report]() {
+        report(false);
+    });
+}
+
+bool MainWindow::askExportTarget(const QString& title, QString& path, OrderFormat& format,
+                                 bool confirmOverwrite)
+{
+    QString filter;
+    const QString textFilter = tr("文本，每行一条 (*.txt)");
+    const QString binFilter = tr("二进制定长记录 (*.topo)");
+    const QString deltaFilter = tr("前缀差分压缩 (*.topod)");
+    path = QFileDialog::getSaveFileName(
+        this, title, QString(), QStringList{textFilter, binFilter, deltaFilter}.join(";;"), &filter,
+        confirmOverwrite ? QFileDialog::Options() : QFileDialog::DontConfirmOverwrite);
+    if (path.isEmpty()) return false;
+
+    format = OrderFormat::Text;
+    if (filter == binFilter || path.endsWith(".topo")) format = OrderFormat::Binary;
+    if (filter == deltaFilter || path.endsWith(".topod")) format = OrderFormat::Delta;
+    return true;
+}
+
+void MainWindow::onShardExport()
+{
+    if (!mTopoOrdersReady) return;
+
+    QString path;
+    OrderFormat format = OrderFormat::Binary;
+    if (!askExportTarget(tr("多进程分片导出"), path, format, true)) return;
+    bool ok = false;
+    const int processes = QInputDialog::getInt(this, tr("多进程分片导出"), tr("同时运行的子进程数："),
+                                               std::max(1, QThread::idealThreadCount()), 1, 256, 1, &ok);
+    if (!ok) return;
+
+    if (mOrderFile && QFileInfo(mOrderFile->fileName()) == QFileInfo(path)) {
+        closeOrderFile();
+        if (topoList) topoList->clear();
+    }
+
+    auto job = std::make_shared<ShardJob>();
+    job->dag = mOrderDag;
+    job->format = format;
+    job->outPath = path;
+    job->program = QCoreApplication::applicationFilePath();
+    job->processes = processes;
+    auto report = std::make_shared<ShardReport>();
+
+    // 能精确计数时用精确的子树大小来切片，否则随机路径估计。
+    // 后台任务运行期间拓扑面板被锁住，mTopoRank 不会被改动，只读访问是安全的。
+    const TopoRank* rank = (mTopoRank.counted() && !mTopoRank.saturated()) ? &mTopoRank : nullptr;
+
+    runTask(tr("分片导出"), [job, report, rank](TaskControl& ctl) {
+        ShardPlanner planner;
+        planner.reset(job->dag);
+        ShardPlanner::Estimator exact;
+        if (rank) {
+            exact = [rank](const std::vector<int>& prefix) {
+                return std::log(double(rank->countWithPrefix(prefix)));
+            };
+        }
+        // 片数取进程数的 4 倍：估计有偏差时，先跑完的进程可以接着领后面的片。
+        job->shards = planner.plan(job->processes * 4, exact, &ctl);
+        if (job->shards.empty()) return;
+        runShardedExport(*job, ctl, *report);
+    }, [this, job, report]() {
+        if (!report->error.isEmpty()) {
+            QMessageBox::warning(this, tr("分片导出失败"), report->error);
+            return;
+        }
+        const double sec = std::max<qint64>(1, report->enumerateMs + report->mergeMs) / 1000.0;
+        const QString msg = tr("分片导出完成：%1 片 / %2 个进程，共 %3 条，%4 MB；枚举 %5 秒，合并 %6 秒，%7 条/秒")
+                                .arg(job->shards.size()).arg(job->processes).arg(report->total)
+                                .arg(report->bytes / 1048576.0, 0, 'f', 1)
+                                .arg(report->enumerateMs / 1000.0, 0, 'f', 1)
+                                .arg(report->mergeMs / 1000.0, 0, 'f', 1)
+                                .arg(report->total / sec, 0, 'f', 0);
+        if (mLog) {
+            mLog->appendText(QString("%1 -> %2").arg(msg, job->outPath));
+            quint64 start = 0;
+            for (std::size_t i = 0; i < job->shards.size(); ++i) {
+                mLog->appendText(tr("  第 %1 片 前缀 [%2]：全局下标 %3 起，%4 条（估计 %5）")
+                                     .arg(i + 1)
+                                     .arg(QString::fromStdString(ShardPlanner::prefixToString(job->shards[i].prefix)))
+                                     .arg(start + 1).arg(report->counts[i])
+                                     .arg(std::exp(job->shards[i].logEstimate), 0, 'g', 4));
+                start += report->counts[i];
+            }
+        }
+        statusBar()->showMessage(msg, 5000);
+    });
+}
+
+// 检查点文件：格式 + 存档时输出文件的长度 + TopoEnumerator::saveState()。
+// 用 QSaveFile 先写临时文件再改名，中途崩溃也不会留下半个检查点。
+bool MainWindow::saveExportCheckpoint(const QString& path, OrderFormat format,
+                                      const TopoEnumerator& it, qint64 fileBytes)
+{
+    const std::string state = it.saveState();
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    QDataStream ds(&out);
+    ds << quint32(kCheckpointMagic) << quint8(format) << qint64(fileBytes)
+       << QByteArray(state.data(), int(state.size()));
+    return ds.status() == QDataStream::Ok && out.commit();
+}
+
+bool MainWindow::loadExportCheckpoint(const QString& path, OrderFormat format,
+                                      TopoEnumerator& it, qint64& fileBytes)
+{
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    QDataStream ds(&in);
+    quint32 magic = 0;
+    quint8 fmt = 0;
+    QByteArray state;
+    ds >> magic >> fmt >> fileBytes >> state;
+    if (ds.status() != QDataStream::Ok || magic != kCheckpointMagic || fmt != quint8(format)) return false;
+    return it.loadState(reinterpret_cast<const std::uint8_t*>(state.constData()), std::size_t(state.size()));
+}
+
+void MainWindow::onOpenOrderFile()
+{
+    const QString path = QFileDialog::getOpenFileName(
+        this, tr("浏览导出的拓扑序列"), QString(),
+        tr("拓扑序列文件 (*.txt *.topo *.topod);;所有文件 (*)"));
+    if (path.isEmpty()) return;
+
+    closeOrderFile();
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, tr("打开失败"), file->errorString());
+        return;
+    }
+    // 整个文件映射进地址空间：只有真正滚到的那几页会被读盘，多大的文件都不占堆内存。
+    const qint64 size = file->size();
+    uchar* data = (size > 0) ? file->map(0, size) : nullptr;
+    if (!data) {
+        QMessageBox::warning(this, tr("打开失败"), tr("文件为空或无法映射到内存。"));
+        return;
+    }
+    mOrderFile = std::move(file);
+    mOrderMap = data;
+
+    // 建索引要把文件扫一遍（Binary 除外），放到后台。
+    auto reader = std::make_shared<OrderReader>();
+    auto ok = std::make_shared<bool>(false);
+    runTask(tr("读取导出文件"), [reader, ok, data, size](TaskControl& ctl) {
+        *ok = reader->open(data, std::size_t(size), &ctl);
+    }, [this, reader, ok, path]() {
+        if (!*ok) {
+            closeOrderFile();
+            QMessageBox::warning(this, tr("打开失败"), tr("无法识别的文件格式。"));
+            return;
+        }
+        mOrderReader = reader;
+        if (topoList) {
+            topoList->setSource(reader->count(), [reader](quint64 i) {
+                std::vector<int> order;
+                reader->orderAt(i, order);
+                return formatOrderRow(i, order);
+            });
+        }
+        if (topoJumpBtn) topoJumpBtn->setEnabled(reader->count() > 0);
+
+        static const char* kFormatNames[] = {"文本", "二进制", "前缀差分"};
+        const QString info = tr("文件 %1：%2格式，n=%3，共 %4 条")
+                                 .arg(QFileInfo(path).fileName())
+                                 .arg(tr(kFormatNames[int(reader->format())]))
+                                 .arg(reader->nodeCount())
+                                 .arg(reader->count());
+        if (topoInfoLabel) topoInfoLabel->setText(info);
+        statusBar()->showMessage(info, 3000);
+    }, [this]() {
+        closeOrderFile();
+    });
+}
+
+void MainWindow::closeOrderFile()
+{
+    mOrderReader.reset();
+    if (mOrderFile) {
+        if (mOrderMap) mOrderFile->unmap(mOrderMap);
+        mOrderFile->close();
+    }
+    mOrderMap = nullptr;
+    mOrderFile.reset();
+}
+
+QString MainWindow::topoCountText() const
+{
+    if (mTopoRank.saturated()) return tr("超过 %1").arg(mTopoRank.count());
+    if (!mTopoRank.counted()) return tr("至少 %1（图太大无法计数，只列出前 %1 条）").arg(mTopoRank.count());
+    return QString::number(mTopoRank.count());
+}
+
+void MainWindow::updateTopoInfo()
+{
+    if (!topoInfoLabel) return;
+    if (!mTopoOrdersReady) {
+        topoInfoLabel->setText(tr("拓扑序列：未生成"));
+    } else if (mTopoOrderPlaying == kNoOrder) {
+        topoInfoLabel->setText(QString("拓扑序列：共 %1 条，当前 0（未播放）").arg(topoCountText()));
+    } else {
+        topoInfoLabel->setText(QString("拓扑序列：共 %1 条，当前第 %2 条")
+                               .arg(topoCountText()).arg(mTopoOrderPlaying + 1));
+    }
+}
+
+void MainWindow::onJumpToOrder()
+{
+    if (!topoList || !topoJumpEdit || topoList->count() == 0) return;
+    bool ok = false;
+    const quint64 k = topoJumpEdit->text().toULongLong(&ok);
+    if (!ok || k == 0 || k > topoList->count()) {
+        statusBar()->showMessage(QString("序号超出范围（1 ~ %1）").arg(topoList->count()), 2000);
+        return;
+    }
+    topoList->scrollToRow(k - 1);
+    topoList->setFocus();
+}
+
+void MainWindow::onPlayOrder(quint64 index)
+{
+    if (mOrderReader) {
+        statusBar()->showMessage(tr("文件中的序列仅供浏览；重新“开始拓扑排序”后可双击演示"), 2500);
+        return;
+    }
+    if (!mTopoOrdersReady || mAlgoMode != AlgoMode::TopoKahn) return;
+
+    // 换成新游标对应的序列（与当前这条共享前缀时沿用前缀），然后开始播放。
+    mPlayTimer.stop();
+    mPlaying = false;
+    mTopoOrderCursor = index;
+    if (loadTopoOrder()) onPlayPause();
+}
+
+void MainWindow::runTask(const QString& title,
+                         std::function<void(TaskControl&)> work,
+                         std::function<void()> done,
+                         std::function<void()> stopped)
+{
+    if (mTaskThread) {
+        statusBar()->showMessage(tr("后台任务“%1”还在运行").arg(mTaskTitle), 2000);
+        return;
+    }
+
+    // 新结果回来后旧的回放就不再匹配，先停掉。
+    mPlayTimer.stop();
+    mPlaying = false;
+    if (playBtn) playBtn->setText("播放");
+
+    auto ctl = std::make_shared<TaskControl>();
+    ctl->setTimeBudget(taskTimeSpin->value() * 1000);
+    ctl->setMemoryBudget(std::size_t(taskMemSpin->value()) << 20);
+    mTask = ctl;
+    mTaskTitle = title;
+
+    QThread* thread = QThread::create([ctl, work]() {
+        work(*ctl);
+        ctl->finish();
+    });
+    // enumerateAll 是递归 DFS，深度可达 n；后台线程的默认栈（Windows 上 1MB）不够。
+    thread->setStackSize(kTaskStackSize);
+    mTaskThread = thread;
+
+    connect(thread, &QThread::finished, this, [this, thread, ctl, title, done, stopped]() {
+        thread->deleteLater();
+        mTaskThread = nullptr;
+        mTask.reset();
+        mTaskPoll.stop();
+        setTaskBusy(false);
+
+        QString msg;
+        switch (ctl->status()) {
+        case TaskControl::Status::Done:
+            msg = tr("%1：完成（%2 ms）").arg(title).arg(mTaskClock.elapsed());
+            break;
+        case TaskControl::Status::Cancelled:
+            msg = tr("%1：已取消").arg(title);
+            break;
+        case TaskControl::Status::TimedOut:
+            msg = tr("%1：超出时间上限，已停止").arg(title);
+            break;
+        case TaskControl::Status::OutOfMemory:
+            msg = tr("%1：超出内存上限，已停止").arg(title);
+            break;
+        default:
+            break;
+        }
+        taskLabel->setText(msg);
+        statusBar()->showMessage(msg, 2500);
+
+        // 只有正常完成的结果才交回界面；被中止的结果一般不完整，由 stopped 决定怎么收尾。
+        if (ctl->status() == TaskControl::Status::Done) {
+            if (done) done();
+        } else if (stopped) {
+            stopped();
+        }
+    });
+
+    setTaskBusy(true);
+    mTaskClock.start();
+    mTaskPoll.start();
+    updateTaskProgress();
+    thread->start();
+}
+
+void MainWindow::setTaskBusy(bool busy)
+{
+    for (QWidget* w : mTaskLockedPanels) w->setEnabled(!busy);
+    if (mGraphDock && mGraphDock->widget()) mGraphDock->widget()->setEnabled(!busy);
+    if (taskCancelBtn) taskCancelBtn->setEnabled(busy);
+    if (taskTimeSpin) taskTimeSpin->setEnabled(!busy);
+    if (taskMemSpin) taskMemSpin->setEnabled(!busy);
+}
+
+void MainWindow::updateTaskProgress()
+{
+    if (!mTask || !taskLabel) return;
+    taskLabel->setText(tr("%1：已处理 %2 · 已找到 %3 · %4 秒")
+                       .arg(mTaskTitle)
+                       .arg(mTask->work())
+                       .arg(mTask->found())
+                       .arg(mTaskClock.elapsed() / 1000.0, 0, 'f', 1));
 }
 
 MainWindow::~MainWindow()
 {
+    // 窗口关闭时后台任务可能还在跑：请求取消并等它退出，避免线程访问已析构的对象。
+    if (mTaskThread) {
+        mTask->requestCancel();
+        mTaskThread->wait();
+        delete mTaskThread;
+    }
     delete ui;
 }
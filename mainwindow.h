@@ -11,10 +11,33 @@
 #include <QTimer>
 #include <QLabel>
 #include <QAction>
+#include <QSlider>
+#include <QComboBox>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QFile>
+#include <QListView>
+#include <QLineEdit>
+#include <QTableWidget>
+#include <QCheckBox>
 #include "Steps.h"
 #include "TarjanSCC.h"
 #include "Condense.h"
 #include "TopoKahn.h"
+#include "StepLogModel.h"
+#include "TopoRank.h"
+#include "OrderListView.h"
+#include "TaskControl.h"
+#include "OrderStream.h"
+#include "LayeredLayout.h"
+#include "MultilevelLayout.h"
+#include "StepTrace.h"
+#include "OrderPrefetcher.h"
+#include "TwinClasses.h"
+#include <functional>
+#include <memory>
+
+struct MappedStepTrace;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -42,6 +65,8 @@ QDockWidget* mGraphDock = nullptr;
 QDockWidget* mAlgoDock  = nullptr;
 QAction* mGraphDockAction = nullptr;
 QAction* mAlgoDockAction  = nullptr;
+QDockWidget* mPerfDock = nullptr;
+QAction* mPerfDockAction = nullptr;
 
 // 边统计相关的 界面
 QLabel* edgeCountLabel = nullptr;
@@ -53,6 +78,7 @@ void updateEdgeCountUI();
     void onCreateGraph();
     void onAddEdge();
     void onAddEdgesFromText();
+    void onMultilevelLayout();   // 后台算多级布局，落地后只用低温力导微调
     void onEdgeRequested(int u, int v);
 
     // 算法控制（第 4 步：Tarjan SCC 可视化）
@@ -63,11 +89,70 @@ void updateEdgeCountUI();
     // 第 6 步：在缩点 DAG 上进行拓扑排序回放（Kahn）。
     void onRunTopo();
 
+    // 上面三个阶段的计算都在后台线程跑；finish* 在界面线程接收结果。
+    void showDagThen(std::function<void()> then);   // 切到 DAG，完成后调用 then
+    void finishRunSCC(SCCResult res);
+    void finishShowDAG(Graph dag, std::vector<LayoutPoint> layout);
+    void enterDagView();               // DAG 场景已上屏（新建或从缓存换回）后的界面收尾
+    void onDagLayoutChanged();         // 切换 DAG 的布局方式（力导 / 分层）
+    bool dagLayered() const;
+    static QVector<QPointF> toScenePoints(const std::vector<LayoutPoint>& pts);
+    void finishRunTopo(TopoRank rank);
+
+    // 后台任务：work 在工作线程执行；正常完成（未取消/超时/超内存）时在界面线程调用 done，
+    // 否则调用 stopped（可为空）。同一时间只跑一个任务。
+    void runTask(const QString& title,
+                 std::function<void(TaskControl&)> work,
+                 std::function<void()> done,
+                 std::function<void()> stopped = nullptr);
+    void setTaskBusy(bool busy);
+    void updateTaskProgress();
+
     void onPlayPause();
+    bool loadTopoOrder();       // Topo 模式：把游标处的序列装上时间轴（不开始播放）
     void onNextStep();
+    void onPrevStep();
+    void onSeekStep(int pos);   // 拖动进度条跳到第 pos 步
     void onResetAlgo();
     void onPlayTick();
 
+    void updateStepUI();        // 同步进度条/步数标签/前后按钮
+    // 一次前进至多 count 步（timeBudgetMs > 0 时另受时间预算约束）：只重绘一次、日志只追加一次。
+    void advanceSteps(int count, int timeBudgetMs = -1);
+    void onStepsFinished();     // 播放到最后一步时的收尾（日志汇总、按钮文字）
+    int stepTotal() const { return view ? view->timeline().size() : 0; }   // 已装载的步数（与来源无关）
+
+    // Step trace 文件（见 StepTrace.h）：保存当前步骤；打开录好的文件直接回放，不重跑算法。
+    void onSaveStepTrace();
+    void onOpenStepTrace();
+    void playStepTrace(const std::shared_ptr<MappedStepTrace>& trace, const QString& path);
+
+    // 拓扑序列列表
+    void clearTopoOrders();            // 图/DAG 变化后作废序列计数与列表
+    QString topoCountText() const;     // “共多少条”的显示文字（超出 uint64 / 无法计数时给出说明）
+    void updateTopoInfo();
+    void onJumpToOrder();              // 跳到输入的序号
+    void onPlayOrder(quint64 index);   // 双击列表某行：立即演示这一条
+    void onExportOrders();             // 流式导出全部序列到文件（可续写）
+    void onOpenOrderFile();            // 内存映射打开导出文件，在列表里分页浏览
+    void onShardExport();              // 按前缀分片，多个子进程并行枚举后合并
+    bool askExportTarget(const QString& title, QString& path, OrderFormat& format,
+                         bool confirmOverwrite = false);
+    void closeOrderFile();
+    static QString formatOrderRow(quint64 index, const std::vector<int>& order);
+    // 导出的检查点（“文件名.ckpt”）。在工作线程里调用，不碰界面。
+    static constexpr quint32 kCheckpointMagic = 0x544f434b; // "TOCK"
+    static bool saveExportCheckpoint(const QString& path, OrderFormat format,
+                                     const TopoEnumerator& it, qint64 fileBytes);
+    static bool loadExportCheckpoint(const QString& path, OrderFormat format,
+                                     TopoEnumerator& it, qint64& fileBytes);
+
+    // 性能面板：Trace 埋点的统计表 + 导出 Chrome trace JSON。
+    void setupPerfDock();
+    void refreshPerfStats();
+    void onExportTrace();
+    void onExportFrameCsv();     // 画布帧时间直方图 -> CSV
+
 private:
     Graph mGraph;
     QVector<QPointF> mPos;
@@ -78,37 +163,95 @@ private:
     QTextEdit* edgesEdit = nullptr;
 
     // --- 算法回放状态 ---
-    QVector<Step> mSteps;
+    // 步骤本身不在这里存：现算的由算法状态机边播边产出，录好的从映射的文件里取（都挂在 view 的时间轴上）。
     int mStepIndex = 0;
     bool mPlaying = false;
     QTimer mPlayTimer;
 
-    enum class AlgoMode { None, TarjanSCC, TopoKahn };
+    // 播放速度：每秒步数，0 表示“尽可能快”。计时器固定按帧触发，
+    // 每帧按实际流逝时间折算应走的步数（小数部分累积到下一帧）。
+    int mStepsPerSecond = 4;
+    double mStepCarry = 0.0;
+    QElapsedTimer mPlayClock;
+    QComboBox* speedBox = nullptr;
+
+    // Recorded：正在回放从文件打开的 StepTrace（步骤按需从映射的文件里取）。
+    enum class AlgoMode { None, TarjanSCC, TopoKahn, Recorded };
     AlgoMode mAlgoMode = AlgoMode::None;
 
     // 最近一次拓扑排序的结果缓存（用于最终输出序列）。
     TopoResult mTopoRes;
+    // 正在演示的那条序列走过的步（日志取数用；下一条序列共享前缀时照抄它的前缀）。
+    std::shared_ptr<StepTape> mTopoTape;
 
-    // --- 生成“所有拓扑序列”相关缓存 ---
-    std::vector<std::vector<int>> mAllTopoOrders; // 全部拓扑序列（对 DAG）
-    int mTopoOrderCursor = 0;                     // 下一次播放将使用的序列下标
-    int mTopoOrderPlaying = -1;                   // 当前正在播放的序列下标（用于日志显示）
+    // --- “所有拓扑序列”：只存计数表，第 i 条按需解码（见 TopoRank） ---
+    static constexpr quint64 kNoOrder = OrderListView::kNoRow;
+    TopoRank mTopoRank;
+    Graph mOrderDag;                              // 计数/列表/导出所用的 DAG：mDag，或孪生点补链后的 DAG（演示仍在 mDag 上）
+    quint64 mTopoOrderCursor = 0;                 // 下一次播放将使用的序列下标
+    quint64 mTopoOrderPlaying = kNoOrder;         // 当前正在播放的序列下标（用于日志显示）
     bool mTopoOrdersReady = false;
 
+    // 后台预取接下来几条序列的步骤（见 OrderPrefetcher）。放在 mTopoRank 之后：析构时先停线程。
+    static constexpr int kPrefetchAhead = 3;
+    OrderPrefetcher mOrderPrefetch;
+    std::shared_ptr<const Graph> mPrefetchDag;    // 预取线程用的 DAG 副本（DAG 不变就一直复用）
+
+    // --- 后台任务 ---
+    static constexpr uint kTaskStackSize = 64u << 20;
+    std::shared_ptr<TaskControl> mTask;   // 工作线程与界面线程共享
+    QThread* mTaskThread = nullptr;
+    QString mTaskTitle;
+    QElapsedTimer mTaskClock;
+    QTimer mTaskPoll;
+    QLabel* taskLabel = nullptr;
+    QPushButton* taskCancelBtn = nullptr;
+    QSpinBox* taskTimeSpin = nullptr;
+    QSpinBox* taskMemSpin = nullptr;
+    QList<QWidget*> mTaskLockedPanels;
+
     // --- 算法相关 界面 控件 ---
     QPushButton* runSccBtn = nullptr;
     QPushButton* runTopoBtn = nullptr;
     QPushButton* playBtn = nullptr;
     QPushButton* nextBtn = nullptr;
+    QPushButton* prevBtn = nullptr;
+    QSlider* stepSlider = nullptr;
+    QLabel* stepLabel = nullptr;
     QPushButton* resetAlgoBtn = nullptr;
-    QTextEdit* logEdit = nullptr;
+
+    // 步骤日志：model/view，行只存 step 下标或一行说明文字（见 StepLogModel）。
+    StepLogModel* mLog = nullptr;
+    QListView* logView = nullptr;
+    QComboBox* logTypeBox = nullptr;
+    QLineEdit* logSearchEdit = nullptr;
+    bool mLogFollow = true;     // 日志是否跟随到底部
+
+    // 性能面板
+    QCheckBox* perfEnableBox = nullptr;
+    QTableWidget* perfTable = nullptr;
+    QLabel* perfInfoLabel = nullptr;
+    QCheckBox* overlayBox = nullptr;
+    QTimer mPerfTimer;          // 记录打开且面板可见时定期刷新统计表
 
     // 展示：所有拓扑序列（可复制），以及当前播放进度。
+    QCheckBox* topoTwinBox = nullptr;
     QLabel* topoInfoLabel = nullptr;
-    QTextEdit* topoAllEdit = nullptr;
+    OrderListView* topoList = nullptr;
+    QLineEdit* topoJumpEdit = nullptr;
+    QPushButton* topoJumpBtn = nullptr;
+    QPushButton* topoExportBtn = nullptr;
+    QPushButton* topoOpenFileBtn = nullptr;
+    QPushButton* topoShardBtn = nullptr;
+
+    // 正在浏览的导出文件（映射期间 QFile 必须保持打开）。
+    std::unique_ptr<QFile> mOrderFile;
+    uchar* mOrderMap = nullptr;
+    std::shared_ptr<OrderReader> mOrderReader;
 
     // 第 5 步 界面（切换到缩点 DAG 视图）
     QPushButton* showDagBtn = nullptr;
+    QComboBox* dagLayoutBox = nullptr;
     QPushButton* showOriBtn = nullptr;
 
     // --- 缓存的算法结果（跨阶段复用） ---
@@ -118,6 +261,10 @@ private:
     Graph mDag;                // condensed DAG
     QVector<QPointF> mPosOriginalSnapshot; // positions used to compute SCC centroids
 
+    // 版本号：图结构 / SCC 结果每变一次加一。GraphView 按它判断缓存的原图 / DAG 场景是否还能直接换回。
+    quint64 mGraphVersion = 0;
+    quint64 mSccVersion = 0;
+
     bool addEdgeImpl(int u, int v); // 统一入口
 
 };